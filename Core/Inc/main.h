@@ -46,7 +46,8 @@ extern "C" {
 
 /* Exported macro ------------------------------------------------------------*/
 /* USER CODE BEGIN EM */
-
+/* 编译期断言 (C99 无 _Static_assert, 用负长度数组触发编译错误; tag 在同一文件内唯一) */
+#define STATIC_ASSERT(cond, tag)    typedef char static_assert_##tag[(cond) ? 1 : -1]
 /* USER CODE END EM */
 
 /* Exported functions prototypes ---------------------------------------------*/
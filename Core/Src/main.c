@@ -29,9 +29,19 @@
 #include "iap_function.h"
 #include "uart_config.h"
 #include "modbus_function.h"
+#include "modbus_master.h"
+#include "stream_function.h"
+#include "command_function.h"
 #include "relay_control.h"
 #include "DigitalTube_Control.h"
+#include "param_table.h"
+#include "key_function.h"
+#include "relay_sequence.h"
+#include "sched_function.h"
 #include "Flash_Storage.h"
+#include "nvic_config.h"
+#include "perf_function.h"
+#include "delay_function.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -52,8 +62,6 @@
 /* Private variables ---------------------------------------------------------*/
 
 /* USER CODE BEGIN PV */
-uint32_t testcnt = 0;
-uint8_t errcnt = 0;
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -74,7 +82,8 @@ void SystemClock_Config(void);
 int main(void)
 {
   /* USER CODE BEGIN 1 */
-
+	// 栈区涂写填充值 (高水位统计), 须在开启中断前执行
+	Sched_StackPaint();
   /* USER CODE END 1 */
 
   /* MCU Configuration--------------------------------------------------------*/
@@ -103,36 +112,49 @@ int main(void)
   MX_USART3_UART_Init();
 	MX_TIM6_Init();
   /* USER CODE BEGIN 2 */
+	Time_Init();
+	Perf_Init();
 	uart_config();
-	Relay_AllOff();
+	Cmd_Init();
+	ModBus_MasterInit();
+	Relay_Init();
 	//dma1_channel1_config();
 	DTC_Init();
+	Key_Init();
+	RelaySeq_Init();
     // 加载 Flash 参数
     // Load_PA_From_Flash (使用新模块函数) -> 增加返回值判断
-    if (Flash_LoadParams(PA_Buffer, PA_SIZE) != 0) {
-        DTC_SetError(1); // Err.01: Flash 空或 CRC 错误
+    switch (Flash_LoadParams(PA_Buffer, PA_SIZE)) {
+        case FLASH_LOAD_EMPTY:
+            DTC_SetError(1); // Err.01: Flash 空或 CRC 错误
+            break;
+        case FLASH_LOAD_SCHEMA:
+            // 属性表已变更: 越界参数钳位后按新版本号回存
+            Param_Sanitize(PA_Buffer, PARAM_GROUP_PA, PA_SIZE);
+            Flash_SaveParams(PA_Buffer, PA_SIZE);
+            break;
+        default:
+            break;
     }
+    // 继电器动作计数 (Flash 记录流)
+    Relay_OpsInit();
+    // 按 PA 参数配置 USART1 波特率 (默认/自动检测/固定)
+    Usart1_BaudInit(PA_Buffer[PA_IDX_UART1_BAUD]);
+    // 中断优先级统一设置 (覆盖以上初始化中的默认优先级, 规划见 nvic_config.h)
+    nvic_config();
     
 	HAL_TIM_Base_Start_IT(&htim6);
   /* USER CODE END 2 */
 
   /* Infinite loop */
   /* USER CODE BEGIN WHILE */
+  // 协作式调度 (不返回): 文本命令/按键/数码管渲染/主站轮询/流发送/Flash 延迟写入均为任务, 见 sched_function.c
+  Sched_Run();
   while (1)
   {
     /* USER CODE END WHILE */
 
     /* USER CODE BEGIN 3 */
-    // 处理字符串命令
-    if(Usart1.StringFlag)
-    {
-      Usart1.StringFlag = 0;
-      Usart1_SendStringHandler();
-    }		
-		if(testcnt){
-			testcnt = 0;
-			DTC_SetError(errcnt);
-		}
   }
   /* USER CODE END 3 */
 }
@@ -25,6 +25,15 @@
 #include "uart_config.h"
 #include "modbus_function.h"
 #include "DigitalTube_Control.h"
+#include "stream_function.h"
+#include "key_function.h"
+#include "relay_sequence.h"
+#include "relay_control.h"
+#include "sched_function.h"
+#include "nvic_config.h"
+#include "perf_function.h"
+#include "delay_function.h"
+#include "trace_function.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -195,10 +204,12 @@ void PendSV_Handler(void)
 void SysTick_Handler(void)
 {
   /* USER CODE BEGIN SysTick_IRQn 0 */
-
+  PERF_BEGIN(SYSTICK);
   /* USER CODE END SysTick_IRQn 0 */
   HAL_IncTick();
   /* USER CODE BEGIN SysTick_IRQn 1 */
+  Sched_Tick();
+  PERF_END(SYSTICK);
 
   /* USER CODE END SysTick_IRQn 1 */
 }
@@ -216,11 +227,11 @@ void SysTick_Handler(void)
 void EXTI4_IRQHandler(void)
 {
   /* USER CODE BEGIN EXTI4_IRQn 0 */
-
+  PERF_BEGIN(EXTI);
   /* USER CODE END EXTI4_IRQn 0 */
   HAL_GPIO_EXTI_IRQHandler(KEY1_Pin);
   /* USER CODE BEGIN EXTI4_IRQn 1 */
-
+  PERF_END(EXTI);
   /* USER CODE END EXTI4_IRQn 1 */
 }
 
@@ -230,9 +241,11 @@ void EXTI4_IRQHandler(void)
 void DMA1_Channel1_IRQHandler(void)
 {
   /* USER CODE BEGIN DMA1_Channel1_IRQn 0 */
+  PERF_BEGIN(DMA1_CH1);
 	if (DMA1->ISR & DMA_ISR_TCIF1)
 	{
 			DMA1->IFCR = DMA_IFCR_CTCIF1;   // 清除标志
+			TRACE(DMA_SPI, 0);
 			
 			// 等待 SPI 发送缓冲空且总线空闲 (严谨时序)
 			while ((SPI2->SR & SPI_SR_FTLVL) != 0);
@@ -244,7 +257,7 @@ void DMA1_Channel1_IRQHandler(void)
   /* USER CODE END DMA1_Channel1_IRQn 0 */
   HAL_DMA_IRQHandler(&hdma_spi2_tx);
   /* USER CODE BEGIN DMA1_Channel1_IRQn 1 */
-
+  PERF_END(DMA1_CH1);
   /* USER CODE END DMA1_Channel1_IRQn 1 */
 }
 
@@ -254,16 +267,18 @@ void DMA1_Channel1_IRQHandler(void)
 void DMA1_Channel2_IRQHandler(void)
 {
   /* USER CODE BEGIN DMA1_Channel2_IRQn 0 */
+  PERF_BEGIN(DMA1_CH2);
 	// USART1_TX DMA 传输完成中断
 	if(DMA1->ISR & DMA_ISR_TCIF2){
 		DMA1->IFCR |= DMA_IFCR_CTCIF2;
 		DMA1_Channel2->CCR &= ~DMA_CCR_EN;
+		TRACE(DMA_U1_TX, 0);
 		USART1->CR1 |= USART_CR1_TCIE;// 使能 USART1 发送完成中断
 	}
   /* USER CODE END DMA1_Channel2_IRQn 0 */
   HAL_DMA_IRQHandler(&hdma_usart1_tx);
   /* USER CODE BEGIN DMA1_Channel2_IRQn 1 */
-
+  PERF_END(DMA1_CH2);
   /* USER CODE END DMA1_Channel2_IRQn 1 */
 }
 
@@ -273,11 +288,11 @@ void DMA1_Channel2_IRQHandler(void)
 void DMA1_Channel4_IRQHandler(void)
 {
   /* USER CODE BEGIN DMA1_Channel4_IRQn 0 */
-
+  PERF_BEGIN(DMA1_CH4);
   /* USER CODE END DMA1_Channel4_IRQn 0 */
   HAL_DMA_IRQHandler(&hdma_usart3_rx);
   /* USER CODE BEGIN DMA1_Channel4_IRQn 1 */
-
+  PERF_END(DMA1_CH4);
   /* USER CODE END DMA1_Channel4_IRQn 1 */
 }
 
@@ -287,11 +302,11 @@ void DMA1_Channel4_IRQHandler(void)
 void DMA1_Channel5_IRQHandler(void)
 {
   /* USER CODE BEGIN DMA1_Channel5_IRQn 0 */
-
+  PERF_BEGIN(DMA1_CH5);
   /* USER CODE END DMA1_Channel5_IRQn 0 */
   HAL_DMA_IRQHandler(&hdma_usart3_tx);
   /* USER CODE BEGIN DMA1_Channel5_IRQn 1 */
-
+  PERF_END(DMA1_CH5);
   /* USER CODE END DMA1_Channel5_IRQn 1 */
 }
 
@@ -301,13 +316,13 @@ void DMA1_Channel5_IRQHandler(void)
 void EXTI9_5_IRQHandler(void)
 {
   /* USER CODE BEGIN EXTI9_5_IRQn 0 */
-
+  PERF_BEGIN(EXTI);
   /* USER CODE END EXTI9_5_IRQn 0 */
   HAL_GPIO_EXTI_IRQHandler(KEY2_Pin);
   HAL_GPIO_EXTI_IRQHandler(KEY3_Pin);
   HAL_GPIO_EXTI_IRQHandler(KEY4_Pin);
   /* USER CODE BEGIN EXTI9_5_IRQn 1 */
-
+  PERF_END(EXTI);
   /* USER CODE END EXTI9_5_IRQn 1 */
 }
 
@@ -317,11 +332,11 @@ void EXTI9_5_IRQHandler(void)
 void TIM1_UP_TIM16_IRQHandler(void)
 {
   /* USER CODE BEGIN TIM1_UP_TIM16_IRQn 0 */
-
+  PERF_BEGIN(TIM1);
   /* USER CODE END TIM1_UP_TIM16_IRQn 0 */
   HAL_TIM_IRQHandler(&htim1);
   /* USER CODE BEGIN TIM1_UP_TIM16_IRQn 1 */
-
+  PERF_END(TIM1);
   /* USER CODE END TIM1_UP_TIM16_IRQn 1 */
 }
 
@@ -331,30 +346,48 @@ void TIM1_UP_TIM16_IRQHandler(void)
 void USART1_IRQHandler(void)
 {
   /* USER CODE BEGIN USART1_IRQn 0 */
-	// RXNE 接收中断
+  PERF_BEGIN(USART1);
+	// RXNE 接收中断 (FIFO 非空, 一次取空)
 	if(USART1->ISR & USART_ISR_RXNE){
-		if(Usart1.DataCnt >= Usart1RxSize){
-			Usart1.DataCnt = 0;
-		}	
-		Usart1.RxData[Usart1.DataCnt++] = USART1->RDR;					
+		while(USART1->ISR & USART_ISR_RXNE){
+			if(Usart1.AutoBaud){
+				Usart1_AutoBaudRx();
+				continue;
+			}
+			if(Usart1.DataCnt >= Usart1RxSize){
+				Usart1.DataCnt = 0;
+			}	
+			Usart1.RxData[Usart1.DataCnt++] = USART1->RDR;
+		}
 	}
 	// 发送完成中断
 	else if(USART1->ISR & USART_ISR_TC){
 		USART1->ICR = USART_ICR_TCCF;  // 清除 TC 标志
+		TRACE(U1_TX_DONE, 0);
 		USART1->CR1 = USART1->CR1 & ~(USART_CR1_TCIE | USART_CR1_TE);	
 		EnableUARTReceive(&huart1);	
 		Usart1RxEnable();		
+		// 流模式: 上一帧发送完成后立即调度下一批
+		if(Stream_IsActive()) Sched_Post(SCHED_TASK_STREAM);
 	}
 	// 空闲中断 (IDLE) - 一帧数据接收完成
 	else if(USART1->ISR & USART_ISR_IDLE){
 		USART1->ICR = USART_ICR_IDLECF;  // 清除 IDLE 标志
+		TRACE(U1_RX_FRAME, Usart1.DataCnt);
+		Usart1_BaudConfirm();
 		if(Usart1.DataCnt >= 2 && 
 		   Usart1.RxData[Usart1.DataCnt-1] == '\n' && 
 		   Usart1.RxData[Usart1.DataCnt-2] == '\r'){
 			Usart1_ReceiveStringHandler();			
+		}else if(Stream_IsActive()){
+			// 流模式下总线专用于数据流, 其余数据仅作为主机保活
+			Stream_KeepAlive();
 		}else{
 			if(Usart1.DataCnt >= 4){
-				ModBus_SlaveRx();			
+				// 帧处理延后到调度任务, 处理完成前关闭接收
+				DisableUARTReceive(&huart1);
+				Usart1.FrameLen = Usart1.DataCnt;
+				Sched_Post(SCHED_TASK_MODBUS);
 			}			
 		}
 		Usart1.DataCnt = 0;
@@ -362,7 +395,7 @@ void USART1_IRQHandler(void)
   /* USER CODE END USART1_IRQn 0 */
   HAL_UART_IRQHandler(&huart1);
   /* USER CODE BEGIN USART1_IRQn 1 */
-
+  PERF_END(USART1);
   /* USER CODE END USART1_IRQn 1 */
 }
 
@@ -372,11 +405,11 @@ void USART1_IRQHandler(void)
 void USART3_IRQHandler(void)
 {
   /* USER CODE BEGIN USART3_IRQn 0 */
-
+  PERF_BEGIN(USART3);
   /* USER CODE END USART3_IRQn 0 */
   HAL_UART_IRQHandler(&huart3);
   /* USER CODE BEGIN USART3_IRQn 1 */
-
+  PERF_END(USART3);
   /* USER CODE END USART3_IRQn 1 */
 }
 
@@ -386,14 +419,124 @@ void USART3_IRQHandler(void)
 void TIM6_DAC_IRQHandler(void)
 {
   /* USER CODE BEGIN TIM6_DAC_IRQn 0 */
-  DTC_ScanHandler();
+  PERF_BEGIN(TIM6);
+  if (DTC_ScanHandler()) {
+    TRACE(DISP_SCAN, 1);
+    Stream_SampleTick();
+  } else {
+    TRACE(DISP_SCAN, 0);
+  }
   /* USER CODE END TIM6_DAC_IRQn 0 */
   HAL_TIM_IRQHandler(&htim6);
   /* USER CODE BEGIN TIM6_DAC_IRQn 1 */
-
+  PERF_END(TIM6);
   /* USER CODE END TIM6_DAC_IRQn 1 */
 }
 
 /* USER CODE BEGIN 1 */
+/**
+  * @brief This function handles TIM7 global interrupt (按键单次定时).
+  */
+void TIM7_IRQHandler(void)
+{
+	PERF_BEGIN(TIM7);
+	if(TIM7->SR & TIM_SR_UIF){
+		TIM7->SR = ~TIM_SR_UIF;
+		Key_TimerHandler();
+	}
+	PERF_END(TIM7);
+}
+
+/**
+  * @brief This function handles DMA1 channel6 global interrupt (继电器时序播放完成).
+  */
+void DMA1_Channel6_IRQHandler(void)
+{
+	PERF_BEGIN(DMA1_CH6);
+	TRACE(DMA_RSEQ, 0);
+	RelaySeq_DmaHandler();
+	PERF_END(DMA1_CH6);
+}
+
+/**
+  * @brief This function handles TIM17 global interrupt (继电器先断后合死区定时).
+  */
+void TIM1_TRG_COM_TIM17_IRQHandler(void)
+{
+	PERF_BEGIN(TIM17);
+	if(TIM17->SR & TIM_SR_UIF){
+		TIM17->SR = ~TIM_SR_UIF;
+		Relay_DeadTimeHandler();
+	}
+	PERF_END(TIM17);
+}
+
+/**
+  * @brief This function handles TIM2 global interrupt (64 位时基溢出扩展).
+  */
+void TIM2_IRQHandler(void)
+{
+	PERF_BEGIN(TIM2);
+	Time_OverflowHandler();
+	PERF_END(TIM2);
+}
+
+/**
+  * @brief This function handles TIM15 global interrupt (中断进入延迟探针, 入口先读计数).
+  */
+void TIM1_BRK_TIM15_IRQHandler(void)
+{
+	uint32_t cnt = TIM15->CNT;
+
+	if(TIM15->SR & TIM_SR_UIF){
+		Irq_ProbeHandler(cnt);
+	}
+}
+
+/**
+  * @brief This function handles DMA2 channel1 global interrupt (LPUART1 TX, 外部仪表总线).
+  */
+void DMA2_Channel1_IRQHandler(void)
+{
+	PERF_BEGIN(DMA2_CH1);
+	if(DMA2->ISR & DMA_ISR_TCIF1){
+		DMA2->IFCR = DMA_IFCR_CTCIF1;
+		DMA2_Channel1->CCR &= ~DMA_CCR_EN;
+		TRACE(DMA_LP1_TX, 0);
+		LPUART1->CR1 |= USART_CR1_TCIE;// 使能 LPUART1 发送完成中断
+	}
+	PERF_END(DMA2_CH1);
+}
+
+/**
+  * @brief This function handles LPUART1 global interrupt (外部仪表总线 Modbus 主站).
+  */
+void LPUART1_IRQHandler(void)
+{
+	PERF_BEGIN(LPUART1);
+	// 发送完成中断: 切回接收并启动 DMA 接收应答
+	if((LPUART1->CR1 & USART_CR1_TCIE) && (LPUART1->ISR & USART_ISR_TC)){
+		LPUART1->ICR = USART_ICR_TCCF;
+		LPUART1->CR1 = LPUART1->CR1 & ~(USART_CR1_TCIE | USART_CR1_TE);
+		TRACE(LP1_TX_DONE, 0);
+		Lpuart1RxEnable();
+		Lpuart1.DataCnt = 0;
+		Lpuart1ReceiverDMA();
+	}
+	// 空闲中断 (IDLE) - 一帧应答接收完成
+	else if(LPUART1->ISR & USART_ISR_IDLE){
+		LPUART1->ICR = USART_ICR_IDLECF;
+		Lpuart1.DataCnt = Lpuart1RxSize - DMA2_Channel2->CNDTR;
+		if(Lpuart1.DataCnt > 0){
+			Lpuart1ReceiverStop();
+			Lpuart1.FrameFlag = 1;
+			TRACE(LP1_RX_FRAME, Lpuart1.DataCnt);
+			Sched_Post(SCHED_TASK_MASTER);
+		}
+	}
+	// 溢出/帧错误: 清除标志, 应答由主站超时处理
+	LPUART1->ICR = USART_ICR_ORECF | USART_ICR_FECF | USART_ICR_NECF;
+	PERF_END(LPUART1);
+}
 
 /* USER CODE END 1 */
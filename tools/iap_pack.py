@@ -0,0 +1,356 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+IAP 升级帧打包工具 (主机端)
+
+将 APP 固件 (.bin) 切分为 IAP 数据帧, 输出为按顺序拼接的帧文件, 由上位机按
+滑动窗口逐批发送 (见 iap_function.c 协议说明). 末尾附加结束帧.
+
+  原始帧: 55 AA | len(2) | addr(4) | payload | crc16(len+addr+payload)
+  压缩帧: 55 AB | len(2) | addr(4) | LZSS    | crc16(AB+len+addr+payload)
+  差分帧: 55 AC | len(2) | addr(4) | 指令    | crc16(AC+len+addr+payload)
+  镜像头: 55 AD | len(2) | addr(4) | length(4) crc32(4) version(4) | crc16(AD+len+addr+payload)
+
+用法:
+  python iap_pack.py app.bin app.iap            # 压缩帧 (默认)
+  python iap_pack.py app.bin app.iap --raw      # 原始帧
+  python iap_pack.py app.bin app.iap --delta old.bin   # 相对设备当前镜像 old.bin 的差分帧
+  python iap_pack.py app.bin app.iap --version 3 # 先发镜像头帧 (设备校验整个镜像, 支持断点续传)
+  python iap_pack.py app.bin app.iap --version 3 --from 0x8000   # 设备回复 "RESUME 32768" 后的续传帧
+  python iap_pack.py app.bin app.iap --verify   # 打包后按固件算法解包, 与原文件比对
+
+镜像头帧须单独发送, 等待设备回复 "RESUME n" 后从偏移 n 起发送 (--from n 重新打包).
+"""
+import argparse
+import struct
+import sys
+import zlib
+
+APP_ADDRESS = 0x08005000
+APP_END_ADDRESS = 0x0803D800
+MAX_PAYLOAD = 1024
+PAGE_SIZE = 0x800
+
+LZ_WINDOW = 4096
+LZ_MIN_MATCH = 3
+LZ_MAX_MATCH = 18
+LZ_CHAIN = 64                   # 每个前缀最多比较的候选位置
+
+DELTA_OP_BASE = 0x01
+DELTA_OP_COPY = 0x02
+DELTA_OP_DATA = 0x03
+DELTA_MIN_COPY = 12             # 短于此长度的匹配按新数据发送 (COPY 指令 7 字节)
+DELTA_GRAM = 8                  # 旧镜像索引的匹配前缀长度
+DELTA_CHAIN = 16
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0xA001 if crc & 1 else crc >> 1
+    return crc
+
+
+def frame(header2, addr, payload):
+    body = struct.pack('<HI', len(payload), addr) + payload
+    crc = crc16(body) if header2 == 0xAA else crc16(bytes([header2]) + body)
+    return bytes([0x55, header2]) + body + struct.pack('<H', crc)
+
+
+def lz_tokens(data):
+    """贪心 LZSS: 返回 (literal, 字节) 或 (match, 距离, 长度) 记号序列"""
+    heads = {}
+    tokens = []
+    i, n = 0, len(data)
+    while i < n:
+        best_len, best_dist = 0, 0
+        if i + LZ_MIN_MATCH <= n:
+            key = data[i:i + LZ_MIN_MATCH]
+            limit = min(LZ_MAX_MATCH, n - i)
+            for j in reversed(heads.get(key, [])[-LZ_CHAIN:]):
+                dist = i - j
+                if dist > LZ_WINDOW:
+                    break
+                k = LZ_MIN_MATCH
+                while k < limit and data[j + k] == data[i + k]:
+                    k += 1
+                if k > best_len:
+                    best_len, best_dist = k, dist
+                    if k == limit:
+                        break
+        step = best_len if best_len >= LZ_MIN_MATCH else 1
+        for p in range(i, i + step):
+            if p + LZ_MIN_MATCH <= n:
+                heads.setdefault(data[p:p + LZ_MIN_MATCH], []).append(p)
+        if best_len >= LZ_MIN_MATCH:
+            tokens.append((best_dist, best_len))
+        else:
+            tokens.append((0, data[i]))
+        i += step
+    return tokens
+
+
+def pack_lz(data, base):
+    """按帧切分记号流: 每帧以标志字节开始, 帧内记号完整, 帧地址为该帧解压输出起始地址"""
+    frames = []
+    out = 0
+    payload, flag_pos, bit, frame_addr = bytearray(), 0, 8, base
+    for dist, val in lz_tokens(data):
+        enc = bytes([val]) if dist == 0 else bytes([(dist - 1) & 0xFF, ((dist - 1) >> 4 & 0xF0) | (val - LZ_MIN_MATCH)])
+        need = len(enc) + (1 if bit == 8 else 0)
+        if len(payload) + need > MAX_PAYLOAD:
+            frames.append(frame(0xAB, frame_addr, bytes(payload)))
+            payload, bit, frame_addr = bytearray(), 8, base + out
+        if bit == 8:
+            flag_pos, bit = len(payload), 0
+            payload.append(0)
+        if dist == 0:
+            payload[flag_pos] |= 1 << bit
+        payload += enc
+        bit += 1
+        out += 1 if dist == 0 else val
+    if payload:
+        frames.append(frame(0xAB, frame_addr, bytes(payload)))
+    return frames
+
+
+def pack_raw(data, base):
+    return [frame(0xAA, base + i, data[i:i + MAX_PAYLOAD]) for i in range(0, len(data), MAX_PAYLOAD)]
+
+
+def delta_dirty(old, new):
+    """设备端会改写的页: 新页 (页尾超出新镜像部分保持原内容) 与旧页不同"""
+    flash = old + b'\xFF' * (APP_END_ADDRESS - APP_ADDRESS - len(old))
+    dirty = []
+    for p in range(0, len(new), PAGE_SIZE):
+        page = new[p:p + PAGE_SIZE]
+        page += flash[p + len(page):p + PAGE_SIZE]
+        dirty.append(page != flash[p:p + PAGE_SIZE])
+    return dirty
+
+
+def delta_ops(old, new):
+    """生成 COPY/DATA 指令: 复制源须在设备重建到该字节时仍保留旧内容"""
+    dirty = delta_dirty(old, new)
+    prev = [None] * len(dirty)          # 输出第 q 页时 IapDeltaPrev 保存的页号
+    last = None
+    for q in range(len(dirty)):
+        prev[q] = last
+        if dirty[q]:
+            last = q
+
+    def legal(s, o):
+        ps, q = s // PAGE_SIZE, o // PAGE_SIZE
+        return ps >= q or ps == prev[q] or not (ps < len(dirty) and dirty[ps])
+
+    index = {}
+    for j in range(len(old) - DELTA_GRAM + 1):
+        index.setdefault(old[j:j + DELTA_GRAM], []).append(j)
+
+    ops, pending = [], bytearray()
+    o, n = 0, len(new)
+    while o < n:
+        cands = [o] if o < len(old) else []
+        cands += index.get(new[o:o + DELTA_GRAM], [])[-DELTA_CHAIN:]
+        best_len, best_src = 0, 0
+        for s in cands:
+            k = 0
+            while o + k < n and s + k < len(old) and k < 0xFFFF and old[s + k] == new[o + k] and legal(s + k, o + k):
+                k += 1
+            if k > best_len:
+                best_len, best_src = k, s
+        if best_len >= DELTA_MIN_COPY:
+            if pending:
+                ops.append((DELTA_OP_DATA, bytes(pending)))
+                pending = bytearray()
+            ops.append((DELTA_OP_COPY, best_src, best_len))
+            o += best_len
+        else:
+            pending.append(new[o])
+            o += 1
+    if pending:
+        ops.append((DELTA_OP_DATA, bytes(pending)))
+    return ops
+
+
+def pack_delta(old, new, base):
+    """按帧切分差分指令: 每帧指令完整 (DATA 可拆分), 帧地址为该帧输出起始地址"""
+    frames = []
+    payload = bytearray(struct.pack('<BIIII', DELTA_OP_BASE, len(old), zlib.crc32(old), len(new), zlib.crc32(new)))
+    frame_addr, out = base, 0
+    for op in delta_ops(old, new):
+        if op[0] == DELTA_OP_COPY:
+            if len(payload) + 7 > MAX_PAYLOAD:
+                frames.append(frame(0xAC, frame_addr, bytes(payload)))
+                payload, frame_addr = bytearray(), base + out
+            payload += struct.pack('<BHI', DELTA_OP_COPY, op[2], op[1])
+            out += op[2]
+            continue
+        data = op[1]
+        while data:
+            if len(payload) + 4 > MAX_PAYLOAD:
+                frames.append(frame(0xAC, frame_addr, bytes(payload)))
+                payload, frame_addr = bytearray(), base + out
+            chunk = data[:MAX_PAYLOAD - 3 - len(payload)]
+            payload += struct.pack('<BH', DELTA_OP_DATA, len(chunk)) + chunk
+            data = data[len(chunk):]
+            out += len(chunk)
+    if payload:
+        frames.append(frame(0xAC, frame_addr, bytes(payload)))
+    return frames
+
+
+def unpack_delta(stream, base, old):
+    """按固件算法执行差分帧 (逐页重建, 改写页只保留最近一页旧内容), 返回 (APP 区内容, 改写页数)"""
+    flash = bytearray(old + b'\xFF' * (APP_END_ADDRESS - APP_ADDRESS - len(old)))
+    dirty, prev_page, prev = set(), None, b''
+    page, out, new_len, new_crc, written = bytearray(PAGE_SIZE), 0, 0, 0, 0
+
+    def commit():
+        nonlocal prev_page, prev, written
+        p = (out - 1) // PAGE_SIZE
+        fill = out - p * PAGE_SIZE
+        page[fill:] = flash[p * PAGE_SIZE + fill:(p + 1) * PAGE_SIZE]
+        if page != flash[p * PAGE_SIZE:(p + 1) * PAGE_SIZE]:
+            prev_page, prev = p, bytes(flash[p * PAGE_SIZE:(p + 1) * PAGE_SIZE])
+            dirty.add(p)
+            flash[p * PAGE_SIZE:(p + 1) * PAGE_SIZE] = page
+            written += 1
+
+    def put(b):
+        nonlocal out
+        assert out < new_len
+        page[out % PAGE_SIZE] = b
+        out += 1
+        if out % PAGE_SIZE == 0:
+            commit()
+
+    pos = 0
+    while pos < len(stream):
+        h2 = stream[pos + 1]
+        length, addr = struct.unpack_from('<HI', stream, pos + 2)
+        payload = stream[pos + 8:pos + 8 + length]
+        pos += 10 + length
+        if h2 != 0xAC:
+            break
+        i = 0
+        while i < len(payload):
+            op = payload[i]
+            if op == DELTA_OP_BASE:
+                old_len, old_crc, new_len, new_crc = struct.unpack_from('<IIII', payload, i + 1)
+                assert addr == base and zlib.crc32(bytes(flash[:old_len])) == old_crc
+                i += 17
+                continue
+            assert i != 0 or addr == base + out
+            n = struct.unpack_from('<H', payload, i + 1)[0]
+            if op == DELTA_OP_COPY:
+                s = struct.unpack_from('<I', payload, i + 3)[0]
+                for s in range(s, s + n):
+                    ps = s // PAGE_SIZE
+                    assert ps == prev_page or ps not in dirty, 'copy from overwritten page'
+                    put(prev[s % PAGE_SIZE] if ps == prev_page else flash[s])
+                i += 7
+            else:
+                for b in payload[i + 3:i + 3 + n]:
+                    put(b)
+                i += 3 + n
+    assert out == new_len
+    if out % PAGE_SIZE:
+        commit()
+    assert zlib.crc32(bytes(flash[:new_len])) == new_crc
+    return flash, written
+
+
+def unpack(stream, base, size):
+    """按固件算法解析帧文件, 返回写入 APP 区的镜像 (未写区域为 0xFF)"""
+    image = bytearray(b'\xFF' * size)
+    lz_base, lz = None, bytearray()
+    pos = 0
+    while pos < len(stream):
+        h2 = stream[pos + 1]
+        length, addr = struct.unpack_from('<HI', stream, pos + 2)
+        body = stream[pos + 2:pos + 8 + length]
+        crc = struct.unpack_from('<H', stream, pos + 8 + length)[0]
+        assert stream[pos] == 0x55 and crc == (crc16(body) if h2 == 0xAA else crc16(bytes([h2]) + body))
+        payload = stream[pos + 8:pos + 8 + length]
+        pos += 10 + length
+        if h2 == 0xAB:
+            if lz_base is None or addr != lz_base + len(lz):
+                lz_base, lz = addr, bytearray()
+            i, bit, flags = 0, 8, 0
+            while i < len(payload):
+                if bit == 8:
+                    flags, bit, i = payload[i], 0, i + 1
+                    continue
+                if flags >> bit & 1:
+                    lz.append(payload[i])
+                    i += 1
+                else:
+                    dist = (payload[i] | (payload[i + 1] & 0xF0) << 4) + 1
+                    for _ in range((payload[i + 1] & 0x0F) + LZ_MIN_MATCH):
+                        lz.append(lz[-dist])
+                    i += 2
+                bit += 1
+            image[lz_base - base:lz_base - base + len(lz)] = lz
+        elif h2 == 0xAD:
+            continue
+        elif length == 0 and addr == 0xFFFFFFFF:
+            break
+        else:
+            image[addr - base:addr - base + length] = payload
+    return image
+
+
+def main():
+    ap = argparse.ArgumentParser(description='IAP 升级帧打包工具')
+    ap.add_argument('input', help='APP 固件 (.bin)')
+    ap.add_argument('output', help='输出帧文件')
+    ap.add_argument('--addr', type=lambda x: int(x, 0), default=APP_ADDRESS, help='APP 起始地址')
+    ap.add_argument('--raw', action='store_true', help='输出原始帧 (不压缩)')
+    ap.add_argument('--delta', metavar='OLD', help='设备当前镜像 (.bin), 输出差分帧')
+    ap.add_argument('--version', type=lambda x: int(x, 0), help='镜像版本, 输出镜像头帧')
+    ap.add_argument('--from', dest='start', type=lambda x: int(x, 0), default=0, help='续传偏移 (设备回复的 RESUME n)')
+    ap.add_argument('--verify', action='store_true', help='解包比对')
+    args = ap.parse_args()
+
+    data = open(args.input, 'rb').read()
+    if args.addr % 8 or args.addr < APP_ADDRESS or args.addr + len(data) > APP_END_ADDRESS:
+        sys.exit('image does not fit APP area')
+
+    if (args.version is not None or args.delta) and args.addr != APP_ADDRESS:
+        sys.exit('image header / delta update starts at APP_ADDRESS')
+    if args.start % PAGE_SIZE or args.start > len(data) or (args.start and args.version is None):
+        sys.exit('--from must be a page-aligned RESUME offset of an image header session')
+
+    frames = []
+    if args.version is not None:
+        frames.append(frame(0xAD, args.addr, struct.pack('<III', len(data), zlib.crc32(data), args.version)))
+    if args.delta:
+        old = open(args.delta, 'rb').read()
+        frames += pack_delta(old, data, args.addr)
+    elif args.raw:
+        frames += pack_raw(data[args.start:], args.addr + args.start)
+    else:
+        frames += pack_lz(data[args.start:], args.addr + args.start)
+    frames.append(frame(0xAA, 0xFFFFFFFF, b''))
+    stream = b''.join(frames)
+    open(args.output, 'wb').write(stream)
+    print('%d bytes -> %d frames, %d bytes (%.1f%%)' % (len(data), len(frames), len(stream), 100.0 * len(stream) / max(len(data), 1)))
+
+    if args.verify:
+        if args.delta:
+            flash, written = unpack_delta(stream, args.addr, old)
+            image = flash[:len(data)]
+            print('%d of %d pages programmed' % (written, (len(data) + PAGE_SIZE - 1) // PAGE_SIZE))
+        else:
+            image = unpack(stream, args.addr, len(data))
+            image[:args.start] = data[:args.start]
+        if bytes(image) != data:
+            sys.exit('verify FAILED')
+        print('verify OK')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,161 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+事件追踪解码工具 (主机端)
+
+将设备事件追踪缓冲区的读出 (见 trace_function.h) 解码为时间线:
+每行为 相对时间 (us), 与上一事件的间隔 (us), 事件名, 参数.
+
+输入格式:
+  文本: 命令 "Trace" 的串口输出 (TRACE 头行 + 每条记录 "时间 编号 参数" 十六进制 + END),
+        时钟与时间戳移位取自头行 clk=/shift=, 头行之前/END 之后的内容忽略
+  二进制: Modbus 14H 读文件 2 得到的寄存器数据按序拼接 (大端, 每条记录 4 个寄存器 8 字节:
+        时间戳高, 时间戳低, 事件编号, 参数), 时钟由 --clock 指定, 移位由 --shift 指定 (文件 1 寄存器 6)
+
+时间戳为 64 位时基右移 shift 位的低 32 位 (默认 256 个 CPU 周期为单位, 170MHz 时约 108 min 回绕):
+按相邻记录的有符号差值展开, 相邻两条记录间隔超过回绕周期的一半 (约 54 min) 时无法区分, 时间轴会错位.
+展开后按时间排序 (高优先级中断抢占写入时记录顺序可能与时间先后差一两条).
+
+用法:
+  python trace_decode.py dump.txt                 # 文本
+  python trace_decode.py dump.bin --binary        # 二进制, 170MHz
+  python trace_decode.py dump.bin --binary --clock 170
+  python trace_decode.py dump.txt --group RELAY --group FLASH   # 只显示指定组
+"""
+import argparse
+import re
+import struct
+import sys
+
+# 事件名称表: 须与 trace_function.h 中 TRACE_xxx 编号一致
+EVENTS = {
+    0x00: 'U1_RX_FRAME',
+    0x01: 'U1_TX_START',
+    0x02: 'U1_TX_DONE',
+    0x10: 'DMA_U1_TX',
+    0x11: 'DMA_SPI',
+    0x12: 'DMA_LP1_TX',
+    0x13: 'DMA_RSEQ',
+    0x20: 'DISP_SCAN',
+    0x30: 'RSEQ_START',
+    0x31: 'RSEQ_HALT',
+    0x32: 'RELAY_WRITE',
+    0x33: 'RELAY_MAKE',
+    0x40: 'FLASH_ERASE',
+    0x41: 'FLASH_ERASED',
+    0x42: 'FLASH_LOG',
+    0x43: 'FLASH_PARAMS',
+    0x50: 'LP1_RX_FRAME',
+    0x51: 'LP1_TX_DONE',
+    0x60: 'TASK_BEGIN',
+    0x61: 'TASK_END',
+}
+
+GROUPS = {
+    'USART1': 0,
+    'DMA': 1,
+    'DISPLAY': 2,
+    'RELAY': 3,
+    'FLASH': 4,
+    'LPUART1': 5,
+    'SCHED': 6,
+}
+
+DEFAULT_CLOCK_MHZ = 170
+DEFAULT_SHIFT = 8       # TRACE_TIME_SHIFT
+
+
+def parse_text(lines):
+    """返回 (记录列表, 时钟 MHz 或 None, 时间戳移位或 None), 记录为 (时间, 编号, 参数)"""
+    recs = []
+    clock = None
+    shift = None
+    started = False
+    for line in lines:
+        line = line.strip()
+        if not started:
+            m = re.match(r'TRACE\b.*\bclk=(\d+)', line)
+            if m:
+                clock = int(m.group(1))
+                m = re.search(r'\bshift=(\d+)', line)
+                if m:
+                    shift = int(m.group(1))
+                started = True
+            continue
+        if line == 'END':
+            break
+        m = re.match(r'([0-9A-Fa-f]{8})\s+([0-9A-Fa-f]{4})\s+([0-9A-Fa-f]{4})$', line)
+        if m:
+            recs.append(tuple(int(g, 16) for g in m.groups()))
+    if not started:
+        sys.exit('no TRACE header found')
+    return recs, clock, shift
+
+
+def parse_binary(data):
+    if len(data) % 8:
+        sys.exit('binary dump length %d is not a multiple of 8' % len(data))
+    recs = []
+    for off in range(0, len(data), 8):
+        hi, lo, eid, arg = struct.unpack_from('>HHHH', data, off)
+        recs.append(((hi << 16) | lo, eid, arg))
+    return recs
+
+
+def unwrap(recs, shift):
+    """32 位时间戳按相邻差值 (有符号) 展开为单调时间轴, 返回按时间排序的 (CPU 周期, 编号, 参数)"""
+    out = []
+    t = 0
+    prev = None
+    for raw, eid, arg in recs:
+        if prev is not None:
+            d = (raw - prev) & 0xFFFFFFFF
+            if d >= 0x80000000:
+                d -= 0x100000000
+            t += d
+        prev = raw
+        out.append((t << shift, eid, arg))
+    out.sort(key=lambda r: r[0])
+    return out
+
+
+def main():
+    ap = argparse.ArgumentParser(description='Decode device event trace dump into a timeline')
+    ap.add_argument('input', help='text dump ("Trace" command output) or binary file-record dump')
+    ap.add_argument('--binary', action='store_true', help='input is Modbus 14H file 2 register data')
+    ap.add_argument('--clock', type=int, help='CPU clock in MHz (default: from text header, else %d)' % DEFAULT_CLOCK_MHZ)
+    ap.add_argument('--shift', type=int, help='timestamp shift (default: from text header, else %d)' % DEFAULT_SHIFT)
+    ap.add_argument('--group', action='append', choices=sorted(GROUPS), help='show only these event groups')
+    args = ap.parse_args()
+
+    if args.binary:
+        recs = parse_binary(open(args.input, 'rb').read())
+        clock = shift = None
+    else:
+        recs, clock, shift = parse_text(open(args.input, 'r', errors='replace'))
+    clock = args.clock or clock or DEFAULT_CLOCK_MHZ
+    if args.shift is not None:
+        shift = args.shift
+    elif shift is None:
+        shift = DEFAULT_SHIFT
+
+    timeline = unwrap(recs, shift)
+    if args.group:
+        keep = set(GROUPS[g] for g in args.group)
+        timeline = [r for r in timeline if (r[1] >> 4) in keep]
+    if not timeline:
+        print('no records')
+        return
+
+    t0 = timeline[0][0]
+    last = t0
+    print('%12s %10s  %-13s %s' % ('t(us)', 'dt(us)', 'event', 'arg'))
+    for t, eid, arg in timeline:
+        name = EVENTS.get(eid, 'EVT_%02X' % eid)
+        print('%12.3f %10.3f  %-13s 0x%04X (%d)' % ((t - t0) / clock, (t - last) / clock, name, arg, arg))
+        last = t
+    print('%d records, %.3f ms' % (len(timeline), (timeline[-1][0] - t0) / clock / 1000.0))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,69 @@
+/* define to prevent recursive inclusion -------------------------------------*/
+#ifndef __NVIC_CONFIG_H
+#define __NVIC_CONFIG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* includes ------------------------------------------------------------------*/
+#include "stm32g4xx_hal.h"
+
+/*
+  中断优先级规划 (NVIC_PRIORITYGROUP_4: 4 位抢占优先级, 无子优先级; 数值越小越优先)
+  全部中断的优先级只在 nvic_config() 中设置 (CubeMX 生成代码与各模块初始化中的 0 级设置在其后被覆盖)
+
+  级别  名称              中断
+  0     IRQ_PRIO_TIMEBASE TIM2 (64 位时基溢出扩展, 只有两条指令; 须高于全部读取方, 见 delay_function.h)
+  1     IRQ_PRIO_ENCODER  USART3 + DMA1_Ch4/Ch5 (2.5Mbps 编码器总线), TIM1 (时序引擎),
+                          TIM15 (中断延迟探针, 仅压力测试时启用)
+  2     IRQ_PRIO_RELAY    DMA1_Ch6 (时序播放完成), TIM17 (先断后合死区)
+  4     IRQ_PRIO_COMM     USART1 + DMA1_Ch2 (Modbus 从站/文本命令), LPUART1 + DMA2_Ch1 (外部仪表 Modbus 主站)
+  5     IRQ_PRIO_TICK     SysTick (HAL_GetTick, 调度器周期投递)
+  8     IRQ_PRIO_UI       TIM6 + DMA1_Ch1 (数码管扫描/SPI2), TIM7 + EXTI (按键)
+
+  临界区使用 BASEPRI (Irq_Lock/Irq_Unlock): 只屏蔽与共享数据相关的级别及以下, 更高级别 (编码器路径) 照常抢占
+  锁级别取访问该数据的最高优先级中断的级别
+*/
+#define IRQ_PRIO_TIMEBASE   0
+#define IRQ_PRIO_ENCODER    1
+#define IRQ_PRIO_RELAY      2
+#define IRQ_PRIO_COMM       4
+#define IRQ_PRIO_TICK       5
+#define IRQ_PRIO_UI         8
+
+/* 中断延迟压力测试: TIM15 与编码器路径同级, 更新事件后 CNT 从 0 计数, 中断入口读取 CNT 即为进入延迟 */
+#define IRQ_PROBE_PERIOD    17000       // 探针基本周期 (定时器计数, 约 100us), 每次叠加伪随机抖动避免与扫描同相
+
+typedef struct {
+    uint8_t  Active;            // 测试进行中
+    uint32_t Samples;           // 采样次数
+    uint32_t MaxCycles;         // 最大进入延迟 (CPU 周期)
+    uint64_t SumCycles;         // 延迟累计 (求平均)
+} strIrqProbe;
+
+/* BASEPRI 临界区: 屏蔽抢占优先级数值 >= level 的中断, 返回原 BASEPRI 供 Irq_Unlock 恢复 (可嵌套) */
+static __INLINE uint32_t Irq_Lock(uint32_t level)
+{
+    uint32_t old = __get_BASEPRI();
+    __set_BASEPRI_MAX(level << (8U - __NVIC_PRIO_BITS));
+    return old;
+}
+
+static __INLINE void Irq_Unlock(uint32_t old)
+{
+    __set_BASEPRI(old);
+}
+
+/* exported functions ------------------------------------------------------- */
+void nvic_config(void);
+uint32_t Tim_GetClock(const TIM_TypeDef *tim);
+void Irq_ProbeStart(uint32_t ms);
+void Irq_ProbeHandler(uint32_t cnt);
+const strIrqProbe *Irq_ProbeGet(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -12,13 +12,34 @@ extern "C" {
 #define Usart1TxEnable() 					HAL_GPIO_WritePin(GPIOA, GPIO_PIN_8, GPIO_PIN_SET)
 #define Usart1RxEnable()					HAL_GPIO_WritePin(GPIOA, GPIO_PIN_8, GPIO_PIN_RESET)
          	
+/* 外部仪表总线 (Modbus 主站): LPUART1, PB11 TX / PB10 RX (AF8), PB2 为 RS485 方向控制
+   USART3 (PC10/PC11, PB3 方向) 为 2.5Mbps 编码器总线, 不与仪表总线共用
+   硬件依赖: 三个引脚在 .ioc 中未分配, 由 lpuart1_config 配置, 仪表总线收发器须接到这三个引脚;
+   PB2 不再作为工位继电器输出, 继电器状态读取 (gpio_config.c) 屏蔽该位 */
+#define LPUART1_DE_PORT           GPIOB
+#define LPUART1_DE_PIN            GPIO_PIN_2
+#define Lpuart1TxEnable() 				HAL_GPIO_WritePin(LPUART1_DE_PORT, LPUART1_DE_PIN, GPIO_PIN_SET)
+#define Lpuart1RxEnable()					HAL_GPIO_WritePin(LPUART1_DE_PORT, LPUART1_DE_PIN, GPIO_PIN_RESET)
+
 #define Usart1TxSize         0x100
 #define Usart1RxSize         0x100
+#define Lpuart1TxSize        0x100
+#define Lpuart1RxSize        0x100
+
+// USART1 波特率配置 (PA_IDX_UART1_BAUD 参数取值)
+#define USART1_BAUD_DEFAULT       57600       // 参数为 0: CubeMX 默认波特率
+#define USART1_BAUD_AUTO          1           // 参数为 1: 上电自动波特率检测 (主机先发 0x55 同步字节)
+#define USART1_BAUD_MIN           4800        // 参数 >= MIN: 固定波特率 (BRR 为 16 位, PCLK2 170MHz 下限)
+#define USART1_BAUD_MAX           6000000     // RS485 收发器上限
+#define USART1_BAUD_ERR_PCT       1           // 16 倍过采样误差超过此值 (%) 时才改用 8 倍过采样
+#define USART1_BAUD_CONFIRM_MS    2000        // 切换后等待主机以新波特率通信的时间, 超时回退
+#define USART1_TX_MAX_BYTES       512         // 单帧最大发送长度 (Usart1_Print 缓冲区), 计算发送等待超时
+#define USART1_TX_MARGIN_US       10000       // 发送等待超时余量
 
 typedef struct
 {
 	uint8_t *Data;
-	uint8_t DataSize;
+	uint16_t DataSize;
 } strUsart1Tx;
 
 
@@ -26,14 +47,38 @@ typedef struct{
   uint8_t  		TxData[Usart1TxSize];
   uint8_t  		RxData[Usart1RxSize];	
 	uint16_t    DataCnt;          // 接收到的数据长度
+	uint16_t    FrameLen;         // 待处理 Modbus 帧长度 (空闲中断保存, 调度任务处理)
 	uint8_t     StringFlag;       // 字符串接收完成标志
+	uint8_t     AutoBaud;         // 自动波特率检测中 (首字节仅用于测量, 丢弃)
+	uint8_t     BaudPending;      // 波特率切换确认: 0 = 无, 1 = 等待主机, 2 = 已确认
 	strUsart1Tx Tx;
 } strUsart1;	
 
+typedef struct{
+  uint8_t  		TxData[Lpuart1TxSize];
+  uint8_t  		RxData[Lpuart1RxSize];	
+	uint16_t    DataCnt;          // 接收到的数据长度
+	uint8_t     FrameFlag;        // 一帧接收完成标志 (IDLE 置位, 主循环清零)
+	strUsart1Tx Tx;
+} strLpuart1;	
+
 extern volatile strUsart1   Usart1;
+extern volatile strLpuart1  Lpuart1;
 
 void uart_config(void);
+void lpuart1_config(uint32_t baudrate);
+void Usart1_SetBaudRate(uint32_t baudrate);
+void Usart1_AutoBaudArm(void);
+void Usart1_AutoBaudRx(void);
+void Usart1_BaudInit(int32_t cfg);
+void Usart1_BaudNegotiate(uint32_t baudrate);
+void Usart1_BaudConfirm(void);
+void Usart1_BaudPoll(void);
+void Usart1_BaudSave_Callback(int32_t cfg);
 void Usart1TransmitterDMA(volatile strUsart1Tx * p);
+void Lpuart1TransmitterDMA(volatile strUsart1Tx * p);
+void Lpuart1ReceiverDMA(void);
+void Lpuart1ReceiverStop(void);
 void DisableUARTReceive(UART_HandleTypeDef *huart);
 void EnableUARTReceive(UART_HandleTypeDef *huart);
 void Usart1_Print(const char *format, ...);
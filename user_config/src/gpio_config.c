@@ -4,6 +4,8 @@
   *           
 ****************************************************************************************/
 #include "gpio_config.h"
+#include "relay_control.h"
+#include "uart_config.h"
 /****************************************************************************************
 * ƣGet_GPIO_Output_Status
 * ܣȡGPIOA(PA0-PA7)GPIOB(PB0-PB7)ŵ״̬
@@ -16,7 +18,7 @@ uint16_t Get_GPIO_Output_Status(void) {
 
     // ֱӶȡGPIOAGPIOBݼĴ
     status |= (GPIOA->ODR & 0xFF);       // PA0PA7״̬
-    status |= ((GPIOB->ODR & 0xFF) << 8); // PB0PB7״̬
+    status |= ((GPIOB->ODR & 0xFF & ~LPUART1_DE_PIN) << 8); // PB0PB7״̬ (PB2 ΪǱ߷,  0)
 
     return status;
 }
@@ -75,45 +77,11 @@ uint8_t Get_GPIOA_Output_Status(uint8_t pin_index)
 ****************************************************************************************/
 uint8_t Get_Relay_Status_By_StationID(uint8_t station_id) 
 {
-    uint8_t status = 0;
+    // վ n Ӧ {PA0..PA7, PB0..PB6} е 3(n-1) ~ 3(n-1)+2 λ: ˿ڸһ ODR λȡ
+    // PB2 ΪǱ RS485  ( uart_config.h), ̵״̬
+    uint32_t bank = Relay_GetMask() | ((GPIOB->ODR & 0x7FU & ~LPUART1_DE_PIN) << 8);
 
-    switch (station_id) {
-        case 1: // վ1: ȡ PA0, PA1, PA2
-            status |= (HAL_GPIO_ReadPin(GPIOA, GPIO_PIN_0) << 0); // ȡPA0״̬bit0
-            status |= (HAL_GPIO_ReadPin(GPIOA, GPIO_PIN_1) << 1); // ȡPA1״̬bit1
-            status |= (HAL_GPIO_ReadPin(GPIOA, GPIO_PIN_2) << 2); // ȡPA2״̬bit2
-            break;
-
-        case 2: // վ2: ȡ PA3, PA4, PA5
-            status |= (HAL_GPIO_ReadPin(GPIOA, GPIO_PIN_3) << 0);
-            status |= (HAL_GPIO_ReadPin(GPIOA, GPIO_PIN_4) << 1);
-            status |= (HAL_GPIO_ReadPin(GPIOA, GPIO_PIN_5) << 2);
-            break;
-
-        case 3: // վ3: ȡ PA6, PA7, PB0
-            status |= (HAL_GPIO_ReadPin(GPIOA, GPIO_PIN_6) << 0);
-            status |= (HAL_GPIO_ReadPin(GPIOA, GPIO_PIN_7) << 1);
-            status |= (HAL_GPIO_ReadPin(GPIOB, GPIO_PIN_0) << 2);
-            break;
-
-        case 4: // վ4: ȡ PB1, PB2, PB3
-            status |= (HAL_GPIO_ReadPin(GPIOB, GPIO_PIN_1) << 0);
-            status |= (HAL_GPIO_ReadPin(GPIOB, GPIO_PIN_2) << 1);
-            status |= (HAL_GPIO_ReadPin(GPIOB, GPIO_PIN_3) << 2);
-            break;
-
-        case 5: // վ5: ȡ PB4, PB5, PB6
-            status |= (HAL_GPIO_ReadPin(GPIOB, GPIO_PIN_4) << 0);
-            status |= (HAL_GPIO_ReadPin(GPIOB, GPIO_PIN_5) << 1);
-            status |= (HAL_GPIO_ReadPin(GPIOB, GPIO_PIN_6) << 2);
-            break;
-
-        default:
-            // վЧ0
-            status = 0;
-            break;
-    }
-
-    return status;
+    if (station_id < 1 || station_id > 5) return 0; // վЧ0
+    return (uint8_t)((bank >> ((station_id - 1) * 3)) & 0x07U);
 }
 
@@ -0,0 +1,142 @@
+/****************************************************************************************
+  * @file      nvic_config.c
+  * @brief     中断优先级统一配置与中断进入延迟压力测试 (规划见 nvic_config.h)
+  ****************************************************************************************/
+#include "nvic_config.h"
+#include "delay_function.h"
+
+/* 中断优先级表 (唯一设置处) */
+typedef struct {
+    IRQn_Type Irq;
+    uint8_t   Prio;
+} strNvicPrio;
+
+static const strNvicPrio NvicPrioTable[] = {
+    { TIM2_IRQn,                IRQ_PRIO_TIMEBASE },    // 时基溢出
+    { USART3_IRQn,              IRQ_PRIO_ENCODER },
+    { DMA1_Channel4_IRQn,       IRQ_PRIO_ENCODER },     // USART3 RX
+    { DMA1_Channel5_IRQn,       IRQ_PRIO_ENCODER },     // USART3 TX
+    { TIM1_UP_TIM16_IRQn,       IRQ_PRIO_ENCODER },
+    { TIM1_BRK_TIM15_IRQn,      IRQ_PRIO_ENCODER },     // 延迟探针
+    { DMA1_Channel6_IRQn,       IRQ_PRIO_RELAY   },     // 时序播放完成
+    { TIM1_TRG_COM_TIM17_IRQn,  IRQ_PRIO_RELAY   },     // 先断后合死区
+    { USART1_IRQn,              IRQ_PRIO_COMM    },
+    { DMA1_Channel2_IRQn,       IRQ_PRIO_COMM    },     // USART1 TX
+    { LPUART1_IRQn,             IRQ_PRIO_COMM    },     // 外部仪表总线
+    { DMA2_Channel1_IRQn,       IRQ_PRIO_COMM    },     // LPUART1 TX
+    { TIM6_DAC_IRQn,            IRQ_PRIO_UI      },     // 数码管扫描
+    { DMA1_Channel1_IRQn,       IRQ_PRIO_UI      },     // SPI2 TX (数码管)
+    { TIM7_IRQn,                IRQ_PRIO_UI      },     // 按键定时
+    { EXTI4_IRQn,               IRQ_PRIO_UI      },     // KEY1
+    { EXTI9_5_IRQn,             IRQ_PRIO_UI      },     // KEY2-KEY4
+};
+#define NVIC_PRIO_COUNT     (sizeof(NvicPrioTable) / sizeof(NvicPrioTable[0]))
+
+/* 延迟探针 */
+static strIrqProbe IrqProbe;
+static strTimeout IrqProbeEnd;              // 结束时刻 (64 位时基, 探针优先级高于 SysTick, 不用 HAL_GetTick)
+static uint32_t IrqProbeLfsr = 0xACE1U;     // 周期抖动
+static uint32_t IrqProbeScale = 1;          // CPU 周期 / 定时器计数
+
+/**************************************************************************************
+* 函数名称：nvic_config()
+* 函数功能：按优先级规划设置全部中断优先级 (在外设与各模块初始化之后、开始调度之前调用一次),
+*           并将 TIM15 配置为延迟探针定时器 (默认停止)
+* 输入参量：无
+* 输出参量：无
+***************************************************************************************/
+void nvic_config(void)
+{
+    uint32_t clk = Tim_GetClock(TIM15);
+    uint8_t i;
+
+    HAL_NVIC_SetPriorityGrouping(NVIC_PRIORITYGROUP_4);
+    for (i = 0; i < NVIC_PRIO_COUNT; i++) {
+        HAL_NVIC_SetPriority(NvicPrioTable[i].Irq, NvicPrioTable[i].Prio, 0);
+    }
+    // SysTick: 重新初始化以更新 HAL 记录的节拍优先级 (时钟切换时沿用)
+    HAL_InitTick(IRQ_PRIO_TICK);
+
+    IrqProbeScale = (SystemCoreClock >= clk) ? SystemCoreClock / clk : 1;
+
+    __HAL_RCC_TIM15_CLK_ENABLE();
+    TIM15->CR1 = TIM_CR1_URS;
+    TIM15->PSC = 0;
+    TIM15->ARR = IRQ_PROBE_PERIOD;
+    TIM15->EGR = TIM_EGR_UG;
+    TIM15->SR = 0;
+    TIM15->DIER = TIM_DIER_UIE;
+    HAL_NVIC_EnableIRQ(TIM1_BRK_TIM15_IRQn);
+}
+
+/**************************************************************************************
+* 函数名称：Tim_GetClock
+* 函数功能：读取定时器计数时钟 (APB 分频不为 1 时定时器时钟为 PCLK 的 2 倍)
+* 输入参量：tim - 定时器 (按外设地址区分 APB1/APB2)
+* 输出参量：定时器时钟 (Hz)
+***************************************************************************************/
+uint32_t Tim_GetClock(const TIM_TypeDef *tim)
+{
+    if ((uint32_t)tim >= APB2PERIPH_BASE) {
+        uint32_t clk = HAL_RCC_GetPCLK2Freq();
+        return (RCC->CFGR & RCC_CFGR_PPRE2_2) ? clk * 2 : clk;
+    } else {
+        uint32_t clk = HAL_RCC_GetPCLK1Freq();
+        return (RCC->CFGR & RCC_CFGR_PPRE1_2) ? clk * 2 : clk;
+    }
+}
+
+/**************************************************************************************
+* 函数名称：Irq_ProbeStart
+* 函数功能：开始中断进入延迟压力测试 (清除上次结果), 测试期间由主机施加 Modbus/显示负载
+* 输入参量：ms - 测试时长
+* 输出参量：无
+***************************************************************************************/
+void Irq_ProbeStart(uint32_t ms)
+{
+    TIM15->CR1 &= ~TIM_CR1_CEN;
+    IrqProbe.Samples = 0;
+    IrqProbe.MaxCycles = 0;
+    IrqProbe.SumCycles = 0;
+    IrqProbeEnd.Deadline = Time_Now() + (uint64_t)ms * (SystemCoreClock / 1000);
+    IrqProbe.Active = 1;
+    TIM15->CNT = 0;
+    TIM15->SR = 0;
+    TIM15->CR1 |= TIM_CR1_CEN;
+}
+
+/**************************************************************************************
+* 函数名称：Irq_ProbeHandler
+* 函数功能：探针中断处理: 记录进入延迟, 设置下一周期 (带抖动), 到时停止
+* 输入参量：cnt - 中断入口处读取的 TIM15->CNT (更新事件后的计数)
+* 输出参量：无
+***************************************************************************************/
+void Irq_ProbeHandler(uint32_t cnt)
+{
+    uint32_t cyc = cnt * IrqProbeScale;
+
+    TIM15->SR = ~TIM_SR_UIF;
+    IrqProbe.Samples++;
+    IrqProbe.SumCycles += cyc;
+    if (cyc > IrqProbe.MaxCycles) IrqProbe.MaxCycles = cyc;
+
+    // 16 位 LFSR 抖动 0 ~ 1023 计数, 避免与 1ms 节拍/数码管扫描锁相
+    IrqProbeLfsr = (IrqProbeLfsr >> 1) ^ (-(IrqProbeLfsr & 1U) & 0xB400U);
+    TIM15->ARR = IRQ_PROBE_PERIOD + (IrqProbeLfsr & 0x3FFU);
+
+    if (Timeout_Expired(&IrqProbeEnd)) {
+        TIM15->CR1 &= ~TIM_CR1_CEN;
+        IrqProbe.Active = 0;
+    }
+}
+
+/**************************************************************************************
+* 函数名称：Irq_ProbeGet
+* 函数功能：读取压力测试结果
+* 输入参量：无
+* 输出参量：测试结果
+***************************************************************************************/
+const strIrqProbe *Irq_ProbeGet(void)
+{
+    return &IrqProbe;
+}
@@ -5,11 +5,14 @@
 #include "uart_config.h"
 #include "usart.h"
 #include "modbus_function.h"
+#include "delay_function.h"
+#include "trace_function.h"
 #include <string.h>
 #include <stdarg.h>
 #include <stdio.h>
 
 volatile strUsart1  Usart1 = {0};
+volatile strLpuart1 Lpuart1 = {0};
 
 /**************************************************************************************
 * 函数名称：uart_config()
@@ -21,6 +24,9 @@ void uart_config(void)
 {
     // 开启 USART1 DMA 发送请求
     USART1->CR3 |= USART_CR3_DMAT;
+
+    // 开启接收 FIFO (8 级), 高波特率下中断内一次取空, 降低溢出风险
+    HAL_UARTEx_EnableFifoMode(&huart1);
     
     // 开启 DMA 发送完成中断 (DMA1_Channel2 用于 USART1_TX)
     DMA1_Channel2->CCR |= DMA_CCR_TCIE;
@@ -40,6 +46,7 @@ void uart_config(void)
 ***************************************************************************************/
 void Usart1TransmitterDMA(volatile strUsart1Tx * p)
 {
+    TRACE(U1_TX_START, p->DataSize);
     Usart1TxEnable();
     USART1->CR1 |= USART_CR1_TE;
     
@@ -58,6 +65,296 @@ void Usart1TransmitterDMA(volatile strUsart1Tx * p)
     DMA1_Channel2->CCR |= DMA_CCR_EN;
 }
 
+/**************************************************************************************
+* 函数名称：Usart1_WaitTxDone()
+* 函数功能：等待 USART1 发送完成 (RS485 方向脚由发送完成中断释放), 等待期间休眠
+*           超时按最大帧长与当前波特率计算, 发送异常时不会永久卡死
+* 输入参量：无
+* 输出参量：无
+***************************************************************************************/
+static void Usart1_WaitTxDone(void)
+{
+    strTimeout to;
+
+    Timeout_Start(&to, (uint32_t)(((uint64_t)USART1_TX_MAX_BYTES * 10 * 1000000) / huart1.Init.BaudRate) + USART1_TX_MARGIN_US);
+    while ((GPIOA->ODR & (1 << 8)) && !Timeout_Expired(&to)) Time_Idle();
+}
+
+/**************************************************************************************
+* 函数名称：Usart1_SetBaudRate()
+* 函数功能：运行中切换 USART1 波特率 (等待当前发送完成后切换)
+*           默认 16 倍过采样 (抗噪更好); 仅当分频不足 16, 或 16 倍误差超过 USART1_BAUD_ERR_PCT
+*           且 8 倍误差更小时改用 8 倍 (PCLK2 170MHz 下 4/6 Mbaud), 8 倍分频须在 16 位以内
+* 输入参量：baudrate - 新波特率
+* 输出参量：无
+***************************************************************************************/
+void Usart1_SetBaudRate(uint32_t baudrate)
+{
+    uint32_t pclk = HAL_RCC_GetPCLK2Freq();
+    uint32_t div16 = (pclk + baudrate / 2) / baudrate;
+    uint32_t div8  = (2 * pclk + baudrate / 2) / baudrate;
+    uint32_t err16, err8;
+    uint8_t over8;
+
+    // 误差统一换算到 2*pclk 量纲比较
+    err16 = (div16 * baudrate > pclk) ? (div16 * baudrate - pclk) * 2 : (pclk - div16 * baudrate) * 2;
+    err8  = (div8 * baudrate > 2 * pclk) ? (div8 * baudrate - 2 * pclk) : (2 * pclk - div8 * baudrate);
+    over8 = (div8 <= 0xFFFFU) &&
+            (div16 < 16 || (err16 * 100 > 2 * pclk * USART1_BAUD_ERR_PCT && err8 < err16));
+
+    // 等待发送完成（RS485 方向控制）
+    Usart1_WaitTxDone();
+
+    USART1->CR1 &= ~USART_CR1_UE;
+    USART1->CR2 &= ~USART_CR2_ABREN;
+    if (over8) {
+        // OVER8: BRR[15:4] = USARTDIV[15:4], BRR[2:0] = USARTDIV[3:0] >> 1
+        USART1->CR1 |= USART_CR1_OVER8;
+        USART1->BRR = (div8 & 0xFFF0U) | ((div8 & 0x000FU) >> 1);
+        huart1.Init.OverSampling = UART_OVERSAMPLING_8;
+    } else {
+        USART1->CR1 &= ~USART_CR1_OVER8;
+        USART1->BRR = div16;
+        huart1.Init.OverSampling = UART_OVERSAMPLING_16;
+    }
+    USART1->CR1 |= USART_CR1_UE;
+    huart1.Init.BaudRate = baudrate;
+    Usart1.AutoBaud = 0;
+}
+
+/**************************************************************************************
+* 函数名称：Usart1_AutoBaudArm()
+* 函数功能：启动 USART1 自动波特率检测 (0x55 帧模式, 以主机发送的首个 0x55 测量)
+* 输入参量：无
+* 输出参量：无
+***************************************************************************************/
+void Usart1_AutoBaudArm(void)
+{
+    // 等待发送完成（RS485 方向控制）
+    Usart1_WaitTxDone();
+
+    USART1->CR1 &= ~USART_CR1_UE;
+    USART1->CR1 &= ~USART_CR1_OVER8;
+    USART1->CR2 = (USART1->CR2 & ~USART_CR2_ABRMODE) | USART_CR2_ABRMODE_0 | USART_CR2_ABRMODE_1 | USART_CR2_ABREN;
+    huart1.Init.OverSampling = UART_OVERSAMPLING_16;
+    Usart1.AutoBaud = 1;
+    USART1->CR1 |= USART_CR1_UE;
+}
+
+/**************************************************************************************
+* 函数名称：Usart1_AutoBaudRx()
+* 函数功能：自动波特率检测期间的接收处理 (在 USART1 中断中调用)
+*           同步字节丢弃; 测量失败则重新请求, 等待下一个同步字节
+* 输入参量：无
+* 输出参量：无
+***************************************************************************************/
+void Usart1_AutoBaudRx(void)
+{
+    uint32_t isr = USART1->ISR;
+
+    (void)USART1->RDR;
+    if (isr & USART_ISR_ABRE) {
+        USART1->RQR = USART_RQR_ABRRQ;
+    } else if (isr & USART_ISR_ABRF) {
+        huart1.Init.BaudRate = HAL_RCC_GetPCLK2Freq() / USART1->BRR;
+        Usart1.AutoBaud = 0;
+    }
+}
+
+/**************************************************************************************
+* 函数名称：Usart1_BaudInit()
+* 函数功能：上电按 PA 参数配置 USART1 波特率
+* 输入参量：cfg - 0 = 默认, 1 = 自动检测, MIN ~ MAX = 固定波特率, 其余值按默认处理
+* 输出参量：无
+***************************************************************************************/
+void Usart1_BaudInit(int32_t cfg)
+{
+    if (cfg == USART1_BAUD_AUTO) {
+        Usart1_AutoBaudArm();
+    } else if (cfg >= USART1_BAUD_MIN && cfg <= USART1_BAUD_MAX) {
+        Usart1_SetBaudRate((uint32_t)cfg);
+    }
+}
+
+static uint32_t Usart1BaudPrev = 0;          // 切换前波特率 (确认超时回退用)
+static uint32_t Usart1BaudTick = 0;          // 切换时刻
+
+/**************************************************************************************
+* 函数名称：Usart1_BaudNegotiate()
+* 函数功能：协商切换波特率: 以当前波特率应答后切换, 主机须在确认时间内
+*           以新波特率发来任意有效命令/Modbus 帧, 否则自动回退
+* 输入参量：baudrate - 新波特率
+* 输出参量：无
+***************************************************************************************/
+void Usart1_BaudNegotiate(uint32_t baudrate)
+{
+    Usart1_Print("OK %lu\r\n", (unsigned long)baudrate);
+
+    Usart1BaudPrev = huart1.Init.BaudRate;
+    Usart1_SetBaudRate(baudrate);
+    Usart1BaudTick = HAL_GetTick();
+    Usart1.BaudPending = 1;
+}
+
+/**************************************************************************************
+* 函数名称：Usart1_BaudConfirm()
+* 函数功能：波特率切换待确认时检查收到的帧 (在 USART1 IDLE 中断中调用)
+*           以 CRLF 结尾的字符串或 CRC 正确的 Modbus 帧视为主机已切换成功
+* 输入参量：无
+* 输出参量：无
+***************************************************************************************/
+void Usart1_BaudConfirm(void)
+{
+    uint16_t n = Usart1.DataCnt;
+
+    if (Usart1.BaudPending != 1 || n < 2) return;
+
+    if (Usart1.RxData[n - 2] == '\r' && Usart1.RxData[n - 1] == '\n') {
+        Usart1.BaudPending = 2;
+    } else if (n >= 4 &&
+               Modbus_CRC16(Usart1.RxData, (uint8_t)(n - 2)) == (((uint16_t)Usart1.RxData[n - 1] << 8) | Usart1.RxData[n - 2])) {
+        Usart1.BaudPending = 2;
+    }
+}
+
+/**************************************************************************************
+* 函数名称：Usart1_BaudPoll()
+* 函数功能：波特率切换确认/回退 (在主循环中调用), 确认后保存到 PA 参数
+* 输入参量：无
+* 输出参量：无
+***************************************************************************************/
+void Usart1_BaudPoll(void)
+{
+    if (Usart1.BaudPending == 2) {
+        Usart1.BaudPending = 0;
+        Usart1_BaudSave_Callback((int32_t)huart1.Init.BaudRate);
+    } else if (Usart1.BaudPending == 1 && (HAL_GetTick() - Usart1BaudTick) >= USART1_BAUD_CONFIRM_MS) {
+        Usart1.BaudPending = 0;
+        Usart1_SetBaudRate(Usart1BaudPrev);
+    }
+}
+
+/**************************************************************************************
+* 函数名称：lpuart1_config()
+* 函数功能：配置 LPUART1 (外部仪表 Modbus 主站总线, DMA2_Ch1 发送 / DMA2_Ch2 接收 + IDLE 断帧)
+*           该口不在 CubeMX 工程中, 时钟/引脚/DMA 全部在此配置
+* 输入参量：baudrate - 外部仪表总线波特率
+* 输出参量：无
+***************************************************************************************/
+void lpuart1_config(uint32_t baudrate)
+{
+    GPIO_InitTypeDef GPIO_InitStruct = {0};
+    uint32_t pclk, brr;
+    uint8_t presc;
+
+    __HAL_RCC_LPUART1_CONFIG(RCC_LPUART1CLKSOURCE_PCLK1);
+    __HAL_RCC_LPUART1_CLK_ENABLE();
+    __HAL_RCC_GPIOB_CLK_ENABLE();
+    __HAL_RCC_DMAMUX1_CLK_ENABLE();
+    __HAL_RCC_DMA2_CLK_ENABLE();
+
+    // PB11 TX / PB10 RX
+    GPIO_InitStruct.Pin = GPIO_PIN_10 | GPIO_PIN_11;
+    GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+    GPIO_InitStruct.Pull = GPIO_PULLUP;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_HIGH;
+    GPIO_InitStruct.Alternate = GPIO_AF8_LPUART1;
+    HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
+
+    // RS485 方向控制, 默认接收
+    Lpuart1RxEnable();
+    GPIO_InitStruct.Pin = LPUART1_DE_PIN;
+    GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    GPIO_InitStruct.Alternate = 0;
+    HAL_GPIO_Init(LPUART1_DE_PORT, &GPIO_InitStruct);
+
+    // LPUART BRR = 256 * fck / baud, 须在 0x300 ~ 0xFFFFF 之间: 取满足范围的最小预分频
+    pclk = HAL_RCC_GetPCLK1Freq();
+    for (presc = UART_PRESCALER_DIV1; presc < UART_PRESCALER_DIV256; presc++) {
+        if (UART_DIV_LPUART(pclk, baudrate, presc) <= 0xFFFFFU) break;
+    }
+    brr = UART_DIV_LPUART(pclk, baudrate, presc);
+
+    // 8N1, 收发器在发送/接收时分别打开
+    LPUART1->CR1 = 0;
+    LPUART1->PRESC = presc;
+    LPUART1->BRR = brr;
+    LPUART1->CR3 = USART_CR3_DMAT | USART_CR3_DMAR | USART_CR3_EIE;
+    LPUART1->CR1 = USART_CR1_IDLEIE | USART_CR1_UE;
+
+    // DMA2_Channel1: 存储器 -> TDR (完成中断), DMA2_Channel2: RDR -> 存储器 (IDLE 断帧, 无中断)
+    DMAMUX1_Channel8->CCR = DMA_REQUEST_LPUART1_TX;
+    DMAMUX1_Channel9->CCR = DMA_REQUEST_LPUART1_RX;
+    DMA2_Channel1->CCR = DMA_CCR_DIR | DMA_CCR_MINC | DMA_CCR_TCIE;
+    DMA2_Channel1->CPAR = (uint32_t)&LPUART1->TDR;
+    DMA2_Channel2->CCR = DMA_CCR_MINC;
+    DMA2_Channel2->CPAR = (uint32_t)&LPUART1->RDR;
+
+    HAL_NVIC_EnableIRQ(LPUART1_IRQn);
+    HAL_NVIC_EnableIRQ(DMA2_Channel1_IRQn);
+}
+
+/**************************************************************************************
+* 函数名称：Lpuart1TransmitterDMA()
+* 函数功能：配置并启动 LPUART1 DMA 发送 (使用 DMA2_Channel1)
+* 输入参量：p->Data 数据指针, p->DataSize 数据长度
+* 输出参量：无
+***************************************************************************************/
+void Lpuart1TransmitterDMA(volatile strUsart1Tx * p)
+{
+    // 发送期间关闭接收, 避免 RS485 回环数据进入接收缓冲
+    Lpuart1ReceiverStop();
+
+    Lpuart1TxEnable();
+    LPUART1->CR1 |= USART_CR1_TE;
+    
+    // 禁用 DMA 通道以便重新配置
+    DMA2_Channel1->CCR &= ~DMA_CCR_EN;
+    
+    // 清除 DMA 标志
+    DMA2->IFCR = DMA_IFCR_CTCIF1 | DMA_IFCR_CHTIF1 | DMA_IFCR_CGIF1;
+    
+    // 配置 DMA 传输参数
+    DMA2_Channel1->CMAR = (uint32_t)(p->Data);
+    DMA2_Channel1->CNDTR = p->DataSize;
+    
+    // 使能 DMA 通道
+    DMA2_Channel1->CCR |= DMA_CCR_EN;
+}
+
+/**************************************************************************************
+* 函数名称：Lpuart1ReceiverDMA()
+* 函数功能：启动 LPUART1 DMA 接收 (使用 DMA2_Channel2, 由 IDLE 中断断帧)
+* 输入参量：无
+* 输出参量：无
+***************************************************************************************/
+void Lpuart1ReceiverDMA(void)
+{
+    DMA2_Channel2->CCR &= ~DMA_CCR_EN;
+    DMA2->IFCR = DMA_IFCR_CTCIF2 | DMA_IFCR_CHTIF2 | DMA_IFCR_CGIF2;
+
+    DMA2_Channel2->CMAR = (uint32_t)Lpuart1.RxData;
+    DMA2_Channel2->CNDTR = Lpuart1RxSize;
+
+    // 清除残留的 IDLE/溢出标志, 再打开接收器
+    LPUART1->ICR = USART_ICR_IDLECF | USART_ICR_ORECF | USART_ICR_FECF | USART_ICR_NECF;
+    DMA2_Channel2->CCR |= DMA_CCR_EN;
+    LPUART1->CR1 |= USART_CR1_RE;
+}
+
+/**************************************************************************************
+* 函数名称：Lpuart1ReceiverStop()
+* 函数功能：停止 LPUART1 接收 (应答帧结束/超时/开始发送时调用)
+* 输入参量：无
+* 输出参量：无
+***************************************************************************************/
+void Lpuart1ReceiverStop(void)
+{
+    DMA2_Channel2->CCR &= ~DMA_CCR_EN;
+    LPUART1->CR1 &= ~USART_CR1_RE;
+}
+
 /**************************************************************************************
 * 函数名称：DisableUARTReceive
 * 函数功能：禁止 UART 接收器
@@ -90,11 +387,11 @@ void EnableUARTReceive(UART_HandleTypeDef *huart)
 ****************************************************************************************/
 void Usart1_Print(const char *format, ...)
 {
-    static char buffer[512];  
+    static char buffer[USART1_TX_MAX_BYTES];
     va_list args;
 
-    // 安全检查：如果 DMA 正在发送，则等待
-    while (DMA1_Channel2->CNDTR != 0); 
+    // 安全检查：如果上一帧正在发送 (缓冲区仍被 DMA 读取)，则等待
+    Usart1_WaitTxDone();
 
     va_start(args, format);
     vsnprintf(buffer, sizeof(buffer), format, args);
@@ -106,5 +403,5 @@ void Usart1_Print(const char *format, ...)
     Usart1TransmitterDMA(&Usart1.Tx);
     
     // 等待发送完成（RS485 方向控制）
-    while((GPIOA->ODR & (1 << 8)));
+    Usart1_WaitTxDone();
 }
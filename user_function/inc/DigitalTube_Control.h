@@ -27,6 +27,16 @@
 #define PIN_DOWN         KEY3_Pin               // 减键
 #define PIN_SHIFT        KEY4_Pin               // 移位键: 短按翻页/移位, 长按进入/保存
 
+// ================= 扫描与亮度 =================
+// TIM6 计数频率 1MHz, 每位 1ms 扫描周期 = 点亮时隙 + 消隐时隙 (亮度参数见 param_table.h)
+#define DTC_SCAN_PERIOD_US  1000                // 每位扫描周期 (us)
+#define DTC_ON_MIN_US       20                  // 最短点亮时间 (us, 须大于 2 字节 SPI 传输时间)
+#define DTC_BRIGHT_LEVELS   10                  // 亮度等级数 (1 ~ 10, 0 = 默认最亮)
+#define DTC_MONITOR_MS      200                 // 监控模式刷新间隔 (ms, 显示任务中渲染)
+#define DTC_ANIM_STEP_MS    150                 // 开机动画打字间隔 (ms)
+#define DTC_ANIM_STEPS      5                   // 开机动画字符数 (Etest)
+#define DTC_MSG_MS          1200                // 消息提示时长 (ms, 300ms 亮灭闪烁 2 次)
+
 // ================= 交互时间参数 =================
 #define KEY_DEBOUNCE_MS  20                     // 消抖时间 (ms)
 #define KEY_LONG_MS      1000                   // 长按判定阈值 (ms)
@@ -68,16 +78,18 @@ typedef enum {
     DTC_MODE_SELECT,                            // 参数选择模式 (PA 001)
     DTC_MODE_EDIT,                              // 参数编辑模式 (数值)
     DTC_MODE_ERROR,                             // 故障报错模式
-    DTC_MODE_MESSAGE                            // 消息提示模式 (donE)
+    DTC_MODE_MESSAGE,                           // 消息提示模式 (donE)
+    DTC_MODE_MONITOR                            // 实时监控模式 (dP 数值定时刷新, 只读)
 } DTC_DispMode_t;
 
-// 单个参数的属性配置
+// 单个参数的属性配置 (常量表项, 见 param_table.h)
 typedef struct {
-    DTC_Sign_t   Sign;                          // 符号属性
-    DTC_Format_t Format;                        // 显示进制
-    DTC_Width_t  Width;                         // 数据位宽
     int32_t      Min;                           // 最小值限制
     int32_t      Max;                           // 最大值限制
+    uint8_t      Sign;                          // 符号属性 (DTC_Sign_t)
+    uint8_t      Format;                        // 显示进制 (DTC_Format_t)
+    uint8_t      Width;                         // 数据位宽 (DTC_Width_t)
+    int32_t      (*Get)(void);                  // 实时数据读取函数 (0 = 读参数数组)
 } DTC_ParamConfig_t;
 
 // 开机动画子状态
@@ -89,7 +101,8 @@ typedef enum {
 
 // 全局运行状态
 typedef struct {
-    uint8_t  RawData[5];                        // 显存 (存储字库索引或特殊段码)
+    uint8_t  Frame[2][5];                       // 显存双缓冲 (字库索引或特殊段码): 主循环渲染后台帧, 扫描中断只读前台帧
+    volatile uint8_t FrameIdx;                  // 前台帧编号 (后台帧渲染完成后单字节写入发布)
     uint8_t  GroupIdx;                          // 当前参数组 (0:PA, 1:dP)
     uint16_t ParamNum;                          // 当前参数编号 (0 ~ SIZE-1)
     
@@ -98,29 +111,36 @@ typedef struct {
     int32_t        EditVal;                     // 正在编辑的临时数值
     uint8_t        EditBit;                     // 当前光标位置 (0-3)
 
+    // 十进制数字缓存 (一次转换覆盖 32 位数据全部 3 页, 翻页无需重算)
+    uint8_t  DecDigits[10];                     // 各位数字 (个位在前)
+    int32_t  DecVal;                            // 缓存对应的数值
+    uint8_t  DecValid;                          // 缓存有效标志
+
     uint16_t BlinkCnt;                          // 闪烁计时器
-    uint16_t KeyTimer;                          // 按键按下计时器
-    uint16_t RepeatTimer;                       // 连发间隔计时器
-    uint16_t CurrentSpeed;                      // 当前连发速度
-    uint8_t  LastKey;                           // 上一次按下的键值
-    uint8_t  LongPressDone;                     // 长按已处理标志
+    uint8_t  LongPressDone;                     // 本次按下已触发长按/连发 (释放时不再按短按处理)
     uint16_t ErrCode;                           // 错误代码
 
     // 动画专用变量
     DTC_AnimState_t AnimState;                  // 动画子状态
-    uint16_t        AnimTimer;                  // 动画计时器
-    uint16_t        MsgTimer;                   // 消息计时器
-    uint8_t         AnimStep;                   // 动画步骤索引
+    uint16_t        AnimTimer;                  // 动画计时器 (扫描中断计时)
+    uint16_t        MsgTimer;                   // 消息计时器 (扫描中断计时, 到 DTC_MSG_MS 停止)
+    uint8_t         AnimStep;                   // 动画步骤索引 (扫描中断推进, 主循环按其渲染)
+
+    uint32_t        MonTick;                    // 监控数据上次刷新时刻 (ms)
 } DTC_State_t;
 
 // ================= 外部接口声明 =================
 void DTC_Init(void);                            // 初始化函数
-void DTC_ScanHandler(void);                     // 扫描中断处理函数 (1ms)
+uint8_t DTC_ScanHandler(void);                  // 扫描中断处理函数 (TIM6 更新, 返回 1 = 1ms 节拍)
 void DTC_SetError(uint16_t code);               // 报错显示函数
+void DTC_KeyPoll(void);                         // 按键事件处理 (主循环调用)
+void DTC_DisplayPoll(void);                     // 动画/消息/监控数据的显存渲染 (调度器显示任务)
+void DTC_SavePoll(void);                        // 执行挂起的参数保存 (调度器 Flash 任务)
 
 // 用户需实现的回调函数 (模拟 Flash 保存)
 void DTC_SaveParams_Callback(void); 
 
+extern DTC_State_t DTC_Dev;                     // 运行状态
 extern int32_t PA_Buffer[PA_SIZE];              // PA 参数数组
 extern int32_t DP_Buffer[DP_SIZE];              // dP 参数数组
 
@@ -8,7 +8,10 @@
 * Start Addr    Size    Description
 * -----------------------------------------------------------
 * 0x0800 0000   20KB    Bootloader
-* 0x0800 5000   232KB   APP (Application)
+* 0x0800 5000   226KB   APP (Application)
+* 0x0803 D800   2KB     Record Log Page A (继电器动作计数)
+* 0x0803 E000   2KB     Record Log Page B
+* 0x0803 E800   2KB     IAP Journal (iap_function.h)
 * 0x0803 F000   2KB     Parameter Page A (Main)
 * 0x0803 F800   2KB     Parameter Page B (Backup)
 * 0x0804 0000   -       End of Flash
@@ -20,14 +23,33 @@
 // 倒数第1页 (Page 127)
 #define FLASH_ADDR_PAGE_B   0x0803F800
 
+// 记录流页 (两页轮换, 磨损均衡)
+#define FLASH_ADDR_LOG_A    0x0803D800
+#define FLASH_ADDR_LOG_B    0x0803E000
+
 // 页面大小 (STM32G4 2KB) - 已在 HAL 库中定义
 // #define FLASH_PAGE_SIZE     2048
 
 // 有效标志 (Magic Number)
 #define FLASH_VALID_FLAG    0x5A5A5A5A
 
+// 参数页布局: [Magic][Data0..DataN-1][CRC] 按 8 字节对齐后, 再写一个 [Schema][~Schema]
+// Schema 为参数属性表版本号 (Param_SchemaId), 旧固件保存的页此处为擦除态 0xFFFFFFFF
+
+// 记录流布局: 每条记录 [Seq][Data0..DataN-1][CRC] 按 8 字节对齐, 在当前页依次追加 (不擦除),
+// 当前页写满后擦除另一页继续; 加载时取 CRC 正确且 Seq 最大的记录, 写入中途掉电只丢失最后一条
+
+// Flash_LoadParams 返回值
+#define FLASH_LOAD_OK       0                   // 加载成功
+#define FLASH_LOAD_EMPTY    1                   // 两页均无有效数据
+#define FLASH_LOAD_SCHEMA   2                   // 数据有效, 但属性表已变更, 需按新范围校验
+
 // ================= 函数声明 =================
 void Flash_SaveParams(int32_t *buffer, uint16_t count);
 uint8_t Flash_LoadParams(int32_t *buffer, uint16_t count);
+uint32_t Flash_GetEraseCount(void);
+uint32_t Flash_GetLogEraseCount(void);
+uint8_t Flash_LoadLog(uint32_t *buffer, uint16_t count);
+void Flash_AppendLog(const uint32_t *buffer, uint16_t count);
 
 #endif
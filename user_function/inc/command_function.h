@@ -0,0 +1,47 @@
+/* define to prevent recursive inclusion -------------------------------------*/
+#ifndef __COMMAND_FUNCTION_H
+#define __COMMAND_FUNCTION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* includes ------------------------------------------------------------------*/
+#include "stm32g4xx_hal.h"
+
+#define CMD_MAX_TOKENS      8               // 单行最多分词数 (命令名 + 参数)
+#define CMD_MAX_ARGS        4               // 单条命令最多参数数
+#define CMD_NAME_LEN        32              // 两词命令名拼接缓冲
+
+/*
+  参数类型 (ArgSpec 中每个字符对应一个参数):
+  'i' 有符号整数 (支持 0x 前缀)   'u' 无符号整数
+  's' 字符串                      'b' 开关 (On/Off/1/0)
+  'k' 继电器 (K1-K8)              'p' 参数号 (PA012 / dP003)
+*/
+typedef struct {
+    const char *Str;                        // 原始字符串
+    int32_t     Int;                        // 数值 (i/u/b/k/p 类型有效)
+    uint8_t     Group;                      // 参数组 (p 类型: 0=PA, 1=dP)
+} strCmdArg;
+
+typedef void (*CmdHandler_t)(const strCmdArg *arg, uint8_t argc);
+
+/* 命令表项 */
+typedef struct {
+    const char   *Name;                     // 命令名 (可为两词, 表按 strcmp 升序排列)
+    const char   *ArgSpec;                  // 参数类型串
+    uint8_t       MinArgs;                  // 必选参数个数 (其余为可选)
+    CmdHandler_t  Handler;                  // 处理函数
+    const char   *Help;                     // 帮助说明
+} strCmdEntry;
+
+/* exported functions ------------------------------------------------------- */
+void Cmd_Init(void);
+void Usart1_SendStringHandler(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -9,11 +9,32 @@ extern "C" {
 /* includes ------------------------------------------------------------------*/
 #include "stm32g4xx_hal.h"
 
+/*
+  64 位单调时基与非阻塞超时:
+  - TIM2 (32 位) 以定时器时钟 (Tim_GetClock) 自由计数, 溢出中断 (最高优先级) 扩展高 32 位, 读数换算为 CPU 周期
+    (DWT->CYCCNT 在调度器空闲 WFI 休眠期间停止计数, 不能作为墙钟; 仍用于 delay_us 短延时与耗时统计)
+  - Time_Now 可在任意上下文调用 (含关中断), 溢出中断未及处理时按挂起标志补进位
+  - 超时对象只保存截止时刻, 轮询 Timeout_Expired 判断, 不阻塞
+  - 需要等待时循环调用 Time_Idle: 线程模式下 WFI 休眠至下一个中断 (SysTick 保证 1ms 内唤醒), 不空转
+*/
 #define delay_ms HAL_Delay
 
+#define TIME_CYCLES_PER_US  (SystemCoreClock / 1000000)
+
+/* 超时对象 */
+typedef struct {
+    uint64_t Deadline;          // 截止时刻 (Time_Now 计数)
+} strTimeout;
+
 #define PWR_CTRL_Enable() 					HAL_GPIO_WritePin(GPIOA, GPIO_PIN_11, GPIO_PIN_SET)
 /* exported functions ------------------------------------------------------- */
 void delay_us(uint32_t us);
+void Time_Init(void);
+void Time_OverflowHandler(void);
+uint64_t Time_Now(void);
+void Time_Idle(void);
+void Timeout_Start(strTimeout *t, uint32_t us);
+uint8_t Timeout_Expired(const strTimeout *t);
 
 
 #ifdef __cplusplus
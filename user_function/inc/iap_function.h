@@ -15,19 +15,30 @@ extern "C" {
 */
 #define FLASH_BASE_ADDR    0x08000000U
 #define APP_ADDRESS        0x08005000U
-#define FLASH_TOTAL_SIZE   (512U * 1024U)    /* 512KB */
+#define FLASH_TOTAL_SIZE   (256U * 1024U)    /* 256KB (STM32G491CC) */
 #define FLASH_PAGE_SIZE    0x800U            /* 2KB */
+#define APP_END_ADDRESS    0x0803D800U       /* APP ,  2 ҳΪ¼, 1 ҳΪ־, 2 ҳΪҳ ( Flash_Storage.h) */
+#define IAP_JOURNAL_ADDRESS 0x0803E800U      /* ־ҳ: ͷ + ύ (ϵ, У) */
 #define IAP_HEADER1        0x55U
 #define IAP_HEADER2        0xAAU
+#define IAP_HEADER2_LZ     0xABU             /* ѹ֡: payload Ϊ LZSS , CRC  header2 ~ payload */
+#define IAP_HEADER2_DELTA  0xACU             /* ֡: payload ΪԵǰ / ָ, CRC ͬѹ֡ */
+#define IAP_HEADER2_IMAGE  0xADU             /* ͷ֡: payload Ϊ /CRC32/汾, ʼһ */
 #define IAP_MAX_PAYLOAD    1024U
 
+/* ˮ (IAP_Run) */
+#define IAP_WINDOW         4U                /* : ȴӦ͵֡ */
+#define IAP_ERR_GAP_MS     50U               /* ֱ߾Ĭ: ̾Ĭʱ, Զ USB-RS485 תڼ϶ (FTDI Ĭ 16ms) */
+
 // ֱʹֵ
 #define RCC_APB1ENR1_TAMPEN	SET_BIT(RCC->APB1ENR1, 0x00000001)// TAMPEN ͨ APB1ENR1 ĵ 0 λ
 
 /* exported functions */
 uint16_t IAP_CRC16_Calc(uint8_t *data, uint32_t len);
-void IAP_Flash_Write(uint32_t address, uint8_t *data, uint32_t length);
+uint32_t IAP_CRC32_Update(uint32_t crc, const uint8_t *data, uint32_t len);
+HAL_StatusTypeDef IAP_Flash_Write(uint32_t address, uint8_t *data, uint32_t length);
 void IAP_Flash_EraseApp(void);
+uint8_t IAP_ImageValid(void);
 void IAP_JumpToApplication(void);
 void IAP_Run(void);
 void IAP_ParseFrame(uint8_t *buf, uint16_t len);
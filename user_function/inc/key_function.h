@@ -0,0 +1,47 @@
+/* define to prevent recursive inclusion -------------------------------------*/
+#ifndef __KEY_FUNCTION_H
+#define __KEY_FUNCTION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* includes ------------------------------------------------------------------*/
+#include "stm32g4xx_hal.h"
+
+/*
+  事件驱动按键引擎:
+  - KEY1-KEY4 双边沿 EXTI 触发后启动 TIM7 单次定时消抖, 空闲时无任何周期性开销
+  - 消抖确认后产生 按下/释放 事件, 按住期间由同一单次定时器调度 长按/连发 事件
+  - 事件写入队列 (中断中产生), 由主循环取出处理
+*/
+#define KEY_ID_MODE         1               // KEY1: 功能键
+#define KEY_ID_UP           2               // KEY2: 加键
+#define KEY_ID_DOWN         3               // KEY3: 减键
+#define KEY_ID_SHIFT        4               // KEY4: 移位键
+#define KEY_ID_RESET        5               // KEY2 + KEY3 组合: 复位报错
+
+#define KEY_EVT_PRESS       1               // 按下 (消抖确认)
+#define KEY_EVT_RELEASE     2               // 释放
+#define KEY_EVT_LONG        3               // 长按 (组合键为保持 KEY_COMBO_MS)
+#define KEY_EVT_REPEAT      4               // 连发 (加/减键长按后, 按 ACCEL_* 加速)
+
+#define KEY_COMBO_MS        50              // 组合键保持时间 (防误触)
+#define KEY_QUEUE_SIZE      8               // 事件队列深度 (2 的幂)
+
+/* 按键事件 */
+typedef struct {
+    uint8_t Key;                            // KEY_ID_xxx
+    uint8_t Type;                           // KEY_EVT_xxx
+} strKeyEvent;
+
+/* exported functions ------------------------------------------------------- */
+void Key_Init(void);
+void Key_TimerHandler(void);
+uint8_t Key_GetEvent(strKeyEvent *evt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
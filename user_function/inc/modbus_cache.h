@@ -0,0 +1,33 @@
+/* define to prevent recursive inclusion -------------------------------------*/
+#ifndef __MODBUS_CACHE_H
+#define __MODBUS_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* includes ------------------------------------------------------------------*/
+#include "modbus_function.h"
+
+/*
+  从站读应答缓存:
+  - 按 (功能码, 起始地址, 数量) 缓存完整应答帧 (含 CRC), 命中时直接交给 DMA 发送
+  - 每个寄存器区维护一个写入代数 (generation), 寄存器值变化时递增并记录到该寄存器
+  - 缓存项代数落后时, 仅重写代数更新过的寄存器, 再补 CRC
+*/
+#define MODBUS_CACHE_ENTRIES        4           // 缓存项数 (主机常用轮询窗口数)
+#define MODBUS_CACHE_FRAME_SIZE     (5 + MODBUS_REGISTER_COUNT * 2)
+
+#define MODBUS_REGION_HOLDING       0           // Slave.DisplayRegisters (03/06/10)
+#define MODBUS_REGION_INPUT         1           // Master.DisplayRegisters (04, 含继电器状态)
+#define MODBUS_REGION_COUNT         2
+
+/* exported functions ------------------------------------------------------- */
+void ModBus_RegWrite(uint8_t region, uint16_t idx, uint16_t value);
+void ModBus_CacheReply(uint8_t func, uint16_t addr, uint16_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -12,12 +12,16 @@ extern "C" {
 
 /* ĴС */
 #define MODBUS_REGISTER_COUNT 58
+/* 10H ֡дĴ (Modbus Э, ModBus_SlaveRx10DataCollation Χ, 쳣 03) */
+#define MODBUS_WRITE_MAX_REGS 123
 
 /* Modbus  */
 #define MODBUS_FUNC_READ_HOLDING_REGISTERS  0x03
 #define MODBUS_FUNC_READ_INPUT_REGISTERS    0x04
 #define MODBUS_FUNC_WRITE_SINGLE_REGISTER   0x06
+#define MODBUS_FUNC_WRITE_MULTIPLE_COILS    0x0F
 #define MODBUS_FUNC_WRITE_MULTIPLE_REGISTERS 0x10
+#define MODBUS_FUNC_READ_FILE_RECORD        0x14
 
 #define FirmwareVersion  1.0
 /* Modbus ״̬ö */
@@ -40,9 +44,9 @@ typedef struct{
 	uint16_t	DataAddr;
 	uint8_t		DataCountHigh;
 	uint8_t		DataCountLow;
-	uint8_t     DataHigh[MODBUS_REGISTER_COUNT]; // С
-	uint8_t     DataLow[MODBUS_REGISTER_COUNT];
-	uint16_t    Data[MODBUS_REGISTER_COUNT];
+	uint8_t     DataHigh[MODBUS_WRITE_MAX_REGS]; // С
+	uint8_t     DataLow[MODBUS_WRITE_MAX_REGS];
+	uint16_t    Data[MODBUS_WRITE_MAX_REGS];
 	uint8_t		DataSize; // ֽ
 	uint8_t		CRCLow;
 	uint8_t		CRCHigh;
@@ -72,8 +76,22 @@ typedef struct{
     struct {
         uint8_t  SlaveADDR;   // Ĵվַ
         uint16_t StartAddr;   // ʼĴַ
+        uint8_t  Func;        // Ĺ (03/04)
+        uint8_t  Count;       // ļĴ
+        uint8_t  DestIdx;     // д DisplayRegisters ʼ±
     } LastReq;
 
+    // ѯ״̬ͳ (ѭз)
+    uint8_t     State;        // ǰ״̬ ( modbus_master.h)
+    uint8_t     ReqIdx;       // ǰѯ
+    uint8_t     Retry;        // ǰط
+    uint8_t     Exception;    // һ쳣Ӧ
+    uint32_t    TxTick;       // 󷢳ʱ (ms)
+    uint32_t    RxTick;       // һ֡ʱ (ms), ֡
+    uint32_t    OkCount;      // ɹӦ
+    uint32_t    TimeoutCount; // ʱ
+    uint32_t    ErrorCount;   // CRC/ʽ/쳣Ӧ
+
 } strModBusMaster;
 
 // ӻṹ
@@ -83,6 +101,10 @@ typedef struct{
 	strModBusRx	Rx;
 	strModBusTx Tx;
   uint16_t    DisplayRegisters[MODBUS_REGISTER_COUNT]; // 洢д
+
+  // ͳ (dP )
+  uint32_t    FrameCount;    // վַ֡
+  uint32_t    CrcErrorCount; // CRC 
 } strModBusSlave;
 
 typedef struct{
@@ -91,9 +113,9 @@ typedef struct{
 } strModBus;
 
 extern volatile strModBus   ModBus;
+uint16_t Modbus_CRC16(volatile uint8_t * Data, uint8_t Len);
 void ModBus_SlaveRx(void);
 void Usart1_ReceiveStringHandler(void);
-void Usart1_SendStringHandler(void);
 #ifdef __cplusplus
 }
 #endif
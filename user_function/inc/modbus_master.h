@@ -0,0 +1,45 @@
+/* define to prevent recursive inclusion -------------------------------------*/
+#ifndef __MODBUS_MASTER_H
+#define __MODBUS_MASTER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* includes ------------------------------------------------------------------*/
+#include "stm32g4xx_hal.h"
+#include "modbus_function.h"
+
+/* 外部仪表总线参数 (LPUART1, RS485, 引脚见 uart_config.h) */
+#define MODBUS_MASTER_BAUDRATE      19200
+#define MODBUS_MASTER_TIMEOUT_MS    100     // 应答超时 (ms)
+#define MODBUS_MASTER_RETRY         2       // 超时/校验错误后的重发次数
+#define MODBUS_MASTER_GAP_MS        2       // 帧间静默时间 (>= 3.5 字符)
+
+/* Master.DisplayRegisters 布局: 0-7 为继电器状态, 8 起为外部仪表数据 */
+#define MODBUS_MASTER_REG_BASE      8
+
+/* 主站状态 */
+typedef enum {
+    MB_MASTER_IDLE = 0,                     // 空闲, 等待帧间隔后发送下一请求
+    MB_MASTER_WAIT_RESP                     // 已发出请求, 等待应答
+} ModbusMasterState_t;
+
+/* 轮询表项: 每项对应一次 03/04 读请求 */
+typedef struct {
+    uint8_t  SlaveADDR;                     // 仪表站号
+    uint8_t  Func;                          // 功能码 (03/04)
+    uint16_t StartAddr;                     // 仪表寄存器起始地址
+    uint8_t  Count;                         // 寄存器数量
+    uint8_t  DestIdx;                       // 写入 Master.DisplayRegisters 的起始下标
+} strModBusMasterReq;
+
+/* exported functions ------------------------------------------------------- */
+void ModBus_MasterInit(void);
+void ModBus_MasterPoll(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
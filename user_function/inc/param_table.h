@@ -0,0 +1,102 @@
+/* define to prevent recursive inclusion -------------------------------------*/
+#ifndef __PARAM_TABLE_H
+#define __PARAM_TABLE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* includes ------------------------------------------------------------------*/
+#include "DigitalTube_Control.h"
+#include "uart_config.h"
+#include "relay_control.h"
+
+// ================= PA 参数分配 =================
+#define PA_IDX_UART1_BAUD   10                  // PA010: USART1 波特率 (0=默认, 1=自动检测, 其余为固定值)
+#define PA_IDX_DISP_BRIGHT  11                  // PA011: 数码管亮度等级 (0=默认最亮, 1 ~ DTC_BRIGHT_LEVELS)
+#define PA_IDX_RELAY_DEADTIME 12                // PA012: 互锁组先断后合死区时间 (ms, 0=默认 RELAY_DEADTIME_DEFAULT_MS)
+
+// ================= dP 诊断量分配 (只读, 按属性表读取函数实时读取) =================
+#define DP_IDX_TORQUE       1                   // dP001: 扭矩传感器 扭矩
+#define DP_IDX_SPEED        2                   // dP002: 扭矩传感器 转速
+#define DP_IDX_MB_OK        3                   // dP003: 主站成功应答计数
+#define DP_IDX_MB_TIMEOUT   4                   // dP004: 主站超时计数
+#define DP_IDX_MB_ERROR     5                   // dP005: 主站 CRC/格式/异常应答计数
+#define DP_IDX_UPTIME       6                   // dP006: 运行时间 (s)
+#define DP_IDX_SL_FRAMES    7                   // dP007: 从站本站地址帧计数
+#define DP_IDX_SL_CRC_ERR   8                   // dP008: 从站 CRC 错误计数
+#define DP_IDX_FLASH_ERASE  9                   // dP009: Flash 参数页擦除次数 (Page A/B, 上电以来)
+#define DP_IDX_SCAN_CYC     10                  // dP010: 数码管扫描中断耗时 (平均, CPU 周期, 取自 PERF_TIM6)
+#define DP_IDX_SCAN_CYC_MAX 11                  // dP011: 数码管扫描中断耗时 (最大值, CPU 周期, 取自 PERF_TIM6)
+#define DP_IDX_RELAY_OPS    12                  // dP012 ~ dP019: 继电器 K1 ~ K8 累计动作次数
+#define DP_IDX_CPU_LOAD     20                  // dP020: CPU 占用 (含中断, 1s 窗口, 0.1%)
+#define DP_IDX_CPU_LOAD10   21                  // dP021: CPU 占用 (10s 平均, 0.1%)
+#define DP_IDX_STACK_USED   22                  // dP022: 栈使用高水位 (字节)
+#define DP_IDX_STACK_SIZE   23                  // dP023: 栈区大小 (字节)
+#define DP_IDX_LOG_ERASE    24                  // dP024: Flash 记录流页擦除次数 (继电器动作计数, 上电以来)
+
+/*
+  参数属性声明表 (唯一来源): 未列出的参数使用默认属性 (16位有符号十进制, -9999 ~ 9999)
+  编号须为十进制常数或展开为十进制常数的宏 (用于编译期查重)
+  读取函数不为 0 的参数不使用参数数组, 每次读取时调用 (定义于 param_table.c)
+  新增/修改条目会改变 Param_SchemaId(), 已保存的参数在上电时按新范围重新校验
+*/
+//  X(名称,        组, 编号,                符号,     进制,    位宽,   最小值,       最大值,             读取函数)
+#define PARAM_LIST(X) \
+    X(PA_BIG,       PA, 0,                   SIGNED,   FMT_DEC, BIT_32, -2000000000, 2000000000,        0                   ) \
+    X(PA_HEX,       PA, 1,                   UNSIGNED, FMT_HEX, BIT_16, 0,           0xFFFF,            0                   ) \
+    X(UART1_BAUD,   PA, PA_IDX_UART1_BAUD,   UNSIGNED, FMT_DEC, BIT_32, 0,           USART1_BAUD_MAX,   0                   ) \
+    X(DISP_BRIGHT,  PA, PA_IDX_DISP_BRIGHT,  UNSIGNED, FMT_DEC, BIT_16, 0,           DTC_BRIGHT_LEVELS, 0                   ) \
+    X(RELAY_DEAD,   PA, PA_IDX_RELAY_DEADTIME, UNSIGNED, FMT_DEC, BIT_16, 0,         RELAY_DEADTIME_MAX_MS, 0               ) \
+    X(DP_BITS,      DP, 0,                   UNSIGNED, FMT_DEC, BIT_32, 0,           0xF,               0                   ) \
+    X(TORQUE,       DP, DP_IDX_TORQUE,       SIGNED,   FMT_DEC, BIT_32, -2000000000, 2000000000,        Param_GetTorque     ) \
+    X(SPEED,        DP, DP_IDX_SPEED,        SIGNED,   FMT_DEC, BIT_32, -2000000000, 2000000000,        Param_GetSpeed      ) \
+    X(MB_OK,        DP, DP_IDX_MB_OK,        UNSIGNED, FMT_DEC, BIT_32, 0,           0x7FFFFFFF,        Param_GetMasterOk   ) \
+    X(MB_TIMEOUT,   DP, DP_IDX_MB_TIMEOUT,   UNSIGNED, FMT_DEC, BIT_32, 0,           0x7FFFFFFF,        Param_GetMasterTmo  ) \
+    X(MB_ERROR,     DP, DP_IDX_MB_ERROR,     UNSIGNED, FMT_DEC, BIT_32, 0,           0x7FFFFFFF,        Param_GetMasterErr  ) \
+    X(UPTIME,       DP, DP_IDX_UPTIME,       UNSIGNED, FMT_DEC, BIT_32, 0,           0x7FFFFFFF,        Param_GetUptime     ) \
+    X(SL_FRAMES,    DP, DP_IDX_SL_FRAMES,    UNSIGNED, FMT_DEC, BIT_32, 0,           0x7FFFFFFF,        Param_GetSlaveFrames) \
+    X(SL_CRC_ERR,   DP, DP_IDX_SL_CRC_ERR,   UNSIGNED, FMT_DEC, BIT_32, 0,           0x7FFFFFFF,        Param_GetSlaveCrcErr) \
+    X(FLASH_ERASE,  DP, DP_IDX_FLASH_ERASE,  UNSIGNED, FMT_DEC, BIT_32, 0,           0x7FFFFFFF,        Param_GetFlashErase ) \
+    X(SCAN_CYC,     DP, DP_IDX_SCAN_CYC,     UNSIGNED, FMT_DEC, BIT_32, 0,           0x7FFFFFFF,        Param_GetScanCyc    ) \
+    X(SCAN_CYC_MAX, DP, DP_IDX_SCAN_CYC_MAX, UNSIGNED, FMT_DEC, BIT_32, 0,           0x7FFFFFFF,        Param_GetScanCycMax ) \
+    X(RELAY_OPS1,   DP, 12,                  UNSIGNED, FMT_DEC, BIT_32, 0,           0x7FFFFFFF,        Param_GetRelayOps1  ) \
+    X(RELAY_OPS2,   DP, 13,                  UNSIGNED, FMT_DEC, BIT_32, 0,           0x7FFFFFFF,        Param_GetRelayOps2  ) \
+    X(RELAY_OPS3,   DP, 14,                  UNSIGNED, FMT_DEC, BIT_32, 0,           0x7FFFFFFF,        Param_GetRelayOps3  ) \
+    X(RELAY_OPS4,   DP, 15,                  UNSIGNED, FMT_DEC, BIT_32, 0,           0x7FFFFFFF,        Param_GetRelayOps4  ) \
+    X(RELAY_OPS5,   DP, 16,                  UNSIGNED, FMT_DEC, BIT_32, 0,           0x7FFFFFFF,        Param_GetRelayOps5  ) \
+    X(RELAY_OPS6,   DP, 17,                  UNSIGNED, FMT_DEC, BIT_32, 0,           0x7FFFFFFF,        Param_GetRelayOps6  ) \
+    X(RELAY_OPS7,   DP, 18,                  UNSIGNED, FMT_DEC, BIT_32, 0,           0x7FFFFFFF,        Param_GetRelayOps7  ) \
+    X(RELAY_OPS8,   DP, 19,                  UNSIGNED, FMT_DEC, BIT_32, 0,           0x7FFFFFFF,        Param_GetRelayOps8  ) \
+    X(CPU_LOAD,     DP, DP_IDX_CPU_LOAD,     UNSIGNED, FMT_DEC, BIT_16, 0,           1000,              Param_GetCpuLoad    ) \
+    X(CPU_LOAD10,   DP, DP_IDX_CPU_LOAD10,   UNSIGNED, FMT_DEC, BIT_16, 0,           1000,              Param_GetCpuLoad10  ) \
+    X(STACK_USED,   DP, DP_IDX_STACK_USED,   UNSIGNED, FMT_DEC, BIT_32, 0,           0xFFFF,            Param_GetStackUsed  ) \
+    X(STACK_SIZE,   DP, DP_IDX_STACK_SIZE,   UNSIGNED, FMT_DEC, BIT_32, 0,           0xFFFF,            Param_GetStackSize  ) \
+    X(LOG_ERASE,    DP, DP_IDX_LOG_ERASE,    UNSIGNED, FMT_DEC, BIT_32, 0,           0x7FFFFFFF,        Param_GetLogErase   )
+
+#define PARAM_GROUP_PA      0
+#define PARAM_GROUP_DP      1
+#define PARAM_SIZE_PA       PA_SIZE
+#define PARAM_SIZE_DP       DP_SIZE
+
+/* PA 参数 Modbus 映射: PAn 占两个保持寄存器, BASE + 2n 为高 16 位, BASE + 2n + 1 为低 16 位 */
+#define PARAM_MODBUS_BASE   0x1000
+#define PARAM_MODBUS_END    (PARAM_MODBUS_BASE + PA_SIZE * 2)
+/* dP 诊断量 Modbus 映射 (只读, 03 读): 排列同 PA, 读取函数在接收中断中调用, 须只读 RAM 变量 */
+#define PARAM_MODBUS_DP_BASE 0x1800
+#define PARAM_MODBUS_DP_END (PARAM_MODBUS_DP_BASE + DP_SIZE * 2)
+
+/* exported functions ------------------------------------------------------- */
+const DTC_ParamConfig_t *Param_GetConfig(uint8_t group, uint16_t index);
+uint8_t Param_Check(uint8_t group, uint16_t index, int32_t value);
+uint8_t Param_Sanitize(int32_t *buffer, uint8_t group, uint16_t count);
+uint32_t Param_SchemaId(void);
+int32_t Param_GetValue(uint8_t group, uint16_t index);
+uint8_t Param_ModbusRead(uint16_t addr, uint16_t count, volatile uint8_t *dst);
+uint8_t Param_ModbusWrite(uint16_t addr, uint16_t count, const volatile uint16_t *src);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,94 @@
+/* define to prevent recursive inclusion -------------------------------------*/
+#ifndef __PERF_FUNCTION_H
+#define __PERF_FUNCTION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* includes ------------------------------------------------------------------*/
+#include "stm32g4xx_hal.h"
+
+/*
+  代码段耗时统计 (DWT 周期计数):
+  - 在代码段首尾放置 PERF_BEGIN(id) / PERF_END(id), 记录执行次数/最短/最长/累计周期
+  - 同一代码段只能在同一优先级的上下文中执行 (中断处理函数或调度任务), 记录时无需关中断
+  - 统计值已扣除一次 PERF_BEGIN/PERF_END 本身的开销 (Perf_Init 中测得)
+  - 发布版本在编译器预定义中加入 PERF_ENABLE=0, 宏展开为空, 统计表与读出接口一并去除
+*/
+#ifndef PERF_ENABLE
+#define PERF_ENABLE         1
+#endif
+
+/* 代码段列表: X(编号, 名称) */
+#define PERF_SECTION_LIST(X) \
+    X(SYSTICK,      "SysTick"   ) \
+    X(USART1,       "USART1"    ) \
+    X(USART3,       "USART3"    ) \
+    X(LPUART1,      "Lpuart1"   ) \
+    X(TIM6,         "DispScan"  ) \
+    X(TIM7,         "KeyTimer"  ) \
+    X(EXTI,         "KeyExti"   ) \
+    X(DMA1_CH1,     "DMA1Ch1"   ) \
+    X(DMA1_CH2,     "DMA1Ch2"   ) \
+    X(DMA1_CH4,     "DMA1Ch4"   ) \
+    X(DMA1_CH5,     "DMA1Ch5"   ) \
+    X(DMA1_CH6,     "DMA1Ch6"   ) \
+    X(DMA2_CH1,     "DMA2Ch1"   ) \
+    X(TIM1,         "TIM1"      ) \
+    X(TIM17,        "DeadTime"  ) \
+    X(MODBUS_RX,    "ModbusRx"  ) \
+    X(CMD,          "Command"   ) \
+    X(TIM2,         "TimeBase"  )
+
+typedef enum {
+#define PERF_ENUM(id, name)     PERF_##id,
+    PERF_SECTION_LIST(PERF_ENUM)
+#undef PERF_ENUM
+    PERF_COUNT
+} PerfId;
+
+#if PERF_ENABLE
+#define PERF_BEGIN(id)      uint32_t perf_t0_##id = DWT->CYCCNT
+#define PERF_END(id)        Perf_Record(PERF_##id, DWT->CYCCNT - perf_t0_##id)
+#else
+#define PERF_BEGIN(id)      ((void)0)
+#define PERF_END(id)        ((void)0)
+#endif
+
+/* 代码段统计 */
+typedef struct {
+    uint32_t Count;             // 执行次数
+    uint32_t MinCycles;         // 最短 (CPU 周期)
+    uint32_t MaxCycles;         // 最长
+    uint64_t TotalCycles;       // 累计
+} strPerfStat;
+
+/*
+  Modbus 映射 (输入寄存器, 04 读, 03 亦可读):
+  BASE + 0   COUNT     代码段数量
+  BASE + 1   CLOCK     CPU 时钟 (MHz, 周期换算时间)
+  BASE + 2   OVERHEAD  已扣除的测量开销 (周期)
+  BASE + 16 + 10n      代码段 n: 次数高/低, 最短高/低, 最长高/低, 累计 (64 位, 高字在前)
+*/
+#define PERF_MODBUS_BASE    0x3000
+#define PERF_REG_COUNT      0
+#define PERF_REG_CLOCK      1
+#define PERF_REG_OVERHEAD   2
+#define PERF_REG_TABLE      16
+#define PERF_REG_STRIDE     10
+#define PERF_MODBUS_END     (PERF_MODBUS_BASE + PERF_REG_TABLE + PERF_COUNT * PERF_REG_STRIDE)
+
+/* exported functions ------------------------------------------------------- */
+void Perf_Init(void);
+void Perf_Record(PerfId id, uint32_t cycles);
+void Perf_Reset(void);
+uint8_t Perf_Get(PerfId id, strPerfStat *stat);
+const char *Perf_GetName(PerfId id);
+uint8_t Perf_ModbusRead(uint16_t addr, uint16_t count, volatile uint8_t *dst);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
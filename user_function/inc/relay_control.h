@@ -11,16 +11,59 @@ extern "C" {
 
 /* defines -------------------------------------------------------------------*/
 #define RELAY_COUNT     8
+#define RELAY_PORT      GPIOA                   // K1-K8 = PA0-PA7 (bit0 = K1)
+#define RELAY_MASK_ALL  0xFFU
+
+/*
+  继电器组操作: 任意 置位/清零 掩码合成一个 BSRR 字, 一次写入, 8 路同时切换 (无先后偏差)
+  BSRR 高 16 位清零, 低 16 位置位, 同一位同时置位/清零时置位优先
+*/
+#define RELAY_BSRR(set, clr)    (((uint32_t)((clr) & RELAY_MASK_ALL) << 16) | ((set) & RELAY_MASK_ALL))
+
+/*
+  继电器动作计数 (触点寿命): 每次写 BSRR 后与上次状态比较, 实际翻转的继电器各计 1 次
+  计数常驻 RAM, 由 Relay_OpsPoll 延迟写入 Flash 记录流 (满 RELAY_OPS_SAVE_MS 或累计 RELAY_OPS_SAVE_COUNT 次),
+  掉电最多丢失一个保存周期内的计数
+*/
+#define RELAY_OPS_SAVE_MS       600000U         // 有新计数时的最长保存间隔 (10 min)
+#define RELAY_OPS_SAVE_COUNT    1000U           // 未保存动作次数达到此值时立即保存
+
+/*
+  互锁组 (先断后合): 组定义见 relay_control.c 常量表 RelayInterlock[], 组内同一时刻最多一个继电器导通
+  - 一次请求闭合同组两个以上继电器: 拒绝 (RELAY_ERR_INTERLOCK)
+  - 闭合组内另一个继电器: 先断开已导通的成员, TIM17 单次定时死区时间后再闭合 (中断中完成, 不阻塞)
+  - 死区时间内再次请求闭合该组成员: 拒绝 (RELAY_ERR_BUSY), 断开请求随时生效并取消待闭合
+  - 时序引擎播放期间: 拒绝全部请求 (RELAY_ERR_BUSY, 含全部断开), 须先停止播放
+  死区时间由 PA 参数 PA_IDX_RELAY_DEADTIME 配置 (ms, 0 = RELAY_DEADTIME_DEFAULT_MS)
+*/
+#define RELAY_DEADTIME_DEFAULT_MS   20U
+#define RELAY_DEADTIME_MAX_MS       5000U       // TIM17 0.1ms 计数, 16 位定时上限 6.5s
+
+/* Relay_Apply 等返回值 */
+#define RELAY_OK                0
+#define RELAY_ERR_INTERLOCK     1               // 请求同时闭合同一互锁组的多个继电器
+#define RELAY_ERR_BUSY          2               // 该组正在先断后合的死区时间内, 或时序引擎正在播放
 
 /* function prototypes -------------------------------------------------------*/
 void Relay_Init(void);
-void Relay_On(uint8_t relayNum);
+uint8_t Relay_On(uint8_t relayNum);
 void Relay_Off(uint8_t relayNum);
-void Relay_Toggle(uint8_t relayNum);
-void Relay_AllOn(void);
+uint8_t Relay_Toggle(uint8_t relayNum);
+uint8_t Relay_AllOn(void);
 void Relay_AllOff(void);
 uint8_t Relay_GetStatus(uint8_t relayNum);
-void Relay_SetMultiple(uint8_t mask, uint8_t state);
+uint8_t Relay_SetMultiple(uint8_t mask, uint8_t state);
+uint8_t Relay_Apply(uint8_t set, uint8_t clr);
+uint8_t Relay_SetMask(uint8_t mask);
+uint8_t Relay_GetMask(void);
+uint8_t Relay_CheckInterlock(uint8_t mask);
+uint8_t Relay_GetPending(void);
+void Relay_DeadTimeHandler(void);
+void Relay_CountOps(uint8_t mask);
+uint32_t Relay_GetOps(uint8_t relayNum);
+void Relay_ResetOps(uint8_t relayNum);
+void Relay_OpsInit(void);
+void Relay_OpsPoll(void);
 
 #ifdef __cplusplus
 }
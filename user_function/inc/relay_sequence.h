@@ -0,0 +1,84 @@
+/* define to prevent recursive inclusion -------------------------------------*/
+#ifndef __RELAY_SEQUENCE_H
+#define __RELAY_SEQUENCE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* includes ------------------------------------------------------------------*/
+#include "stm32g4xx_hal.h"
+
+/*
+  继电器时序引擎:
+  - 时序表为 (时间偏移 us, BSRR 字) 条目, 偏移相对启动时刻, 须严格递增且间隔 >= RSEQ_MIN_GAP_US
+  - 启动时编译为 TIM1 周期表: TIM1 (1MHz) 每次更新事件由 DMA 将下一个 BSRR 字写入 GPIOA->BSRR,
+    CC1 (CNT = 1) 事件由 DMA 装载下一周期的 ARR (预装载), 播放期间无 CPU 参与
+  - 超过 TIM1 计数范围的间隔自动插入空操作步骤 (BSRR = 0)
+  - 最后一步写入后 DMA 传输完成中断停止 TIM1, 记录实际耗时 (64 位时基)
+*/
+#define RSEQ_MAX_ENTRIES    32              // 时序表条目数
+#define RSEQ_MAX_STEPS      128             // 编译后步骤数 (含插入的空操作)
+#define RSEQ_MIN_GAP_US     2               // 相邻条目最小间隔 (TIM1 周期 >= 2, CC1 于 CNT = 1 装载 ARR)
+#define RSEQ_LEAD_US        RSEQ_MIN_GAP_US // 启动到偏移 0 的固定延时
+
+/* 运行状态 */
+#define RSEQ_STATE_IDLE     0
+#define RSEQ_STATE_RUNNING  1
+#define RSEQ_STATE_DONE     2
+#define RSEQ_STATE_ABORTED  3
+#define RSEQ_STATE_ERROR    4
+
+/* 启动错误码 */
+#define RSEQ_ERR_NONE       0
+#define RSEQ_ERR_EMPTY      1               // 时序表为空
+#define RSEQ_ERR_MASK       2               // BSRR 字含 K1-K8 以外的引脚
+#define RSEQ_ERR_ORDER      3               // 偏移未递增或间隔过小
+#define RSEQ_ERR_LONG       4               // 编译后步骤数超过 RSEQ_MAX_STEPS
+#define RSEQ_ERR_BUSY       5               // 正在播放或互锁组先断后合进行中
+#define RSEQ_ERR_INTERLOCK  6               // 某一步后互锁组内多个继电器同时导通 (死区时间须在时序表中安排)
+
+/*
+  Modbus 映射 (保持寄存器, 03 读 / 06, 10 写):
+  BASE + 0   CTRL      写 1 = 启动, 0 = 停止; 读为运行状态 RSEQ_STATE_xxx
+  BASE + 1   COUNT     时序表条目数
+  BASE + 2   DONE      已执行条目数 (只读)
+  BASE + 3   ERROR     最近一次启动错误码 (只读)
+  BASE + 4/5 START     启动时刻 (HAL_GetTick, ms, 高/低 16 位, 只读)
+  BASE + 6/7 ELAPSED   启动到最后一步的实际耗时 (us, 高/低 16 位, 只读)
+  BASE + 16 + 4n       条目 n: 偏移高, 偏移低, BSRR 高, BSRR 低
+  10H 单帧最多 MODBUS_WRITE_MAX_REGS (123) 个寄存器, 完整时序表分两帧上传, 最后写 CTRL 启动
+*/
+#define RSEQ_MODBUS_BASE    0x2000
+#define RSEQ_REG_CTRL       0
+#define RSEQ_REG_COUNT      1
+#define RSEQ_REG_DONE       2
+#define RSEQ_REG_ERROR      3
+#define RSEQ_REG_START      4
+#define RSEQ_REG_ELAPSED    6
+#define RSEQ_REG_TABLE      16
+#define RSEQ_MODBUS_END     (RSEQ_MODBUS_BASE + RSEQ_REG_TABLE + RSEQ_MAX_ENTRIES * 4)
+
+/* 时序表条目 */
+typedef struct {
+    uint32_t Offset;                        // 相对启动时刻 (us)
+    uint32_t Bsrr;                          // 写入 GPIOA->BSRR 的值 (仅 K1-K8 对应位, 见 RELAY_BSRR)
+} strRelaySeqEntry;
+
+/* exported functions ------------------------------------------------------- */
+void RelaySeq_Init(void);
+uint8_t RelaySeq_Start(void);
+void RelaySeq_Stop(void);
+void RelaySeq_DmaHandler(void);
+uint8_t RelaySeq_GetState(void);
+uint8_t RelaySeq_IsRunning(void);
+uint8_t RelaySeq_GetDone(void);
+uint32_t RelaySeq_GetElapsed(void);
+uint8_t RelaySeq_ModbusRead(uint16_t addr, uint16_t count, volatile uint8_t *dst);
+uint8_t RelaySeq_ModbusWrite(uint16_t addr, uint16_t count, const volatile uint16_t *src);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,64 @@
+/* define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SCHED_FUNCTION_H
+#define __SCHED_FUNCTION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* includes ------------------------------------------------------------------*/
+#include "stm32g4xx_hal.h"
+
+/*
+  协作式调度器 (运行至完成):
+  - 中断只采集数据并投递任务 (Sched_Post), 处理在主循环中按优先级逐个执行, 任务之间不抢占
+  - 周期任务由 SysTick (Sched_Tick) 按任务表周期投递
+  - 无就绪任务时关中断检查后 WFI 休眠, 任一中断唤醒 (无丢失唤醒窗口)
+  - 每个任务统计执行次数/最长耗时/上一统计窗口 CPU 占用 (DWT 周期计数)
+  - 整机 CPU 占用 (含中断) 按空闲休眠时间计算, 给出 1s 窗口与 10s 平均两个值
+  - 栈区上电涂写填充值, 每个统计窗口扫描一次得到使用高水位 (中断嵌套最深时的栈用量)
+*/
+
+/* 任务编号 = 优先级 (0 最高), 同时就绪时编号小的先执行 */
+typedef enum {
+    SCHED_TASK_MODBUS = 0,      // Modbus 从站帧处理 (USART1 空闲中断投递)
+    SCHED_TASK_CMD,             // 文本命令 (USART1 空闲中断投递)
+    SCHED_TASK_MASTER,          // Modbus 主站状态机 (LPUART1 帧完成投递 + 周期)
+    SCHED_TASK_KEY,             // 按键事件 (EXTI/TIM7 投递)
+    SCHED_TASK_STREAM,          // 流模式发送调度
+    SCHED_TASK_DISPLAY,         // 数码管显存渲染 (动画/消息/监控)
+    SCHED_TASK_BAUD,            // USART1 波特率切换确认/回退
+    SCHED_TASK_FLASH,           // Flash 延迟写入 (按键参数保存, 继电器动作计数)
+    SCHED_TASK_STATS,           // 统计窗口滚动 (CPU 占用)
+    SCHED_TASK_COUNT
+} SchedTaskId;
+
+#define SCHED_STATS_MS      1000        // CPU 占用统计窗口
+#define SCHED_CPU_LONG_WINS 10          // 长窗口 = 10 个统计窗口 (10s)
+
+/* 任务统计 */
+typedef struct {
+    uint32_t Runs;              // 累计执行次数
+    uint32_t MaxCycles;         // 单次最长耗时 (CPU 周期)
+    uint32_t WinCycles;         // 当前窗口累计耗时
+    uint16_t Load;              // 上一窗口 CPU 占用 (0.1%)
+} strSchedStat;
+
+/* exported functions ------------------------------------------------------- */
+void Sched_Post(SchedTaskId id);
+void Sched_Tick(void);
+void Sched_Run(void);
+const char *Sched_GetName(SchedTaskId id);
+const strSchedStat *Sched_GetStat(SchedTaskId id);
+uint16_t Sched_GetLoad(void);
+void Sched_StackPaint(void);
+uint16_t Sched_GetCpuLoad(void);
+uint16_t Sched_GetCpuLoadLong(void);
+uint16_t Sched_GetStackUsed(void);
+uint16_t Sched_GetStackSize(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,50 @@
+/* define to prevent recursive inclusion -------------------------------------*/
+#ifndef __STREAM_FUNCTION_H
+#define __STREAM_FUNCTION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* includes ------------------------------------------------------------------*/
+#include "stm32g4xx_hal.h"
+
+/*
+  二进制流模式帧格式 (小端):
+  | 0xA5 | 0x5A | type(1) | seq(2) | len(2) | payload(len) | crc16(2) |
+  crc16 为 Modbus CRC16, 覆盖 type ~ payload
+*/
+#define STREAM_HEADER1          0xA5U
+#define STREAM_HEADER2          0x5AU
+#define STREAM_TYPE_SAMPLES     0x01U       // 采样批次: N x strStreamSample
+#define STREAM_TYPE_STATS       0x02U       // 统计信息
+#define STREAM_TYPE_END         0x03U       // 流结束 (命令停止或超时)
+
+#define STREAM_BAUDRATE         2000000     // 流模式波特率
+#define STREAM_CHANNELS         4           // 每个采样点的通道数
+#define STREAM_RING_SIZE        256         // 采样环形缓冲深度 (2 的幂)
+#define STREAM_BATCH_SAMPLES    32          // 每帧最多采样点数
+#define STREAM_FLUSH_MS         20          // 不足一批时的最长等待时间
+#define STREAM_STATS_EVERY      50          // 每 N 个采样帧插入一帧统计
+#define STREAM_KEEPALIVE_MS     5000        // 主机静默超时 (ms), 超时自动退出
+
+/* 单个采样点 */
+typedef struct {
+    uint32_t Tick;                          // 采样时刻 (ms)
+    int32_t  Value[STREAM_CHANNELS];        // 通道数据
+} strStreamSample;
+
+/* exported functions ------------------------------------------------------- */
+void Stream_Start(void);
+void Stream_Stop(void);
+uint8_t Stream_IsActive(void);
+void Stream_KeepAlive(void);
+void Stream_PushSample(const int32_t *value);
+void Stream_SampleTick(void);
+void Stream_Poll(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
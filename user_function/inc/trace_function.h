@@ -0,0 +1,126 @@
+/* define to prevent recursive inclusion -------------------------------------*/
+#ifndef __TRACE_FUNCTION_H
+#define __TRACE_FUNCTION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* includes ------------------------------------------------------------------*/
+#include "stm32g4xx_hal.h"
+#include "delay_function.h"
+
+/*
+  热路径事件追踪 (二进制环形缓冲区):
+  - 每条记录 8 字节: 时间戳 (64 位时基右移 TRACE_TIME_SHIFT 位的低 32 位) + 事件编号 + 参数
+    170MHz 时单位约 1.5us, 约 108 min 回绕; 主机按相邻记录差值展开, 相邻事件间隔须小于回绕周期的一半
+  - 任意优先级可记录, 写位置以 LDREX/STREX 原子占用, 不关中断 (约二三十个周期)
+  - 事件按组 (编号高 4 位) 开关, 冻结时屏蔽全部组, 缓冲区保持不变供读出
+  - 读出: Modbus 14H 读文件记录 (文件 1 = 头, 文件 2 = 记录) 或文本命令 "Trace",
+    主机端 tools/trace_decode.py 解码为时间线 (事件编号须与其中的名称表一致)
+  - 发布版本在编译器预定义中加入 TRACE_ENABLE=0, TRACE() 展开为空
+*/
+#ifndef TRACE_ENABLE
+#define TRACE_ENABLE        1
+#endif
+
+#define TRACE_RECORDS       256             // 记录数 (2 的幂)
+#define TRACE_HOLD_MS       5000            // Modbus 读出冻结保持时间, 最后一次读取后超时自动恢复记录
+#define TRACE_TIME_SHIFT    8               // 时间戳单位 = 2^TRACE_TIME_SHIFT 个 CPU 周期
+
+/* 事件组 (编号高 4 位) */
+#define TRACE_GRP_USART1    0
+#define TRACE_GRP_DMA       1
+#define TRACE_GRP_DISPLAY   2               // TIM6 扫描, 每 1ms 两条, 默认关闭
+#define TRACE_GRP_RELAY     3               // 继电器/TIM1 时序引擎
+#define TRACE_GRP_FLASH     4
+#define TRACE_GRP_LPUART1   5               // 外部仪表总线 (Modbus 主站)
+#define TRACE_GRP_SCHED     6               // 调度任务起止, 默认关闭
+#define TRACE_MASK_DEFAULT  (0xFFFFU & ~((1U << TRACE_GRP_DISPLAY) | (1U << TRACE_GRP_SCHED)))
+
+/* 事件编号 */
+#define TRACE_U1_RX_FRAME   0x00            // USART1 空闲中断收到一帧 (参数: 字节数)
+#define TRACE_U1_TX_START   0x01            // USART1 DMA 发送启动 (参数: 字节数)
+#define TRACE_U1_TX_DONE    0x02            // USART1 发送完成, 切回接收
+#define TRACE_DMA_U1_TX     0x10            // DMA1_Ch2 传输完成 (USART1 TX)
+#define TRACE_DMA_SPI       0x11            // DMA1_Ch1 传输完成 (数码管 SPI2)
+#define TRACE_DMA_LP1_TX    0x12            // DMA2_Ch1 传输完成 (LPUART1 TX)
+#define TRACE_DMA_RSEQ      0x13            // DMA1_Ch6 传输完成 (时序播放结束)
+#define TRACE_DISP_SCAN     0x20            // TIM6 扫描中断 (参数: 1 = 1ms 节拍, 0 = 点亮时隙)
+#define TRACE_RSEQ_START    0x30            // 时序引擎启动 (参数: 编译后步骤数)
+#define TRACE_RSEQ_HALT     0x31            // 时序引擎停止 (参数: 结束状态 RSEQ_STATE_xxx)
+#define TRACE_RELAY_WRITE   0x32            // 继电器输出写入 (参数: 写入后 K1-K8 状态)
+#define TRACE_RELAY_MAKE    0x33            // 先断后合死区结束, 闭合挂起继电器 (参数: 挂起掩码)
+#define TRACE_FLASH_ERASE   0x40            // Flash 页擦除开始 (参数: 页号)
+#define TRACE_FLASH_ERASED  0x41            // Flash 页擦除完成 (参数: 页号)
+#define TRACE_FLASH_LOG     0x42            // 记录流追加 (参数: 记录序号低 16 位)
+#define TRACE_FLASH_PARAMS  0x43            // 参数保存 (参数: 参数个数)
+#define TRACE_LP1_RX_FRAME  0x50            // LPUART1 应答帧接收完成 (参数: 字节数)
+#define TRACE_LP1_TX_DONE   0x51            // LPUART1 请求发送完成, 切回接收
+#define TRACE_TASK_BEGIN    0x60            // 调度任务开始 (参数: 任务编号)
+#define TRACE_TASK_END      0x61            // 调度任务结束 (参数: 任务编号)
+
+/* 记录 */
+typedef struct {
+    uint32_t Time;              // Time_Now() >> TRACE_TIME_SHIFT (低 32 位)
+    uint16_t Id;                // 事件编号
+    uint16_t Arg;               // 参数
+} strTraceRec;
+
+/*
+  Modbus 14H 读文件记录 (参考类型 6, 记录号 = 文件内寄存器偏移):
+  文件 1 (头, 读取时冻结): 0 有效记录数, 1 缓冲区记录数, 2 CPU 时钟 (MHz), 3 事件组掩码 (冻结前),
+                          4/5 累计记录数 (高/低 16 位, 大于缓冲区记录数表示有覆盖), 6 时间戳移位 TRACE_TIME_SHIFT
+  文件 2 (记录, 最旧在前): 记录 n 占寄存器 4n ~ 4n+3: 时间戳高, 时间戳低, 事件编号, 参数
+*/
+#define TRACE_FILE_HEADER   1
+#define TRACE_FILE_RECORDS  2
+#define TRACE_HEADER_REGS   7
+
+extern strTraceRec TraceRing[TRACE_RECORDS];
+extern volatile uint32_t TraceHead;         // 累计占用的记录数 (下一条写入位置)
+extern volatile uint32_t TraceMask;         // bit n = 记录组 n 的事件
+
+/****************************************************************************************
+* 函数名称：Trace_Emit
+* 函数功能：记录一条事件 (任意上下文, 不关中断): 原子占用写位置后填写记录
+* 输入参量：id - 事件编号, arg - 参数
+* 输出参量：无
+****************************************************************************************/
+static __INLINE void Trace_Emit(uint16_t id, uint16_t arg)
+{
+    strTraceRec *r;
+    uint32_t idx;
+
+    if ((TraceMask & (1UL << (id >> 4))) == 0) return;
+    do {
+        idx = __LDREXW(&TraceHead);
+    } while (__STREXW(idx + 1, &TraceHead));
+    r = &TraceRing[idx & (TRACE_RECORDS - 1)];
+    r->Time = (uint32_t)(Time_Now() >> TRACE_TIME_SHIFT);
+    r->Id = id;
+    r->Arg = arg;
+}
+
+#if TRACE_ENABLE
+#define TRACE(id, arg)      Trace_Emit(TRACE_##id, (uint16_t)(arg))
+#else
+#define TRACE(id, arg)      ((void)0)
+#endif
+
+/* exported functions ------------------------------------------------------- */
+void Trace_Freeze(void);
+void Trace_Resume(void);
+void Trace_Clear(void);
+void Trace_SetMask(uint32_t mask);
+uint32_t Trace_GetMask(void);
+uint16_t Trace_Count(void);
+void Trace_Get(uint16_t n, strTraceRec *rec);
+void Trace_Poll(void);
+uint8_t Trace_ModbusReadFile(uint16_t file, uint16_t reg, uint16_t count, volatile uint8_t *dst);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -6,6 +6,9 @@
 ****************************************************************************************/
 #include "DigitalTube_Control.h"
 #include "Flash_Storage.h"
+#include "param_table.h"
+#include "key_function.h"
+#include "sched_function.h"
 #include <string.h>
 
 // 引用外部 SPI 句柄
@@ -51,148 +54,156 @@ const uint8_t DTC_PosTable[] = {0x01, 0x02, 0x04, 0x08, 0x10};
 // DMA 发送缓冲
 static uint8_t DTC_DMA_Buffer[2];
 
+// 按键保存挂起 (由 Flash 任务执行, 见 DTC_SavePoll)
+static uint8_t DTC_SavePending = 0;
+
+
+// 亮度等级 1 ~ DTC_BRIGHT_LEVELS 对应的点亮时间 (us, 近似按人眼感知等比递增)
+// 最高一级也保留 DTC_SCAN_PERIOD_US - 960 = 40us 消隐, 消除换位时的残影
+static const uint16_t DTC_BrightTable[DTC_BRIGHT_LEVELS] = {
+    DTC_ON_MIN_US, 40, 70, 110, 170, 250, 360, 500, 700, 960
+};
+
 // ================= 内部辅助函数 =================
 
 /****************************************************************************************
-* 函数名称：DTC_GetConfig
-* 函数功能：模拟获取每个参数的属性配置 (实际可替换为查表)
+* 函数名称：DTC_BinToBcd
+* 函数功能：32 位无符号数转 10 位十进制数字 (double-dabble, 无除法无分支)
+*           每轮先对所有 >= 5 的 BCD 位并行加 3, 再整体左移一位移入下一个二进制位
 * 输入参量：
-* - group：参数组索引
-* - index：参数编号
-* 输出参量：
-* - DTC_ParamConfig_t：参数属性结构体
-* 编写日期：2026-02-06
+* - val：待转换数值
+* - digits：输出 10 位数字 (个位在前)
+* 输出参量：无
+* 编写日期：2026-10-18
 ****************************************************************************************/
-static DTC_ParamConfig_t DTC_GetConfig(uint8_t group, uint16_t index)
+static void DTC_BinToBcd(uint32_t val, uint8_t *digits)
 {
-    DTC_ParamConfig_t cfg;
-    // 默认配置: 16位有符号十进制
-    cfg.Sign = SIGNED;
-    cfg.Format = FMT_DEC;
-    cfg.Width = BIT_16;
-    cfg.Min = -9999;
-    cfg.Max = 9999;
-
-    // 自定义特殊参数示例
-    if (group == 0 && index == 0) { // PA000: 32位大数
-        cfg.Width = BIT_32; 
-        cfg.Min = -2000000000; 
-        cfg.Max = 2000000000; 
+    uint64_t bcd = 0;
+    uint8_t i;
+
+    for (i = 0; i < 32; i++) {
+        // 半字节 n >= 5 时 n + 3 的 bit3 置位, 据此得到需加 3 的掩码
+        uint64_t adj = (bcd + 0x3333333333ULL) & 0x8888888888ULL;
+        bcd += (adj >> 2) | (adj >> 3);
+        bcd = (bcd << 1) | (val >> 31);
+        val <<= 1;
     }
-    if (group == 0 && index == 1) { // PA001: 16进制
-        cfg.Format = FMT_HEX; 
-        cfg.Min = 0; 
-        cfg.Max = 0xFFFF;
+    for (i = 0; i < 10; i++) {
+        digits[i] = (uint8_t)(bcd & 0xF);
+        bcd >>= 4;
     }
-    if (group == 1 && index == 0) { // DP000: 2进制
-				cfg.Width = BIT_32; 
-        cfg.Format = FMT_DEC; 
-        cfg.Min = 0; 
-        cfg.Max = 0xF;
-    }
-    return cfg;
 }
 
 /****************************************************************************************
-* 函数名称：DTC_Update_Buffer
-* 函数功能：根据当前模式和数据刷新显存
-* 输入参量：无
+* 函数名称：DTC_Render
+* 函数功能：根据当前模式和数据渲染一帧显存
+* 输入参量：raw - 目标帧 (5 位)
 * 输出参量：无
 * 编写日期：2026-02-06
 ****************************************************************************************/
-static void DTC_Update_Buffer(void)
+static void DTC_Render(uint8_t *raw)
 {
-    // 动画模式下不由该函数控制
-    if (DTC_Dev.Mode == DTC_MODE_ANIMATION) return;
-    
-    memset(DTC_Dev.RawData, SEG_OFF, 5); 
+    memset(raw, SEG_OFF, 5); 
 
     // --- 1. 错误显示 Err.20 ---
     if (DTC_Dev.Mode == DTC_MODE_ERROR) {
-        DTC_Dev.RawData[4] = SEG_E; 
-        DTC_Dev.RawData[3] = SEG_r; 
-        DTC_Dev.RawData[2] = SEG_r;
-        DTC_Dev.RawData[1] = (DTC_Dev.ErrCode / 10) % 10; 
-        DTC_Dev.RawData[0] = DTC_Dev.ErrCode % 10;
+        raw[4] = SEG_E; 
+        raw[3] = SEG_r; 
+        raw[2] = SEG_r;
+        raw[1] = (DTC_Dev.ErrCode / 10) % 10; 
+        raw[0] = DTC_Dev.ErrCode % 10;
         return;
     }
 
     // --- 2. 选择界面 (PA 001) ---
     if (DTC_Dev.Mode == DTC_MODE_SELECT) {
-        DTC_Dev.RawData[4] = (DTC_Dev.GroupIdx == 0) ? SEG_P : SEG_d;
-        DTC_Dev.RawData[3] = (DTC_Dev.GroupIdx == 0) ? SEG_A : SEG_P;
-        DTC_Dev.RawData[2] = (DTC_Dev.ParamNum / 100) % 10;
-        DTC_Dev.RawData[1] = (DTC_Dev.ParamNum / 10) % 10;
-        DTC_Dev.RawData[0] = DTC_Dev.ParamNum % 10;
+        raw[4] = (DTC_Dev.GroupIdx == 0) ? SEG_P : SEG_d;
+        raw[3] = (DTC_Dev.GroupIdx == 0) ? SEG_A : SEG_P;
+        raw[2] = (DTC_Dev.ParamNum / 100) % 10;
+        raw[1] = (DTC_Dev.ParamNum / 10) % 10;
+        raw[0] = DTC_Dev.ParamNum % 10;
         return;
     }
 
 
 
     // --- 3. 编辑/查看数值模式 ---
-    DTC_ParamConfig_t cfg = DTC_GetConfig(DTC_Dev.GroupIdx, DTC_Dev.ParamNum);
+    const DTC_ParamConfig_t *cfg = Param_GetConfig(DTC_Dev.GroupIdx, DTC_Dev.ParamNum);
     int32_t val = DTC_Dev.EditVal;
 
     // A. HEX 格式 (H.xxxx)
-    if (cfg.Format == FMT_HEX) {
-        DTC_Dev.RawData[4] = SEG_H;
+    if (cfg->Format == FMT_HEX) {
+        raw[4] = SEG_H;
         for(int i=0; i<4; i++) { 
-            DTC_Dev.RawData[i] = (val >> (i * 4)) & 0xF; 
+            raw[i] = (val >> (i * 4)) & 0xF; 
         }
     }
     // B. BIN 格式 (b.xxxx)
-    else if (cfg.Format == FMT_BIN) {
-        DTC_Dev.RawData[4] = SEG_b;
+    else if (cfg->Format == FMT_BIN) {
+        raw[4] = SEG_b;
         for(int i=0; i<4; i++) { 
-            DTC_Dev.RawData[i] = (val >> i) & 1; 
+            raw[i] = (val >> i) & 1; 
         }
     }
     // C. DEC 格式 (含分页)
     else {
-        uint32_t abs_val = (val < 0) ? -val : val;
+        const uint8_t *digit = DTC_Dev.DecDigits;
+
+        // 数值变化时才重新转换, 翻页/闪烁直接取缓存
+        if (!DTC_Dev.DecValid || DTC_Dev.DecVal != val) {
+            DTC_BinToBcd((val < 0) ? (0U - (uint32_t)val) : (uint32_t)val, DTC_Dev.DecDigits);
+            DTC_Dev.DecVal = val;
+            DTC_Dev.DecValid = 1;
+        }
         
         // 16位数据: 不分页
-        if (cfg.Width == BIT_16) {
-            DTC_Dev.RawData[4] = (val < 0) ? SEG_MINUS : SEG_OFF;
-            for(int i=0; i<4; i++) { 
-                DTC_Dev.RawData[i] = abs_val % 10; 
-                abs_val /= 10; 
-            }
+        if (cfg->Width == BIT_16) {
+            raw[4] = (val < 0) ? SEG_MINUS : SEG_OFF;
+            memcpy(raw, &digit[0], 4);
         }
         // 32位数据: 分页显示
         else {
             if (DTC_Dev.Page == PAGE_LOW) { // 低位: _ 1234
-                DTC_Dev.RawData[4] = SEG_UNDER;
-                for(int i=0; i<4; i++) { 
-                    DTC_Dev.RawData[i] = abs_val % 10; 
-                    abs_val /= 10; 
-                }
+                raw[4] = SEG_UNDER;
+                memcpy(raw, &digit[0], 4);
             }
             else if (DTC_Dev.Page == PAGE_MID) { // 中位: - 5678
-                DTC_Dev.RawData[4] = SEG_MINUS;
-                abs_val /= 10000;
-                for(int i=0; i<4; i++) { 
-                    DTC_Dev.RawData[i] = abs_val % 10; 
-                    abs_val /= 10; 
-                }
+                raw[4] = SEG_MINUS;
+                memcpy(raw, &digit[4], 4);
             }
             else { // 高位: [0xFE]  90
-                DTC_Dev.RawData[4] = SEG_HIGH_FLAG; // 显示特殊顶杠符号
-                abs_val /= 100000000;
-                if (abs_val > 0) {
-                    DTC_Dev.RawData[0] = abs_val % 10;
-                    if (abs_val >= 10) DTC_Dev.RawData[1] = (abs_val / 10) % 10;
-                } else {
-                    DTC_Dev.RawData[0] = 0; // 若无高位，至少显示0
-                }
+                raw[4] = SEG_HIGH_FLAG; // 显示特殊顶杠符号
+                raw[0] = digit[8];      // 若无高位，至少显示0
+                if (digit[9] != 0) raw[1] = digit[9];
             }
         }
     }
 }
 
+/****************************************************************************************
+* 函数名称：DTC_Update_Buffer
+* 函数功能：根据当前模式和数据刷新显存: 渲染到后台帧后切换前台帧编号发布,
+*           扫描中断每次只按编号读取, 不会读到渲染一半的帧 (只在主循环任务中调用)
+* 输入参量：无
+* 输出参量：无
+* 编写日期：2026-02-06
+****************************************************************************************/
+static void DTC_Update_Buffer(void)
+{
+    uint8_t back = DTC_Dev.FrameIdx ^ 1U;
+
+    // 动画模式下不由该函数控制 (见 DTC_HandleStartupAnimation)
+    if (DTC_Dev.Mode == DTC_MODE_ANIMATION) return;
+    DTC_Render(DTC_Dev.Frame[back]);
+    __DMB();                                    // 帧内容先于编号写入
+    DTC_Dev.FrameIdx = back;
+}
+
 /****************************************************************************************
 * 函数名称：DTC_DMA_Transmitter
-* 函数功能：底层 DMA 传输 (阻塞式)
+* 函数功能：底层 DMA 传输 (非阻塞预移入)
+*           数据移入 595 移位寄存器后不立即锁存, 由下一次扫描中断开头的 DTC_RCLK_H() 锁存,
+*           时隙最短 DTC_ON_MIN_US, 远大于 2 字节 SPI 传输时间, 无需等待传输完成
 * 输入参量：
 * - seg：段码数据
 * - pos：位选数据
@@ -204,24 +215,31 @@ static void DTC_DMA_Transmitter(uint8_t seg, uint8_t pos)
     DTC_DMA_Buffer[0] = pos; 
     DTC_DMA_Buffer[1] = seg;
     
-    DTC_RCLK_L(); 
-    
     DMA1_Channel1->CCR &= ~DMA_CCR_EN;  
     DMA1->IFCR = 0x0F;                  // 清除所有中断标志
     DMA1_Channel1->CNDTR = 2;           
     DMA1_Channel1->CCR |= DMA_CCR_EN;   
     
-    // 等待 DMA 传输完成
-    while(!(DMA1->ISR & DMA_ISR_TCIF1)); 
-    // 等待 SPI FIFO 清空
-    while((SPI2->SR & SPI_SR_FTLVL) != 0);
-    // 等待 SPI 总线空闲
-    while(SPI2->SR & SPI_SR_BSY);
-    
-    // 短延时确保锁存稳定
-    for(volatile uint8_t i=0; i<15; i++);
-    
-    DTC_RCLK_H();   
+    // 移位期间 RCLK 电平无影响, 放在 DMA 配置之后拉低以保证锁存脉冲宽度
+    DTC_RCLK_L(); 
+}
+
+/****************************************************************************************
+* 函数名称：DTC_OnTime
+* 函数功能：按亮度等级查点亮时间 (编辑亮度参数时按编辑值实时预览)
+* 输入参量：无
+* 输出参量：点亮时隙长度 (us)
+* 编写日期：2026-10-18
+****************************************************************************************/
+static uint16_t DTC_OnTime(void)
+{
+    int32_t level = PA_Buffer[PA_IDX_DISP_BRIGHT];
+
+    if (DTC_Dev.Mode == DTC_MODE_EDIT && DTC_Dev.GroupIdx == 0 && DTC_Dev.ParamNum == PA_IDX_DISP_BRIGHT) {
+        level = DTC_Dev.EditVal;
+    }
+    if (level < 1 || level > DTC_BRIGHT_LEVELS) level = DTC_BRIGHT_LEVELS;
+    return DTC_BrightTable[level - 1];
 }
 
 /****************************************************************************************
@@ -251,27 +269,32 @@ static void DTC_Apply_Edit(uint8_t is_up)
         
         DTC_Dev.ParamNum = (uint16_t)new_idx;
     }
-    // B. 在编辑界面：修改数值内容
+    // B. 在监控界面：切换到相邻 dP 并立即刷新
+    else if (DTC_Dev.Mode == DTC_MODE_MONITOR) {
+        if (is_up) DTC_Dev.ParamNum = (DTC_Dev.ParamNum + 1 >= DP_SIZE) ? 0 : DTC_Dev.ParamNum + 1;
+        else DTC_Dev.ParamNum = (DTC_Dev.ParamNum == 0) ? DP_SIZE - 1 : DTC_Dev.ParamNum - 1;
+        DTC_Dev.Page = PAGE_LOW;
+        DTC_Dev.EditVal = Param_GetValue(PARAM_GROUP_DP, DTC_Dev.ParamNum);
+        DTC_Dev.MonTick = HAL_GetTick();
+    }
+    // C. 在编辑界面：修改数值内容 (仅 PA 组, dP 组进入监控模式)
     else {
-        // 新增: dP 参数组 (GroupIdx == 1) 为只读，不允许修改数值
-        if (DTC_Dev.GroupIdx == 1) return;
-
-        DTC_ParamConfig_t cfg = DTC_GetConfig(DTC_Dev.GroupIdx, DTC_Dev.ParamNum);
+        const DTC_ParamConfig_t *cfg = Param_GetConfig(DTC_Dev.GroupIdx, DTC_Dev.ParamNum);
         int64_t step = 1; 
         
-        if (cfg.Format == FMT_DEC) {
+        if (cfg->Format == FMT_DEC) {
             int power = DTC_Dev.EditBit; 
             // 32位数据需叠加分页权重
-            if (cfg.Width == BIT_32) {
+            if (cfg->Width == BIT_32) {
                 if (DTC_Dev.Page == PAGE_MID) power += 4;
                 if (DTC_Dev.Page == PAGE_HIGH) power += 8;
             }
             for(int i=0; i<power; i++) step *= 10;
         } 
-        else if (cfg.Format == FMT_HEX) { 
+        else if (cfg->Format == FMT_HEX) { 
             for(int i=0; i<DTC_Dev.EditBit; i++) step *= 16; 
         }
-        else if (cfg.Format == FMT_BIN) { 
+        else if (cfg->Format == FMT_BIN) { 
             for(int i=0; i<DTC_Dev.EditBit; i++) step *= 2; 
         }
 
@@ -279,8 +302,8 @@ static void DTC_Apply_Edit(uint8_t is_up)
         if (is_up) temp += step; else temp -= step;
 
         // 极值限制
-        if (temp > cfg.Max) temp = cfg.Min; 
-        else if (temp < cfg.Min) temp = cfg.Max;
+        if (temp > cfg->Max) temp = cfg->Min; 
+        else if (temp < cfg->Min) temp = cfg->Max;
         
         DTC_Dev.EditVal = (int32_t)temp;
     }
@@ -288,40 +311,27 @@ static void DTC_Apply_Edit(uint8_t is_up)
 }
 
 /****************************************************************************************
-* 函数名称：DTC_Key_Logic
-* 函数功能：按键处理状态机 (含长短按复用、连发加速)
-* 输入参量：无
+* 函数名称：DTC_Key_Event
+* 函数功能：按键事件处理 (短按在释放时触发, 长按进入编辑/保存, 加减键连发)
+* 输入参量：evt - 按键事件
 * 输出参量：无
 * 编写日期：2026-02-06
 ****************************************************************************************/
-static void DTC_Key_Logic(void)
+static void DTC_Key_Event(const strKeyEvent *evt)
 {
-    uint32_t idr = DTC_KEY_PORT->IDR;
-    
-    // 读取原始按键状态 (0为按下)
-    uint8_t k1_press = !(idr & PIN_MODE);
-    uint8_t k2_press = !(idr & PIN_UP);
-    uint8_t k3_press = !(idr & PIN_DOWN);
-    uint8_t k4_press = !(idr & PIN_SHIFT);
-
-    // --- 优先处理特殊组合键: 复位报错 (Key 2 + Key 3) ---
-    if (k2_press && k3_press) {
-        if (DTC_Dev.Mode == DTC_MODE_ERROR) {
-            DTC_Dev.KeyTimer++;
-            // 需要持续按下一小段时间防止误触 (比如50ms)
-            if (DTC_Dev.KeyTimer >= 50 && !DTC_Dev.LongPressDone) {
-                 DTC_Dev.LongPressDone = 1;
-                 DTC_Dev.Mode = DTC_MODE_SELECT;
-                 DTC_Dev.ErrCode = 0;
-                 DTC_Update_Buffer();
-            }
+    // --- 优先处理特殊组合键: 复位报错 (Key 2 + Key 3 保持 KEY_COMBO_MS) ---
+    if (evt->Key == KEY_ID_RESET) {
+        if (evt->Type == KEY_EVT_LONG && DTC_Dev.Mode == DTC_MODE_ERROR) {
+            DTC_Dev.Mode = DTC_MODE_SELECT;
+            DTC_Dev.ErrCode = 0;
+            DTC_Update_Buffer();
         }
         return; // 处理组合键时屏蔽其他单键
     }
 
     // --- 处理开机动画退出 (Key 1) ---
-    if (DTC_Dev.Mode == DTC_MODE_ANIMATION && DTC_Dev.AnimState == ANIM_WAIT_KEY) {
-        if (k1_press) {
+    if (DTC_Dev.Mode == DTC_MODE_ANIMATION) {
+        if (DTC_Dev.AnimState == ANIM_WAIT_KEY && evt->Key == KEY_ID_MODE && evt->Type == KEY_EVT_PRESS) {
             DTC_Dev.AnimState = ANIM_DONE;
             DTC_Dev.Mode = DTC_MODE_SELECT;
             DTC_Update_Buffer();
@@ -329,158 +339,192 @@ static void DTC_Key_Logic(void)
         return; 
     }
 
-    // --- 常规单键逻辑 (仅当无组合键时) ---
-    uint8_t key_now = 0;
-    if (k1_press) key_now = 1;
-    else if (k2_press) key_now = 2;
-    else if (k3_press) key_now = 3;
-    else if (k4_press) key_now = 4;
-
-    if (key_now != 0) {
+    switch (evt->Type) {
         // --- 按键按下时刻 ---
-        if (key_now != DTC_Dev.LastKey) {
-            DTC_Dev.KeyTimer = 0; 
-            DTC_Dev.LongPressDone = 0; 
-            DTC_Dev.LastKey = key_now;
-            DTC_Dev.RepeatTimer = 0; 
-            DTC_Dev.CurrentSpeed = ACCEL_START_MS;
-        }
-        DTC_Dev.KeyTimer++;
+        case KEY_EVT_PRESS:
+            DTC_Dev.LongPressDone = 0;
+            break;
 
-        // --- 长按检测 (仅 Key 4) ---
-        // 只有 Key 4 支持长按切换模式/保存
-        if (key_now == 4 && DTC_Dev.KeyTimer >= KEY_LONG_MS && !DTC_Dev.LongPressDone) {
+        // --- 长按检测 ---
+        // 只有 Key 4 支持长按切换模式/保存, Key 2/3 长按后进入连发
+        case KEY_EVT_LONG:
             DTC_Dev.LongPressDone = 1; // 标记长按已处理
-            
+            if (evt->Key != KEY_ID_SHIFT) break;
+
             if (DTC_Dev.Mode == DTC_MODE_SELECT) {
-                // 长按：进入编辑模式
-                DTC_Dev.Mode = DTC_MODE_EDIT;
+                // 长按：PA 组进入编辑模式, dP 组进入实时监控模式 (只读)
+                DTC_Dev.Mode = (DTC_Dev.GroupIdx == 0) ? DTC_MODE_EDIT : DTC_MODE_MONITOR;
                 // 从Buffer加载数据到临时编辑变量
-                DTC_Dev.EditVal = (DTC_Dev.GroupIdx == 0) ? PA_Buffer[DTC_Dev.ParamNum] : DP_Buffer[DTC_Dev.ParamNum];
+                DTC_Dev.EditVal = Param_GetValue(DTC_Dev.GroupIdx, DTC_Dev.ParamNum);
+                DTC_Dev.MonTick = HAL_GetTick();
                 DTC_Dev.Page = PAGE_LOW; 
                 DTC_Dev.EditBit = 0;     
             }
+            else if (DTC_Dev.Mode == DTC_MODE_MONITOR) {
+                // 长按：退出监控
+                DTC_Dev.Mode = DTC_MODE_SELECT;
+            }
             else if (DTC_Dev.Mode == DTC_MODE_EDIT) {
                 // 长按：保存并退出
-                if (DTC_Dev.GroupIdx == 0) PA_Buffer[DTC_Dev.ParamNum] = DTC_Dev.EditVal;
-                else DP_Buffer[DTC_Dev.ParamNum] = DTC_Dev.EditVal;
+                PA_Buffer[DTC_Dev.ParamNum] = DTC_Dev.EditVal;
                 
                 DTC_SaveParams_Callback(); // 触发外部保存
                 // DTC_Dev.Mode = DTC_MODE_SELECT; // 移除：由回调函数决定下一模式(donE)
             }
             DTC_Update_Buffer();
-        }
+            break;
 
-        // --- 连发逻辑 (Key 2/3) ---
+        // --- 连发逻辑 (Key 2/3, 间隔由按键引擎按 ACCEL_* 加速) ---
         // 只有在非错误模式下才处理加减连发
-        if (DTC_Dev.Mode != DTC_MODE_ERROR && DTC_Dev.KeyTimer >= KEY_LONG_MS && (key_now == 2 || key_now == 3)) {
-            DTC_Dev.RepeatTimer++;
-            if (DTC_Dev.RepeatTimer >= DTC_Dev.CurrentSpeed) {
-                DTC_Dev.RepeatTimer = 0;
-                DTC_Apply_Edit(key_now == 2 ? 1 : 0);
-                // 平滑加速
-                if (DTC_Dev.CurrentSpeed > ACCEL_MIN_MS) DTC_Dev.CurrentSpeed -= ACCEL_STEP;
+        case KEY_EVT_REPEAT:
+            if (DTC_Dev.Mode != DTC_MODE_ERROR) {
+                DTC_Apply_Edit(evt->Key == KEY_ID_UP ? 1 : 0);
             }
-        }
-    } 
-    else { 
+            break;
+
         // --- 按键释放时刻 (短按触发点) ---
-        if (DTC_Dev.LastKey != 0) {
-            // 如果未触发过长按，且时间超过消抖，则判定为短按
-            if (!DTC_Dev.LongPressDone && DTC_Dev.KeyTimer >= KEY_DEBOUNCE_MS) {
-                // 错误模式下屏蔽除复位外的单键操作
-                if (DTC_Dev.Mode == DTC_MODE_ERROR) {
-                     // 暂不响应单键，由组合键复位
-                }
-                else {
-                    switch (DTC_Dev.LastKey) {
-                        case 1: // Mod: 切换参数组 或 放弃编辑退出
-                            if (DTC_Dev.Mode == DTC_MODE_EDIT) {
-                                DTC_Dev.Mode = DTC_MODE_SELECT; // 不保存，直接退
-                            } else {
-                                DTC_Dev.GroupIdx = !DTC_Dev.GroupIdx;
-                                DTC_Dev.ParamNum = 0;
-                            }
-                            DTC_Update_Buffer();
-                            break;
-                        case 2: DTC_Apply_Edit(1); break; // Up: 加
-                        case 3: DTC_Apply_Edit(0); break; // Down: 减
-                        case 4: // Shift: 短按
-                            if (DTC_Dev.Mode == DTC_MODE_SELECT) {
-                                // 选择界面：左移光标 (个->十->百)
-                                if (++DTC_Dev.EditBit > 2) DTC_Dev.EditBit = 0;
-                            } 
-                            else if (DTC_Dev.Mode == DTC_MODE_EDIT) {
-                                // 编辑界面：
-                                DTC_ParamConfig_t cfg = DTC_GetConfig(DTC_Dev.GroupIdx, DTC_Dev.ParamNum);
-                                
-                                // 新增: dP组只允许翻页，不允许移位编辑
-                                if (DTC_Dev.GroupIdx == 1) {
-                                    if (cfg.Format == FMT_DEC && cfg.Width == BIT_32) {
-                                         // 32位允许切换分页查看
-                                         if (++DTC_Dev.Page > PAGE_HIGH) DTC_Dev.Page = PAGE_LOW;
-                                    }
-                                    // 其他格式(16位等)不允许任何操作(只读)
-                                }
-                                else {
-                                    // PA组: 允许翻页或移位
-                                    if (cfg.Format == FMT_DEC && cfg.Width == BIT_32) {
-                                        // 32位十进制：切换分页 (低->中->高)
-                                        if (++DTC_Dev.Page > PAGE_HIGH) DTC_Dev.Page = PAGE_LOW;
-                                    } else {
-                                        // 其他格式：移位光标
-                                        if (++DTC_Dev.EditBit > 3) DTC_Dev.EditBit = 0;
-                                    }
-                                }
-                                DTC_Update_Buffer();
-                            }
-                            break;
+        case KEY_EVT_RELEASE:
+            // 已触发长按/连发, 或错误模式下 (由组合键复位), 不按短按处理
+            if (DTC_Dev.LongPressDone || DTC_Dev.Mode == DTC_MODE_ERROR) break;
+
+            switch (evt->Key) {
+                case KEY_ID_MODE: // Mod: 切换参数组 或 放弃编辑/退出监控
+                    if (DTC_Dev.Mode == DTC_MODE_EDIT || DTC_Dev.Mode == DTC_MODE_MONITOR) {
+                        DTC_Dev.Mode = DTC_MODE_SELECT; // 不保存，直接退
+                    } else {
+                        DTC_Dev.GroupIdx = !DTC_Dev.GroupIdx;
+                        DTC_Dev.ParamNum = 0;
                     }
-                }
+                    DTC_Update_Buffer();
+                    break;
+                case KEY_ID_UP: DTC_Apply_Edit(1); break; // Up: 加
+                case KEY_ID_DOWN: DTC_Apply_Edit(0); break; // Down: 减
+                case KEY_ID_SHIFT: // Shift: 短按
+                    if (DTC_Dev.Mode == DTC_MODE_SELECT) {
+                        // 选择界面：左移光标 (个->十->百)
+                        if (++DTC_Dev.EditBit > 2) DTC_Dev.EditBit = 0;
+                    } 
+                    else if (DTC_Dev.Mode == DTC_MODE_EDIT || DTC_Dev.Mode == DTC_MODE_MONITOR) {
+                        // 编辑/监控界面：
+                        const DTC_ParamConfig_t *cfg = Param_GetConfig(DTC_Dev.GroupIdx, DTC_Dev.ParamNum);
+                        
+                        if (cfg->Format == FMT_DEC && cfg->Width == BIT_32) {
+                            // 32位十进制：切换分页 (低->中->高)
+                            if (++DTC_Dev.Page > PAGE_HIGH) DTC_Dev.Page = PAGE_LOW;
+                        } else if (DTC_Dev.Mode == DTC_MODE_EDIT) {
+                            // 其他格式：移位光标 (监控模式只读, 不移位)
+                            if (++DTC_Dev.EditBit > 3) DTC_Dev.EditBit = 0;
+                        }
+                        DTC_Update_Buffer();
+                    }
+                    break;
+                default:
+                    break;
             }
-            DTC_Dev.LastKey = 0; 
-            DTC_Dev.KeyTimer = 0;
-        }
+            break;
+
+        default:
+            break;
+    }
+}
+
+/****************************************************************************************
+* 函数名称：DTC_KeyPoll
+* 函数功能：取出并处理按键引擎产生的全部事件 (在主循环中调用, 不占用扫描中断)
+* 输入参量：无
+* 输出参量：无
+* 编写日期：2026-10-18
+****************************************************************************************/
+void DTC_KeyPoll(void)
+{
+    strKeyEvent evt;
+
+    while (Key_GetEvent(&evt)) {
+        DTC_Key_Event(&evt);
+    }
+}
+
+/****************************************************************************************
+* 函数名称：DTC_MonitorPoll
+* 函数功能：监控模式下每 DTC_MONITOR_MS 经属性表读取函数读取当前 dP, 数值变化时重新渲染显存
+*           (仅由显示任务 DTC_DisplayPoll 调用, 经 DTC_Update_Buffer 渲染后台帧再发布, 不直接改写扫描中断读取的前台帧)
+* 输入参量：无
+* 输出参量：无
+* 编写日期：2026-10-18
+****************************************************************************************/
+static void DTC_MonitorPoll(void)
+{
+    uint32_t now = HAL_GetTick();
+    int32_t val;
+
+    if (DTC_Dev.Mode != DTC_MODE_MONITOR || (now - DTC_Dev.MonTick) < DTC_MONITOR_MS) return;
+    DTC_Dev.MonTick = now;
+
+    val = Param_GetValue(PARAM_GROUP_DP, DTC_Dev.ParamNum);
+    if (val != DTC_Dev.EditVal) {
+        DTC_Dev.EditVal = val;
+        DTC_Update_Buffer();
     }
 }
 
 /****************************************************************************************
 * 函数名称：DTC_HandleStartupAnimation
 * 函数功能：执行开机动画 (打字机效果 + 闪烁)
+*           扫描中断按 DTC_ANIM_STEP_MS 推进 AnimStep 并投递显示任务, 此处按步骤渲染并发布 (可重复调用)
 * 输入参量：无
 * 输出参量：无
 * 编写日期：2026-02-06
 ****************************************************************************************/
 static void DTC_HandleStartupAnimation(void)
 {
+    uint8_t step = DTC_Dev.AnimStep;
+    uint8_t back = DTC_Dev.FrameIdx ^ 1U;
+    uint8_t *raw = DTC_Dev.Frame[back];
+
     // 阶段1：打字机 (E -> Et -> Ete -> Etes -> Etest)
     if (DTC_Dev.AnimState == ANIM_TYPEWRITER) {
-        DTC_Dev.AnimTimer++;
-        if (DTC_Dev.AnimTimer >= 150) { // 150ms 间隔
-            DTC_Dev.AnimTimer = 0;
-            DTC_Dev.AnimStep++;
-            
-            memset(DTC_Dev.RawData, SEG_OFF, 5);
-            // 倒序填充缓冲区
-            if (DTC_Dev.AnimStep >= 1) DTC_Dev.RawData[4] = SEG_E;
-            if (DTC_Dev.AnimStep >= 2) DTC_Dev.RawData[3] = SEG_t;
-            if (DTC_Dev.AnimStep >= 3) DTC_Dev.RawData[2] = SEG_E;
-            if (DTC_Dev.AnimStep >= 4) DTC_Dev.RawData[1] = SEG_S;
-            if (DTC_Dev.AnimStep >= 5) DTC_Dev.RawData[0] = SEG_t;
-            
-            if (DTC_Dev.AnimStep >= 5) { // 切换到等待模式
-                DTC_Dev.AnimState = ANIM_WAIT_KEY;
-                DTC_Dev.AnimStep = 0; 
-                DTC_Dev.AnimTimer = 0;
-            }
+        memset(raw, SEG_OFF, 5);
+        // 倒序填充缓冲区
+        if (step >= 1) raw[4] = SEG_E;
+        if (step >= 2) raw[3] = SEG_t;
+        if (step >= 3) raw[2] = SEG_E;
+        if (step >= 4) raw[1] = SEG_S;
+        if (step >= 5) raw[0] = SEG_t;
+        __DMB();
+        DTC_Dev.FrameIdx = back;
+
+        if (step >= DTC_ANIM_STEPS) { // 切换到等待模式
+            DTC_Dev.AnimState = ANIM_WAIT_KEY;
         }
     }
-    // 阶段2：等待 Key1 确认退出 (由 Key_Logic 处理退出逻辑)
+    // 阶段2：等待 Key1 确认退出 (由 DTC_Key_Event 处理退出逻辑)
     else if (DTC_Dev.AnimState == ANIM_WAIT_KEY) {
         // 保持显示 Etest，什么都不需要做
     }
 }
 
+/****************************************************************************************
+* 函数名称：DTC_DisplayPoll
+* 函数功能：显示任务: 开机动画与消息结束由扫描中断计时后投递, 监控数据按 DTC_MONITOR_MS 周期刷新
+*           显存只在此处及按键任务中渲染, 扫描中断不写显存
+* 输入参量：无
+* 输出参量：无
+* 编写日期：2026-10-18
+****************************************************************************************/
+void DTC_DisplayPoll(void)
+{
+    if (DTC_Dev.Mode == DTC_MODE_ANIMATION) {
+        DTC_HandleStartupAnimation();
+    } else if (DTC_Dev.Mode == DTC_MODE_MESSAGE) {
+        if (DTC_Dev.MsgTimer >= DTC_MSG_MS) {
+            DTC_Dev.Mode = DTC_MODE_SELECT; // 退出编辑
+            DTC_Update_Buffer();
+        }
+    } else {
+        DTC_MonitorPoll();
+    }
+}
+
 // ================= 外部调用接口 =================
 
 /****************************************************************************************
@@ -500,6 +544,11 @@ void DTC_Init(void)
     DMA1_Channel1->CMAR = (uint32_t)DTC_DMA_Buffer;
     SPI2->CR1 |= SPI_CR1_SPE;       
 
+    // 预移入消隐帧 (首次扫描中断锁存), 扫描周期改为 点亮/消隐 两个时隙交替,
+    // 开启 ARR 预装载: 每个时隙开头写入的是下一个时隙的长度
+    DTC_DMA_Transmitter(DTC_SegTable[SEG_OFF], 0x00);
+    TIM6->CR1 |= TIM_CR1_ARPE;
+
     // 设置初始模式为开机动画
     DTC_Dev.Mode = DTC_MODE_ANIMATION;
     DTC_Dev.AnimState = ANIM_TYPEWRITER;
@@ -509,32 +558,50 @@ void DTC_Init(void)
 
 /****************************************************************************************
 * 函数名称：DTC_ScanHandler
-* 函数功能：定时扫描处理函数 (需在 1ms 定时器中断中调用)
+* 函数功能：定时扫描处理函数 (在 TIM6 更新中断中调用)
+*           每位数码管的 1ms 扫描周期分为 点亮 + 消隐 两个时隙, 点亮时间由亮度参数决定,
+*           每次中断先锁存上一次预移入的帧, 再预移入下一时隙的帧
 * 输入参量：无
-* 输出参量：无
+* 输出参量：1 = 本次为 1ms 节拍 (消隐时隙开始), 0 = 点亮时隙开始
 * 编写日期：2026-02-06
 ****************************************************************************************/
-void DTC_ScanHandler(void)
+uint8_t DTC_ScanHandler(void)
 {
     static uint8_t scan_idx = 0;
-    uint8_t char_code;
+    static uint8_t lit = 0;                     // 本次中断进入点亮时隙
+    static uint16_t on_us = DTC_SCAN_PERIOD_US;
+    uint8_t char_code, raw;
+
+    // 0. 在定时器边沿锁存预移入的帧 (亮/灭时刻无软件抖动)
+    DTC_RCLK_H();
+
+    // 点亮时隙开始: 预装消隐时隙长度, 预移入消隐帧 (位选全关)
+    if (lit) {
+        lit = 0;
+        TIM6->ARR = DTC_SCAN_PERIOD_US - on_us - 1;
+        DTC_DMA_Transmitter(DTC_SegTable[SEG_OFF], 0x00);
+        return 0;
+    }
 
-    // 1. 优先处理动画
-    if (DTC_Dev.Mode == DTC_MODE_ANIMATION) {
-        DTC_HandleStartupAnimation();
-        // 允许在等待按键阶段扫描按键
-        if (DTC_Dev.AnimState == ANIM_WAIT_KEY) {
-             DTC_Key_Logic();
-        }
-    } else {
-        DTC_Key_Logic(); 
+    // 消隐时隙开始 (每 1ms 一次): 预装点亮时隙长度, 预移入下一位数码管
+    lit = 1;
+    on_us = DTC_OnTime();
+    TIM6->ARR = on_us - 1;
+
+    // 1. 动画计时 (渲染在显示任务中完成, 按键由事件引擎处理, 见 DTC_KeyPoll)
+    if (DTC_Dev.Mode == DTC_MODE_ANIMATION && DTC_Dev.AnimStep < DTC_ANIM_STEPS &&
+        ++DTC_Dev.AnimTimer >= DTC_ANIM_STEP_MS) {
+        DTC_Dev.AnimTimer = 0;
+        DTC_Dev.AnimStep++;
+        Sched_Post(SCHED_TASK_DISPLAY);
     }
 
-    // 2. 获取段码 (处理 0xFE 特殊符号)
-    if (DTC_Dev.RawData[scan_idx] == SEG_HIGH_FLAG) {
+    // 2. 获取段码 (处理 0xFE 特殊符号, 只读前台帧)
+    raw = DTC_Dev.Frame[DTC_Dev.FrameIdx][scan_idx];
+    if (raw == SEG_HIGH_FLAG) {
         char_code = SEG_HIGH_FLAG; 
     } else {
-        char_code = DTC_SegTable[DTC_Dev.RawData[scan_idx]];
+        char_code = DTC_SegTable[raw];
     }
     
     // Err模式下 Err.20 固定点亮中间小数点 (先设置，再看是否被闪烁熄灭)
@@ -546,13 +613,10 @@ void DTC_ScanHandler(void)
     DTC_Dev.BlinkCnt++;
     if (DTC_Dev.BlinkCnt >= 400) DTC_Dev.BlinkCnt = 0;
     
-    // --- 处理消息模式计时 ---
+    // --- 处理消息模式计时 (到时投递显示任务退出, 此处不改显存) ---
     if (DTC_Dev.Mode == DTC_MODE_MESSAGE) {
-        DTC_Dev.MsgTimer++;
-        if (DTC_Dev.MsgTimer >= 1200) { // 300ms * 4 = 1.2s (闪烁2次)
-            DTC_Dev.MsgTimer = 0;
-            DTC_Dev.Mode = DTC_MODE_SELECT; // 退出编辑
-            DTC_Update_Buffer();
+        if (DTC_Dev.MsgTimer < DTC_MSG_MS && ++DTC_Dev.MsgTimer == DTC_MSG_MS) { // 300ms * 4 = 1.2s (闪烁2次)
+            Sched_Post(SCHED_TASK_DISPLAY);
         }
         
         // 闪烁逻辑: 300ms 灭, 300ms 亮
@@ -581,22 +645,17 @@ void DTC_ScanHandler(void)
             uint8_t blink_pos = 0xFF; // 0xFF表示不闪烁
 
             // 情况A: 选择界面 (PA 001)
-            // EditBit 0->个位(RawData[0]), 1->十位(RawData[1]), 2->百位(RawData[2])
+            // EditBit 0->个位(Frame[][0]), 1->十位(Frame[][1]), 2->百位(Frame[][2])
             if (DTC_Dev.Mode == DTC_MODE_SELECT) {
                 blink_pos = DTC_Dev.EditBit; 
             } 
             // 情况B: 编辑界面 (数值)
+            // (监控模式只读, 不闪烁)
             else if (DTC_Dev.Mode == DTC_MODE_EDIT) {
-                // 如果是 dP 组，强制不闪烁 (只读)
-                if (DTC_Dev.GroupIdx == 1) {
-                    blink_pos = 0xFF;
-                }
-                else {
-                    DTC_ParamConfig_t cfg = DTC_GetConfig(DTC_Dev.GroupIdx, DTC_Dev.ParamNum);
-                    // 32位分页模式通常不闪烁位(因为在翻页)，其他格式闪烁编辑位
-                    if (!(cfg.Format == FMT_DEC && cfg.Width == BIT_32)) {
-                        blink_pos = DTC_Dev.EditBit;
-                    }
+                const DTC_ParamConfig_t *cfg = Param_GetConfig(DTC_Dev.GroupIdx, DTC_Dev.ParamNum);
+                // 32位分页模式通常不闪烁位(因为在翻页)，其他格式闪烁编辑位
+                if (!(cfg->Format == FMT_DEC && cfg->Width == BIT_32)) {
+                    blink_pos = DTC_Dev.EditBit;
                 }
             }
 
@@ -607,10 +666,11 @@ void DTC_ScanHandler(void)
         }
     }
 
-    // 4. DMA 发送
+    // 4. DMA 预移入 (下一点亮时隙开始时锁存)
     DTC_DMA_Transmitter(char_code, DTC_PosTable[scan_idx]);
     
     if (++scan_idx >= 5) scan_idx = 0;
+    return 1;
 }
 
 /****************************************************************************************
@@ -636,15 +696,26 @@ void DTC_SetError(uint16_t code)
 void DTC_SaveParams_Callback(void) 
 {
     // 1. 先切换到消息提示模式 (避免 Flash 写入时卡在旧数值)
-    DTC_Dev.Mode = DTC_MODE_MESSAGE;
     DTC_Dev.MsgTimer = 0;
+    DTC_Dev.Mode = DTC_MODE_MESSAGE;
     DTC_Update_Buffer();
     
-    // 延时一小段时间，确保 DMA 把 "donE" 发送出去
-    // (因为 Flash 操作会暂停 CPU，导致数码管停留在最后一帧)
-    HAL_Delay(10); 
-    
-    // 2. 保存参数到 Flash (此时数码管显示 donE)
+    // 2. 保存参数到 Flash: 投递 Flash 任务延后执行, 按键任务不阻塞
+    DTC_SavePending = 1;
+    Sched_Post(SCHED_TASK_FLASH);
+}
+
+/****************************************************************************************
+* 函数名称：DTC_SavePoll
+* 函数功能：执行按键长按挂起的参数保存 (调度器 Flash 任务中调用, 此时消息帧已发布)
+* 输入参量：无
+* 输出参量：无
+* 编写日期：2026-10-18
+****************************************************************************************/
+void DTC_SavePoll(void)
+{
+    if (!DTC_SavePending) return;
+    DTC_SavePending = 0;
     Flash_SaveParams(PA_Buffer, PA_SIZE);
 }
 	
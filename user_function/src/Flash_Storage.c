@@ -1,8 +1,7 @@
 
 #include "Flash_Storage.h"
-#include <string.h>
-
-#include "Flash_Storage.h"
+#include "param_table.h"
+#include "trace_function.h"
 #include <string.h>
 
 // 内部辅助函数声明
@@ -10,6 +9,22 @@ static void Flash_ErasePage(uint32_t pageAddr);
 static void Flash_WriteDataWithCRC(uint32_t pageAddr, int32_t *buffer, uint16_t count);
 static uint8_t Flash_CheckValidAndCRC(uint32_t pageAddr, int32_t *buffer, uint16_t count);
 static uint32_t Soft_CRC32(uint32_t *pData, uint16_t len);
+static uint8_t Flash_LogBlank(uint32_t addr, uint32_t size);
+
+// 属性表版本号存放地址: 紧跟 [Magic][Data][CRC] 之后的 8 字节对齐位置
+#define Flash_SchemaAddr(pageAddr, count)   ((pageAddr) + ((((uint32_t)(count) + 2) * 4 + 7) & ~7UL))
+
+// Flash 擦除次数 (上电以来, dP 诊断量): 参数页 A/B 与记录流页分别计数
+static uint32_t FlashEraseCount = 0;
+static uint32_t FlashLogEraseCount = 0;
+
+// 记录流: 单条记录长度 [Seq][Data][CRC] 按 8 字节对齐
+#define Flash_LogRecSize(count)             ((((uint32_t)(count) + 2) * 4 + 7) & ~7UL)
+#define Flash_LogOther(pageAddr)            (((pageAddr) == FLASH_ADDR_LOG_A) ? FLASH_ADDR_LOG_B : FLASH_ADDR_LOG_A)
+
+static uint32_t FlashLogPage = FLASH_ADDR_LOG_A;    // 当前追加页
+static uint32_t FlashLogNext = 0;                   // 下一条记录地址, 0 = 当前页已满 (追加前擦除另一页)
+static uint32_t FlashLogSeq = 0;                    // 最新记录序号
 
 /****************************************************************************************
 * 函数名称：Flash_SaveParams
@@ -22,6 +37,7 @@ static uint32_t Soft_CRC32(uint32_t *pData, uint16_t len);
 ****************************************************************************************/
 void Flash_SaveParams(int32_t *buffer, uint16_t count)
 {
+    TRACE(FLASH_PARAMS, count);
     HAL_FLASH_Unlock();
 
     // 1. 擦除 Page A 并写入新数据 (含CRC)
@@ -33,6 +49,7 @@ void Flash_SaveParams(int32_t *buffer, uint16_t count)
     Flash_WriteDataWithCRC(FLASH_ADDR_PAGE_B, buffer, count);
 
     HAL_FLASH_Lock();
+    FlashEraseCount += 2;
 }
 
 /****************************************************************************************
@@ -41,28 +58,162 @@ void Flash_SaveParams(int32_t *buffer, uint16_t count)
 * 输入参量：
 * - buffer: 目标缓冲区
 * - count:  32位数据个数
-* 输出参量：uint8_t (0:成功, 1:失败)
+* 输出参量：uint8_t (FLASH_LOAD_OK / FLASH_LOAD_EMPTY / FLASH_LOAD_SCHEMA)
 * 编写日期：2026-02-06
 ****************************************************************************************/
 uint8_t Flash_LoadParams(int32_t *buffer, uint16_t count)
 {
+    uint32_t pageAddr;
+
     // 1. 检查 Page A 是否有效且CRC正确
     if (Flash_CheckValidAndCRC(FLASH_ADDR_PAGE_A, buffer, count) == 0) {
-        return 0; // 成功加载
+        pageAddr = FLASH_ADDR_PAGE_A;
     }
-    
     // 2. 如果 Page A 无效, 检查 Page B
-    if (Flash_CheckValidAndCRC(FLASH_ADDR_PAGE_B, buffer, count) == 0) {
+    else if (Flash_CheckValidAndCRC(FLASH_ADDR_PAGE_B, buffer, count) == 0) {
         // B 有效，恢复到 A (可选，暂不自动恢复以避免复杂情况)
-        return 0; // 成功加载
+        pageAddr = FLASH_ADDR_PAGE_B;
     }
-    
     // 3. 都没有有效数据
-    return 1; // 失败
+    else {
+        return FLASH_LOAD_EMPTY;
+    }
+
+    // 4. 检查属性表版本 (保存后属性表被修改则需重新校验范围)
+    if (*(__IO uint32_t *)Flash_SchemaAddr(pageAddr, count) != Param_SchemaId()) {
+        return FLASH_LOAD_SCHEMA;
+    }
+    return FLASH_LOAD_OK;
+}
+
+/****************************************************************************************
+* 函数名称：Flash_GetEraseCount
+* 函数功能：查询上电以来参数页 (Page A/B) 擦除次数, 不含记录流页
+* 输入参量：无
+* 输出参量：擦除次数
+* 编写日期：2026-10-18
+****************************************************************************************/
+uint32_t Flash_GetEraseCount(void)
+{
+    return FlashEraseCount;
+}
+
+/****************************************************************************************
+* 函数名称：Flash_GetLogEraseCount
+* 函数功能：查询上电以来记录流页 (LOG_A/LOG_B) 擦除次数
+* 输入参量：无
+* 输出参量：擦除次数
+* 编写日期：2026-10-18
+****************************************************************************************/
+uint32_t Flash_GetLogEraseCount(void)
+{
+    return FlashLogEraseCount;
+}
+
+/****************************************************************************************
+* 函数名称：Flash_LoadLog
+* 函数功能：扫描记录流两页, 加载 CRC 正确且序号最大的记录, 并定位下一条记录的写入位置
+*           (须在 Flash_AppendLog 之前调用一次)
+* 输入参量：
+* - buffer: 目标缓冲区 (无有效记录时不修改)
+* - count:  32位数据个数 (每条记录相同)
+* 输出参量：0 = 加载成功, 1 = 无有效记录
+* 编写日期：2026-10-18
+****************************************************************************************/
+uint8_t Flash_LoadLog(uint32_t *buffer, uint16_t count)
+{
+    const uint32_t pages[2] = { FLASH_ADDR_LOG_A, FLASH_ADDR_LOG_B };
+    uint32_t rec = Flash_LogRecSize(count);
+    uint32_t best = 0, addr;
+    uint8_t p;
+
+    FlashLogSeq = 0;
+    for (p = 0; p < 2; p++) {
+        for (addr = pages[p]; addr + rec <= pages[p] + FLASH_PAGE_SIZE; addr += rec) {
+            uint32_t *pRec = (uint32_t *)addr;
+            if (pRec[0] == 0xFFFFFFFF) break;                       // 页内记录依次追加, 遇空白即结束
+            if (pRec[count + 1] != Soft_CRC32(pRec, count + 1)) continue;
+            if (best == 0 || pRec[0] > FlashLogSeq) {
+                best = addr;
+                FlashLogSeq = pRec[0];
+            }
+        }
+    }
+
+    if (best == 0) {
+        // 无有效记录: 从 A 页开始 (非空白则追加前擦除)
+        FlashLogPage = FLASH_ADDR_LOG_B;
+        FlashLogNext = 0;
+        return 1;
+    }
+
+    memcpy(buffer, (uint32_t *)best + 1, count * 4);
+
+    // 最新记录之后的第一个完全空白位置 (跳过掉电中断的半条记录)
+    FlashLogPage = (best >= FLASH_ADDR_LOG_B) ? FLASH_ADDR_LOG_B : FLASH_ADDR_LOG_A;
+    FlashLogNext = 0;
+    for (addr = best + rec; addr + rec <= FlashLogPage + FLASH_PAGE_SIZE; addr += rec) {
+        if (Flash_LogBlank(addr, rec)) {
+            FlashLogNext = addr;
+            break;
+        }
+    }
+    return 0;
+}
+
+/****************************************************************************************
+* 函数名称：Flash_AppendLog
+* 函数功能：追加一条记录 (当前页有空位时只写不擦, 写满后擦除另一页, 两页轮换)
+* 输入参量：
+* - buffer: 数据源指针
+* - count:  32位数据个数 (须与 Flash_LoadLog 相同)
+* 输出参量：无
+* 编写日期：2026-10-18
+****************************************************************************************/
+void Flash_AppendLog(const uint32_t *buffer, uint16_t count)
+{
+    uint32_t rec = Flash_LogRecSize(count);
+    uint32_t words[2 + 16];                                 // 单条记录最多 16 个数据
+    uint32_t i, n;
+
+    if (count > 16) return;
+
+    words[0] = ++FlashLogSeq;
+    TRACE(FLASH_LOG, FlashLogSeq);
+    memcpy(&words[1], buffer, count * 4);
+    words[count + 1] = Soft_CRC32(words, count + 1);
+    n = (count + 2 + 1) & ~1UL;
+    if (n > (uint32_t)count + 2) words[count + 2] = 0xFFFFFFFF;
+
+    HAL_FLASH_Unlock();
+    if (FlashLogNext == 0) {
+        FlashLogPage = Flash_LogOther(FlashLogPage);
+        Flash_ErasePage(FlashLogPage);
+        FlashLogNext = FlashLogPage;
+        FlashLogEraseCount++;
+    }
+    for (i = 0; i < n; i += 2) {
+        HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, FlashLogNext + i * 4,
+                          ((uint64_t)words[i + 1] << 32) | (uint64_t)words[i]);
+    }
+    HAL_FLASH_Lock();
+
+    FlashLogNext += rec;
+    if (FlashLogNext + rec > FlashLogPage + FLASH_PAGE_SIZE) FlashLogNext = 0;
 }
 
 // ================= 内部底层函数 =================
 
+// 记录位置是否为擦除态
+static uint8_t Flash_LogBlank(uint32_t addr, uint32_t size)
+{
+    uint32_t i;
+    for (i = 0; i < size; i += 4) {
+        if (*(__IO uint32_t *)(addr + i) != 0xFFFFFFFF) return 0;
+    }
+    return 1;
+}
+
 static void Flash_ErasePage(uint32_t pageAddr)
 {
     FLASH_EraseInitTypeDef EraseInitStruct;
@@ -76,7 +227,9 @@ static void Flash_ErasePage(uint32_t pageAddr)
     EraseInitStruct.Page        = pageIndex;
     EraseInitStruct.NbPages     = 1;
 
+    TRACE(FLASH_ERASE, pageIndex);
     HAL_FLASHEx_Erase(&EraseInitStruct, &PageError);
+    TRACE(FLASH_ERASED, pageIndex);
 }
 
 // 软 CRC32 算法
@@ -151,6 +304,11 @@ static void Flash_WriteDataWithCRC(uint32_t pageAddr, int32_t *buffer, uint16_t
          data64 = ((uint64_t)0xFFFFFFFF << 32) | (uint64_t)crc;
          HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, currentAddr, data64);
     }
+
+    // 4. 写入属性表版本号
+    uint32_t schema = Param_SchemaId();
+    data64 = ((uint64_t)(~schema) << 32) | (uint64_t)schema;
+    HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, Flash_SchemaAddr(pageAddr, count), data64);
 }
 
 static uint8_t Flash_CheckValidAndCRC(uint32_t pageAddr, int32_t *buffer, uint16_t count)
@@ -0,0 +1,604 @@
+/****************************************************************************************
+  * @file      command_function.c
+  * @brief     USART1 字符串命令解析 (命令表 + 二分查找 + 分词/参数解析)
+  * ****************************************************************************************/
+#include "command_function.h"
+#include "uart_config.h"
+#include "relay_control.h"
+#include "relay_sequence.h"
+#include "sched_function.h"
+#include "nvic_config.h"
+#include "perf_function.h"
+#include "trace_function.h"
+#include "iap_function.h"
+#include "stream_function.h"
+#include "param_table.h"
+#include "Flash_Storage.h"
+#include "usart.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+/* 命令处理函数声明 */
+static void Cmd_Baud(const strCmdArg *arg, uint8_t argc);
+static void Cmd_BaudAuto(const strCmdArg *arg, uint8_t argc);
+static void Cmd_BoardInfo(const strCmdArg *arg, uint8_t argc);
+static void Cmd_BoardStatus(const strCmdArg *arg, uint8_t argc);
+static void Cmd_FirmwareUpdate(const strCmdArg *arg, uint8_t argc);
+static void Cmd_FirmwareVersion(const strCmdArg *arg, uint8_t argc);
+static void Cmd_Get(const strCmdArg *arg, uint8_t argc);
+static void Cmd_Help(const strCmdArg *arg, uint8_t argc);
+static void Cmd_IrqStress(const strCmdArg *arg, uint8_t argc);
+static void Cmd_Perf(const strCmdArg *arg, uint8_t argc);
+static void Cmd_PerfReset(const strCmdArg *arg, uint8_t argc);
+static void Cmd_Relay(const strCmdArg *arg, uint8_t argc);
+static void Cmd_RelayAllOff(const strCmdArg *arg, uint8_t argc);
+static void Cmd_RelayAllOn(const strCmdArg *arg, uint8_t argc);
+static void Cmd_RelayMask(const strCmdArg *arg, uint8_t argc);
+static void Cmd_RelayOps(const strCmdArg *arg, uint8_t argc);
+static void Cmd_RelayOpsReset(const strCmdArg *arg, uint8_t argc);
+static void Cmd_Save(const strCmdArg *arg, uint8_t argc);
+static void Cmd_Seq(const strCmdArg *arg, uint8_t argc);
+static void Cmd_SeqStart(const strCmdArg *arg, uint8_t argc);
+static void Cmd_SeqStop(const strCmdArg *arg, uint8_t argc);
+static void Cmd_Set(const strCmdArg *arg, uint8_t argc);
+static void Cmd_StreamStart(const strCmdArg *arg, uint8_t argc);
+static void Cmd_StreamStop(const strCmdArg *arg, uint8_t argc);
+static void Cmd_Task(const strCmdArg *arg, uint8_t argc);
+static void Cmd_Trace(const strCmdArg *arg, uint8_t argc);
+static void Cmd_TraceClear(const strCmdArg *arg, uint8_t argc);
+static void Cmd_TraceMask(const strCmdArg *arg, uint8_t argc);
+
+/* 命令表: 必须按 Name 升序 (strcmp) 排列, Cmd_Init 中校验 */
+static const strCmdEntry CmdTable[] = {
+    // 命令名              参数   必选  处理函数              帮助
+    { "Baud",              "u",   0,   Cmd_Baud,             "Show/switch USART1 baudrate" },
+    { "Baud Auto",         "",    0,   Cmd_BaudAuto,         "Auto-baud on next 0x55 byte" },
+    { "Board Info",        "",    0,   Cmd_BoardInfo,        "Hardware/firmware info"      },
+    { "Board Status",      "",    0,   Cmd_BoardStatus,      "Relay K1-K8 status"          },
+    { "Firmware Update",   "",    0,   Cmd_FirmwareUpdate,   "Reboot into bootloader"      },
+    { "Firmware version",  "",    0,   Cmd_FirmwareVersion,  "Firmware version"            },
+    { "Get",               "p",   1,   Cmd_Get,              "Read parameter"              },
+    { "Help",              "",    0,   Cmd_Help,             "List commands"               },
+    { "Irq Stress",        "u",   0,   Cmd_IrqStress,        "IRQ latency test (seconds)"  },
+    { "Perf",              "",    0,   Cmd_Perf,             "ISR/handler cycle counts"    },
+    { "Perf Reset",        "",    0,   Cmd_PerfReset,        "Clear cycle counts"          },
+    { "Relay",             "kb",  2,   Cmd_Relay,            "Switch one relay"            },
+    { "Relay AllOff",      "",    0,   Cmd_RelayAllOff,      "All relays off"              },
+    { "Relay AllOn",       "",    0,   Cmd_RelayAllOn,       "All relays on"               },
+    { "Relay Mask",        "u",   0,   Cmd_RelayMask,        "Show/set K1-K8 as bit mask"  },
+    { "Relay Ops",         "",    0,   Cmd_RelayOps,         "Relay operation counters"    },
+    { "Relay OpsReset",    "k",   1,   Cmd_RelayOpsReset,    "Clear counter after replace" },
+    { "Save",              "",    0,   Cmd_Save,             "Save PA parameters to flash" },
+    { "Seq",               "",    0,   Cmd_Seq,              "Relay sequence status"       },
+    { "Seq Start",         "",    0,   Cmd_SeqStart,         "Play relay sequence"         },
+    { "Seq Stop",          "",    0,   Cmd_SeqStop,          "Abort relay sequence"        },
+    { "Set",               "pi",  2,   Cmd_Set,              "Write PA parameter (RAM)"    },
+    { "Stream Start",      "",    0,   Cmd_StreamStart,      "Enter binary stream mode"    },
+    { "Stream Stop",       "",    0,   Cmd_StreamStop,       "Leave binary stream mode"    },
+    { "Task",              "",    0,   Cmd_Task,             "Task/CPU load, stack usage"  },
+    { "Trace",             "",    0,   Cmd_Trace,            "Dump event trace"            },
+    { "Trace Clear",       "",    0,   Cmd_TraceClear,       "Clear event trace"           },
+    { "Trace Mask",        "u",   0,   Cmd_TraceMask,        "Show/set trace group mask"   },
+};
+#define CMD_TABLE_SIZE      (sizeof(CmdTable) / sizeof(CmdTable[0]))
+
+static uint8_t CmdTableSorted = 0;          // 0: 表顺序错误, 退化为顺序查找
+
+/****************************************************************************************
+* 函数名称：Cmd_ArgTypeName
+* 函数功能：参数类型字符对应的用法说明
+* 输入参量：type - 参数类型字符
+* 输出参量：const char* 用法字符串
+****************************************************************************************/
+static const char *Cmd_ArgTypeName(char type)
+{
+    switch (type) {
+        case 'i': return "<int>";
+        case 'u': return "<uint>";
+        case 'b': return "<On|Off>";
+        case 'k': return "<K1-K8>";
+        case 'p': return "<PAxxx|dPxxx>";
+        default:  return "<str>";
+    }
+}
+
+/****************************************************************************************
+* 函数名称：Cmd_PrintUsage
+* 函数功能：根据命令表项打印用法 (帮助列表与参数错误提示共用)
+* 输入参量：cmd - 命令表项
+* 输出参量：无
+****************************************************************************************/
+static void Cmd_PrintUsage(const strCmdEntry *cmd)
+{
+    char usage[48] = {0};
+    int len = 0;
+    uint8_t i;
+
+    // 按缓冲区剩余长度追加, 超长时截断
+    for (i = 0; cmd->ArgSpec[i] != '\0' && len < (int)sizeof(usage); i++) {
+        len += snprintf(usage + len, sizeof(usage) - len, (i >= cmd->MinArgs) ? " [%s]" : " %s",
+                        Cmd_ArgTypeName(cmd->ArgSpec[i]));
+    }
+    Usart1_Print("%-18s%-24s%s\r\n", cmd->Name, usage, cmd->Help);
+}
+
+/****************************************************************************************
+* 函数名称：Cmd_ParseArg
+* 函数功能：按类型解析单个参数
+* 输入参量：type - 类型字符, str - 参数字符串, arg - 输出
+* 输出参量：0 = 成功, 1 = 格式错误
+****************************************************************************************/
+static uint8_t Cmd_ParseArg(char type, const char *str, strCmdArg *arg)
+{
+    char *end;
+
+    arg->Str = str;
+    arg->Int = 0;
+    arg->Group = 0;
+
+    switch (type) {
+        case 'i':
+            arg->Int = (int32_t)strtol(str, &end, 0);
+            return (*end != '\0');
+        case 'u':
+            if (str[0] == '-') return 1;
+            arg->Int = (int32_t)strtoul(str, &end, 0);
+            return (*end != '\0');
+        case 'b':
+            if (strcmp(str, "On") == 0 || strcmp(str, "on") == 0 || strcmp(str, "1") == 0) arg->Int = 1;
+            else if (strcmp(str, "Off") == 0 || strcmp(str, "off") == 0 || strcmp(str, "0") == 0) arg->Int = 0;
+            else return 1;
+            return 0;
+        case 'k':
+            if (str[0] != 'K' && str[0] != 'k') return 1;
+            arg->Int = (int32_t)strtol(str + 1, &end, 10);
+            return (*end != '\0' || arg->Int < 1 || arg->Int > RELAY_COUNT);
+        case 'p':
+            if ((str[0] == 'P' || str[0] == 'p') && (str[1] == 'A' || str[1] == 'a')) arg->Group = 0;
+            else if ((str[0] == 'D' || str[0] == 'd') && (str[1] == 'P' || str[1] == 'p')) arg->Group = 1;
+            else return 1;
+            arg->Int = (int32_t)strtol(str + 2, &end, 10);
+            if (*end != '\0' || arg->Int < 0) return 1;
+            return (arg->Int >= ((arg->Group == 0) ? PA_SIZE : DP_SIZE));
+        default:
+            return 0;
+    }
+}
+
+/****************************************************************************************
+* 函数名称：Cmd_Find
+* 函数功能：在命令表中查找命令 (二分查找)
+* 输入参量：name - 命令名
+* 输出参量：命令表项指针, 未找到返回 NULL
+****************************************************************************************/
+static const strCmdEntry *Cmd_Find(const char *name)
+{
+    int16_t low = 0;
+    int16_t high = CMD_TABLE_SIZE - 1;
+    uint8_t i;
+
+    if (!CmdTableSorted) {
+        for (i = 0; i < CMD_TABLE_SIZE; i++) {
+            if (strcmp(name, CmdTable[i].Name) == 0) return &CmdTable[i];
+        }
+        return NULL;
+    }
+
+    while (low <= high) {
+        int16_t mid = (low + high) / 2;
+        int cmp = strcmp(name, CmdTable[mid].Name);
+        if (cmp == 0) return &CmdTable[mid];
+        if (cmp < 0) high = mid - 1;
+        else low = mid + 1;
+    }
+    return NULL;
+}
+
+/****************************************************************************************
+* 函数名称：Cmd_Init
+* 函数功能：校验命令表排序 (顺序错误时退化为顺序查找, 保证功能可用)
+* 输入参量：无
+* 输出参量：无
+****************************************************************************************/
+void Cmd_Init(void)
+{
+    uint8_t i;
+
+    CmdTableSorted = 1;
+    for (i = 1; i < CMD_TABLE_SIZE; i++) {
+        if (strcmp(CmdTable[i - 1].Name, CmdTable[i].Name) >= 0) {
+            CmdTableSorted = 0;
+            break;
+        }
+    }
+}
+
+/****************************************************************************************
+* 函数名称：Usart1_SendStringHandler
+* 函数功能：根据接收到的字符串命令进行逻辑处理与响应
+*           分词后先按 "两词" 命令名查找, 再按 "单词" 命令名查找, 剩余分词作为参数
+* 输入参量：无
+* 输出参量：无
+* 编写日期：2025-8-27
+****************************************************************************************/
+void Usart1_SendStringHandler(void)
+{
+    char *tok[CMD_MAX_TOKENS];
+    char name[CMD_NAME_LEN];
+    strCmdArg arg[CMD_MAX_ARGS];
+    const strCmdEntry *cmd = NULL;
+    uint8_t ntok = 0, first = 0, argc, i;
+    char *p = (char *)Usart1.RxData;
+
+    // 1. 分词 (空格/制表符分隔, 原地截断)
+    while (*p != '\0' && ntok < CMD_MAX_TOKENS) {
+        while (*p == ' ' || *p == '\t') *p++ = '\0';
+        if (*p == '\0') break;
+        tok[ntok++] = p;
+        while (*p != '\0' && *p != ' ' && *p != '\t') p++;
+    }
+
+    // 2. 查表: 两词命令优先
+    if (ntok >= 2 && strlen(tok[0]) + strlen(tok[1]) + 2 <= CMD_NAME_LEN) {
+        snprintf(name, sizeof(name), "%s %s", tok[0], tok[1]);
+        cmd = Cmd_Find(name);
+        first = 2;
+    }
+    if (cmd == NULL && ntok >= 1) {
+        cmd = Cmd_Find(tok[0]);
+        first = 1;
+    }
+
+    if (cmd == NULL) {
+        if (ntok > 0) Usart1_Print("ERR: unknown command, try Help\r\n");
+    } else {
+        // 3. 参数解析
+        argc = ntok - first;
+        uint8_t maxArgs = (uint8_t)strlen(cmd->ArgSpec);
+        uint8_t bad = (argc < cmd->MinArgs || argc > maxArgs);
+        for (i = 0; !bad && i < argc; i++) {
+            bad = Cmd_ParseArg(cmd->ArgSpec[i], tok[first + i], &arg[i]);
+        }
+
+        if (bad) {
+            Usart1_Print("ERR: usage: ");
+            Cmd_PrintUsage(cmd);
+        } else {
+            cmd->Handler(arg, argc);
+        }
+    }
+
+    EnableUARTReceive(&huart1);
+    memset((char *)Usart1.RxData, 0, sizeof(Usart1.RxData));
+}
+
+/****************************************************************************************
+* 函数名称：Usart1_BaudSave_Callback
+* 函数功能：USART1 波特率配置确认后写入 PA 参数并保存到 Flash
+* 输入参量：cfg - PA_IDX_UART1_BAUD 参数值
+* 输出参量：无
+****************************************************************************************/
+void Usart1_BaudSave_Callback(int32_t cfg)
+{
+    if (PA_Buffer[PA_IDX_UART1_BAUD] == cfg) return;
+    PA_Buffer[PA_IDX_UART1_BAUD] = cfg;
+    Flash_SaveParams(PA_Buffer, PA_SIZE);
+}
+
+// ================= 命令处理函数 =================
+
+static void Cmd_Baud(const strCmdArg *arg, uint8_t argc)
+{
+    if (argc == 0) {
+        Usart1_Print("Baud: %lu (PA%03d = %ld)\r\n", (unsigned long)huart1.Init.BaudRate,
+                     PA_IDX_UART1_BAUD, (long)PA_Buffer[PA_IDX_UART1_BAUD]);
+        return;
+    }
+    if ((uint32_t)arg[0].Int < USART1_BAUD_MIN || (uint32_t)arg[0].Int > USART1_BAUD_MAX) {
+        Usart1_Print("ERR: baudrate %d-%d\r\n", USART1_BAUD_MIN, USART1_BAUD_MAX);
+        return;
+    }
+    Usart1_BaudNegotiate((uint32_t)arg[0].Int);
+}
+
+static void Cmd_BaudAuto(const strCmdArg *arg, uint8_t argc)
+{
+    (void)arg;
+    (void)argc;
+    Usart1_Print("OK\r\n");
+    Usart1_BaudSave_Callback(USART1_BAUD_AUTO);
+    Usart1_AutoBaudArm();
+}
+
+static void Cmd_BoardInfo(const strCmdArg *arg, uint8_t argc)
+{
+    (void)arg;
+    (void)argc;
+    Usart1_Print("MCU: STM32G491CCU6\n");
+    Usart1_Print("FW: V2.0\n");
+    Usart1_Print("HW: Encoder FCT Board V1.0\n");
+    Usart1_Print("K1-K8 -> PA0-PA7\n");
+}
+
+static void Cmd_BoardStatus(const strCmdArg *arg, uint8_t argc)
+{
+    uint8_t mask = Relay_GetMask();
+    (void)arg;
+    (void)argc;
+
+    Usart1_Print("Relay: K1:%s K2:%s K3:%s K4:%s K5:%s K6:%s K7:%s K8:%s\n",
+                 (mask & 0x01) ? "ON" : "OFF",
+                 (mask & 0x02) ? "ON" : "OFF",
+                 (mask & 0x04) ? "ON" : "OFF",
+                 (mask & 0x08) ? "ON" : "OFF",
+                 (mask & 0x10) ? "ON" : "OFF",
+                 (mask & 0x20) ? "ON" : "OFF",
+                 (mask & 0x40) ? "ON" : "OFF",
+                 (mask & 0x80) ? "ON" : "OFF");
+}
+
+static void Cmd_FirmwareUpdate(const strCmdArg *arg, uint8_t argc)
+{
+    (void)arg;
+    (void)argc;
+    IAP_RequestUpdate();
+}
+
+static void Cmd_FirmwareVersion(const strCmdArg *arg, uint8_t argc)
+{
+    (void)arg;
+    (void)argc;
+    Usart1_Print("V2.0\r\n");
+}
+
+static void Cmd_Get(const strCmdArg *arg, uint8_t argc)
+{
+    int32_t val = Param_GetValue(arg[0].Group, (uint16_t)arg[0].Int);
+    (void)argc;
+    Usart1_Print("%s%03ld = %ld\r\n", (arg[0].Group == 0) ? "PA" : "dP", (long)arg[0].Int, (long)val);
+}
+
+static void Cmd_Help(const strCmdArg *arg, uint8_t argc)
+{
+    uint8_t i;
+    (void)arg;
+    (void)argc;
+    for (i = 0; i < CMD_TABLE_SIZE; i++) {
+        Cmd_PrintUsage(&CmdTable[i]);
+    }
+}
+
+/* 继电器请求结果应答 */
+static void Cmd_RelayResult(uint8_t err)
+{
+    if (err == RELAY_ERR_INTERLOCK) Usart1_Print("ERR: interlock\r\n");
+    else if (err == RELAY_ERR_BUSY) Usart1_Print("ERR: busy\r\n");
+    else Usart1_Print("OK\r\n");
+}
+
+// 中断进入延迟压力测试: 带参数开始 (秒), 不带参数显示结果; 测试期间由主机施加 Modbus 负载
+static void Cmd_IrqStress(const strCmdArg *arg, uint8_t argc)
+{
+    const strIrqProbe *p = Irq_ProbeGet();
+    uint32_t avg;
+
+    if (argc) {
+        if (arg[0].Int == 0 || arg[0].Int > 3600) {
+            Usart1_Print("ERR: range 1..3600\r\n");
+            return;
+        }
+        Irq_ProbeStart((uint32_t)arg[0].Int * 1000);
+        Usart1_Print("OK\r\n");
+        return;
+    }
+    avg = p->Samples ? (uint32_t)(p->SumCycles / p->Samples) : 0;
+    Usart1_Print("%s  samples %lu  max %lu cyc (%lu ns)  avg %lu cyc\r\n", p->Active ? "Running" : "Done",
+                 (unsigned long)p->Samples, (unsigned long)p->MaxCycles,
+                 (unsigned long)((uint64_t)p->MaxCycles * 1000000000ULL / SystemCoreClock), (unsigned long)avg);
+}
+
+static void Cmd_Perf(const strCmdArg *arg, uint8_t argc)
+{
+    strPerfStat st;
+    uint8_t i;
+    (void)arg;
+    (void)argc;
+
+    for (i = 0; i < PERF_COUNT; i++) {
+        if (!Perf_Get((PerfId)i, &st)) {
+            Usart1_Print("ERR: disabled (PERF_ENABLE=0)\r\n");
+            return;
+        }
+        Usart1_Print("%-9s n %lu  min %lu  max %lu  avg %lu cyc\r\n", Perf_GetName((PerfId)i),
+                     (unsigned long)st.Count, (unsigned long)st.MinCycles, (unsigned long)st.MaxCycles,
+                     (unsigned long)(st.Count ? st.TotalCycles / st.Count : 0));
+    }
+}
+
+static void Cmd_PerfReset(const strCmdArg *arg, uint8_t argc)
+{
+    (void)arg;
+    (void)argc;
+    Perf_Reset();
+    Usart1_Print("OK\r\n");
+}
+
+static void Cmd_Relay(const strCmdArg *arg, uint8_t argc)
+{
+    uint8_t bit = (uint8_t)(1U << (arg[0].Int - 1));
+    (void)argc;
+
+    if (arg[1].Int) Cmd_RelayResult(Relay_Apply(bit, 0));
+    else Cmd_RelayResult(Relay_Apply(0, bit));
+}
+
+static void Cmd_RelayAllOff(const strCmdArg *arg, uint8_t argc)
+{
+    (void)arg;
+    (void)argc;
+    Cmd_RelayResult(Relay_SetMask(0));
+}
+
+static void Cmd_RelayAllOn(const strCmdArg *arg, uint8_t argc)
+{
+    (void)arg;
+    (void)argc;
+    Cmd_RelayResult(Relay_SetMask(RELAY_MASK_ALL));
+}
+
+static void Cmd_RelayMask(const strCmdArg *arg, uint8_t argc)
+{
+    if (argc == 0) {
+        Usart1_Print("Relay Mask = 0x%02X\r\n", Relay_GetMask());
+    } else if (arg[0].Int < 0 || arg[0].Int > (int32_t)RELAY_MASK_ALL) {
+        Usart1_Print("ERR: mask 0x00-0xFF\r\n");
+    } else {
+        Cmd_RelayResult(Relay_SetMask((uint8_t)arg[0].Int));
+    }
+}
+
+static void Cmd_RelayOps(const strCmdArg *arg, uint8_t argc)
+{
+    uint8_t i;
+    (void)arg;
+    (void)argc;
+
+    for (i = 1; i <= RELAY_COUNT; i++) {
+        Usart1_Print("K%u: %lu\r\n", i, (unsigned long)Relay_GetOps(i));
+    }
+}
+
+static void Cmd_RelayOpsReset(const strCmdArg *arg, uint8_t argc)
+{
+    (void)argc;
+    Relay_ResetOps((uint8_t)arg[0].Int);
+    Usart1_Print("OK\r\n");
+}
+
+static void Cmd_Save(const strCmdArg *arg, uint8_t argc)
+{
+    (void)arg;
+    (void)argc;
+    Flash_SaveParams(PA_Buffer, PA_SIZE);
+    Usart1_Print("OK\r\n");
+}
+
+static void Cmd_Seq(const strCmdArg *arg, uint8_t argc)
+{
+    static const char *const state[] = { "Idle", "Running", "Done", "Aborted", "Error" };
+    uint8_t st = RelaySeq_GetState();
+    (void)arg;
+    (void)argc;
+
+    Usart1_Print("Seq %s, done %u, elapsed %lu us\r\n", (st <= RSEQ_STATE_ERROR) ? state[st] : "?",
+                 RelaySeq_GetDone(), (unsigned long)RelaySeq_GetElapsed());
+}
+
+static void Cmd_SeqStart(const strCmdArg *arg, uint8_t argc)
+{
+    uint8_t err = RelaySeq_Start();
+    (void)arg;
+    (void)argc;
+
+    if (err) Usart1_Print("ERR: %u\r\n", err);
+    else Usart1_Print("OK\r\n");
+}
+
+static void Cmd_SeqStop(const strCmdArg *arg, uint8_t argc)
+{
+    (void)arg;
+    (void)argc;
+    RelaySeq_Stop();
+    Usart1_Print("OK\r\n");
+}
+
+static void Cmd_Set(const strCmdArg *arg, uint8_t argc)
+{
+    (void)argc;
+    if (arg[0].Group != 0) {
+        Usart1_Print("ERR: dP is read-only\r\n");
+        return;
+    }
+    if (Param_Check(PARAM_GROUP_PA, (uint16_t)arg[0].Int, arg[1].Int)) {
+        const DTC_ParamConfig_t *cfg = Param_GetConfig(PARAM_GROUP_PA, (uint16_t)arg[0].Int);
+        Usart1_Print("ERR: range %ld..%ld\r\n", (long)cfg->Min, (long)cfg->Max);
+        return;
+    }
+    PA_Buffer[arg[0].Int] = arg[1].Int;
+    Usart1_Print("OK\r\n");
+}
+
+static void Cmd_StreamStart(const strCmdArg *arg, uint8_t argc)
+{
+    (void)arg;
+    (void)argc;
+    Stream_Start();
+}
+
+static void Cmd_StreamStop(const strCmdArg *arg, uint8_t argc)
+{
+    (void)arg;
+    (void)argc;
+    Stream_Stop();
+}
+
+static void Cmd_Task(const strCmdArg *arg, uint8_t argc)
+{
+    uint8_t i;
+    (void)arg;
+    (void)argc;
+
+    for (i = 0; i < SCHED_TASK_COUNT; i++) {
+        const strSchedStat *st = Sched_GetStat((SchedTaskId)i);
+        Usart1_Print("%-8s %3u.%u%%  runs %lu  max %lu cyc\r\n", Sched_GetName((SchedTaskId)i),
+                     st->Load / 10, st->Load % 10, (unsigned long)st->Runs, (unsigned long)st->MaxCycles);
+    }
+    Usart1_Print("Total    %3u.%u%%\r\n", Sched_GetLoad() / 10, Sched_GetLoad() % 10);
+    Usart1_Print("CPU      %3u.%u%% (1s)  %u.%u%% (10s)  stack %u/%u bytes\r\n",
+                 Sched_GetCpuLoad() / 10, Sched_GetCpuLoad() % 10, Sched_GetCpuLoadLong() / 10, Sched_GetCpuLoadLong() % 10,
+                 Sched_GetStackUsed(), Sched_GetStackSize());
+}
+
+static void Cmd_Trace(const strCmdArg *arg, uint8_t argc)
+{
+    strTraceRec rec;
+    uint16_t i, n;
+    (void)arg;
+    (void)argc;
+
+    // 读出期间冻结, 输出本身 (USART1/DMA 事件) 不进入缓冲区; 读出格式见 tools/trace_decode.py
+    Trace_Freeze();
+    n = Trace_Count();
+    Usart1_Print("TRACE n=%u size=%u clk=%lu shift=%u mask=0x%04lX head=%lu\r\n", n, TRACE_RECORDS,
+                 (unsigned long)(SystemCoreClock / 1000000), TRACE_TIME_SHIFT, (unsigned long)Trace_GetMask(),
+                 (unsigned long)TraceHead);
+    for (i = 0; i < n; i++) {
+        Trace_Get(i, &rec);
+        Usart1_Print("%08lX %04X %04X\r\n", (unsigned long)rec.Time, rec.Id, rec.Arg);
+    }
+    Usart1_Print("END\r\n");
+    Trace_Resume();
+}
+
+static void Cmd_TraceClear(const strCmdArg *arg, uint8_t argc)
+{
+    (void)arg;
+    (void)argc;
+    Trace_Clear();
+    Usart1_Print("OK\r\n");
+}
+
+static void Cmd_TraceMask(const strCmdArg *arg, uint8_t argc)
+{
+    if (argc) {
+        if ((uint32_t)arg[0].Int > 0xFFFF) {
+            Usart1_Print("ERR: range 0..0xFFFF\r\n");
+            return;
+        }
+        Trace_SetMask((uint32_t)arg[0].Int);
+        Usart1_Print("OK\r\n");
+        return;
+    }
+    Usart1_Print("0x%04lX\r\n", (unsigned long)Trace_GetMask());
+}
@@ -1,62 +1,136 @@
 /****************************************************************************************
   * @file      delay_function.c
-  * @brief     微秒、毫秒、秒级延时函数实现
+  * @brief     64 位时基 (TIM2 + 溢出扩展)、非阻塞超时与延时函数实现
   * ****************************************************************************************/
 #include "delay_function.h"
+#include "nvic_config.h"
+
+static volatile uint32_t TimeHi = 0;        // 时基高 32 位 (TIM2 溢出次数)
+static uint32_t TimeScale = 1;              // CPU 周期 / TIM2 计数 (定时器时钟低于内核时钟时大于 1)
 
 /**************************************************************************************
-* 函数名称：delay_us()
-* 函数功能：实现微秒级高精度延时
-* 输入参量：us - 延时微秒数
+* 函数名称：Time_Init()
+* 函数功能：启动 TIM2 自由计数 (定时器时钟, 32 位) 与溢出中断, 开启 DWT 周期计数 (上电调用一次)
+* 输入参量：无
 * 输出参量：无
-* 编写日期：2025-06-26
+* 编写日期：2026-10-18
 ***************************************************************************************/
-void delay_us(uint32_t us)
+void Time_Init(void)
 {
-    uint32_t start = SysTick->VAL;
-    uint32_t ticks = us * (SystemCoreClock / 1000000);  // 将微秒转换为时钟节拍数
-    uint32_t reload = SysTick->LOAD + 1;
-    uint32_t elapsed = 0;
-    uint32_t current;
-
-    while (elapsed < ticks)
-    {
-        current = SysTick->VAL;
-        // SysTick 是向下计数的递减计数器
-        if (current <= start)
-            elapsed += start - current;
-        else
-            elapsed += start + (reload - current);      // 处理计数器重装载/溢出情况
-        start = current;
-    }
+    uint32_t clk = Tim_GetClock(TIM2);
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    // 计数单位为 CPU 周期: 定时器时钟按 APB1 分频读取, 低于内核时钟时读数按倍率换算
+    TimeScale = (SystemCoreClock >= clk) ? SystemCoreClock / clk : 1;
+    __HAL_RCC_TIM2_CLK_ENABLE();
+    TIM2->CR1 = TIM_CR1_URS;
+    TIM2->PSC = 0;
+    TIM2->ARR = 0xFFFFFFFFU;
+    TIM2->EGR = TIM_EGR_UG;
+    TIM2->SR = 0;
+    TIM2->DIER = TIM_DIER_UIE;
+    HAL_NVIC_EnableIRQ(TIM2_IRQn);
+    TIM2->CR1 |= TIM_CR1_CEN;
 }
 
 /**************************************************************************************
-* 函数名称：delay_ms()
-* 函数功能：实现毫秒级延时
-* 输入参量：ms - 延时毫秒数
+* 函数名称：Time_OverflowHandler()
+* 函数功能：TIM2 溢出处理 (在 TIM2 中断中调用, 该中断为最高优先级, 不会被读取方打断)
+* 输入参量：无
 * 输出参量：无
-* 编写日期：2026-02-04
+* 编写日期：2026-10-18
 ***************************************************************************************/
-void delay_ms(uint32_t ms)
+void Time_OverflowHandler(void)
 {
-    while (ms--)
-    {
-        delay_us(1000); // 循环调用 1000 微秒实现 1 毫秒
-    }
+    TIM2->SR = ~TIM_SR_UIF;
+    TimeHi++;
 }
 
 /**************************************************************************************
-* 函数名称：delay_s()
-* 函数功能：实现秒级延时
-* 输入参量：s - 延时秒数
+* 函数名称：Time_Now()
+* 函数功能：读取 64 位单调时基 (CPU 周期), 任意上下文可调用
+*           读取期间发生溢出中断则重读; 调用方屏蔽了溢出中断时按挂起标志补进位
+* 输入参量：无
+* 输出参量：当前时刻
+* 编写日期：2026-10-18
+***************************************************************************************/
+uint64_t Time_Now(void)
+{
+    uint32_t hi, lo, pend;
+
+    do {
+        hi = TimeHi;
+        lo = TIM2->CNT;
+        pend = TIM2->SR & TIM_SR_UIF;
+    } while (hi != TimeHi);
+
+    // 溢出已发生但尚未处理: 低位在溢出之后读取 (数值很小) 时高位加一
+    if (pend && lo < 0x80000000U) hi++;
+    return (((uint64_t)hi << 32) | lo) * TimeScale;
+}
+
+/**************************************************************************************
+* 函数名称：Time_Idle()
+* 函数功能：等待循环的休眠钩子: 线程模式且未屏蔽中断时 WFI 休眠至下一个中断, 否则直接返回 (退化为轮询)
+* 输入参量：无
 * 输出参量：无
-* 编写日期：2026-02-04
+* 编写日期：2026-10-18
 ***************************************************************************************/
-void delay_s(uint32_t s)
+void Time_Idle(void)
 {
-    while (s--)
-    {
-        delay_ms(1000); // 循环调用 1000 毫秒实现 1 秒
+    if (__get_IPSR() == 0 && __get_PRIMASK() == 0 && __get_BASEPRI() == 0) {
+        __DSB();
+        __WFI();
     }
 }
+
+/**************************************************************************************
+* 函数名称：Timeout_Start / Timeout_Expired
+* 函数功能：设置超时 (从当前时刻起 us 微秒) / 判断是否已超时 (不阻塞, 任意上下文可调用)
+* 输入参量：t - 超时对象, us - 超时时间 (微秒)
+* 输出参量：Timeout_Expired: 1 = 已超时
+* 编写日期：2026-10-18
+***************************************************************************************/
+void Timeout_Start(strTimeout *t, uint32_t us)
+{
+    t->Deadline = Time_Now() + (uint64_t)us * TIME_CYCLES_PER_US;
+}
+
+uint8_t Timeout_Expired(const strTimeout *t)
+{
+    return (Time_Now() >= t->Deadline) ? 1 : 0;
+}
+
+/**************************************************************************************
+* 函数名称：delay_us()
+* 函数功能：微秒级短延时 (DWT 周期计数忙等, 用于时序要求严格的场合, 较长等待使用超时对象 + Time_Idle)
+* 输入参量：us - 延时微秒数
+* 输出参量：无
+* 编写日期：2025-06-26
+***************************************************************************************/
+void delay_us(uint32_t us)
+{
+    uint32_t start = DWT->CYCCNT;
+    uint32_t ticks = us * TIME_CYCLES_PER_US;   // 将微秒转换为时钟周期数
+
+    while ((DWT->CYCCNT - start) < ticks);
+}
+
+/**************************************************************************************
+* 函数名称：HAL_Delay()
+* 函数功能：毫秒级延时 (替换 HAL 弱定义, delay_ms 即此函数): 等待期间休眠, 由 SysTick 唤醒计时
+* 输入参量：Delay - 延时毫秒数
+* 输出参量：无
+* 编写日期：2026-10-18
+***************************************************************************************/
+void HAL_Delay(uint32_t Delay)
+{
+    uint32_t start = HAL_GetTick();
+    uint32_t wait = Delay;
+
+    // 与 HAL 实现一致: 至少等待一个完整节拍
+    if (wait < HAL_MAX_DELAY) wait += (uint32_t)uwTickFreq;
+    while ((HAL_GetTick() - start) < wait) Time_Idle();
+}
@@ -7,22 +7,49 @@
 #include <stdarg.h> // ڴɱ
 #include <string.h>
 #include "uart_config.h"
+#include "usart.h"
 
 /*
 | Area         						| Starting address| Size   | End address  | ˵            					 |
 | ------------------------|-----------------| -------| -------------| ---------------------------|
-| BootLoader 	 						| 0x08000000      | 16 KB  | 0x08003FFF   |  IAP                |
-| APP Main Area						| 0x08004000      | 480 KB | 0x08079FFF   | û                |
-| Reserved area (optional)| 0x0807A000      | 28 KB  | 0x0807FFFF   | Ųݡ־   |
+| BootLoader 	 						| 0x08000000      | 20 KB  | 0x08004FFF   |  IAP                |
+| APP Main Area						| 0x08005000      | 230 KB | 0x0803E7FF   | û                |
+| IAP Journal							| 0x0803E800      | 2 KB   | 0x0803EFFF   | ־ (ͷ + )    |
+| Parameter Page A/B			| 0x0803F000      | 4 KB   | 0x0803FFFF   | Ų (Flash_Storage)    |
 
 | ֶ      |  | ˵                                     |
 | ------- | -- | -------------------------------------- |
 | header1 | 1  | ̶ `0x55`                              |
-| header2 | 1  | ̶ `0xAA`                              |
+| header2 | 1  | `0xAA` ԭʼ֡, `0xAB` ѹ֡, `0xAC` ֡, `0xAD` ͷ֡ |
 | length  | 2  | ݳȣСڵ 1024                        |
 | address | 4  | FLASH дַ                             |
 | payload | n  | ݣ 1024 ֽڣ                       |
-| crc16   | 2  | `length+address+payload` CRC16(Modbus) |
+| crc16   | 2  | `length+address+payload` CRC16(Modbus), ѹ//ͷ֡ header2 |
+
+ѹ֡ (LZSS, ߼ tools/iap_pack.py):
+  address Ϊ֡ѹʼַ, һѹ֡ѹַʱû,
+  ʼµ. payload  [־ֽ + 8 Ǻ]  (֡ڼǺ):
+  ־λ (λǰ) 1 = ֽ (1 ֽ), 0 = ƥ (2 ֽ):
+  byte0 = (-1)  8 λ, byte1 = (-1)  4 λ << 4 | (-3),  1~4096,  3~18
+
+֡ ( APP ǰ,  tools/iap_pack.py --delta):
+  address Ϊָ֡ʼַ (һַ֡), payload Ϊָ (С):
+  0x01 BASE  old_len(4) old_crc32(4) new_len(4) new_crc32(4)  ʼ (address = APP_ADDRESS),
+             ǰ CRC32 ظ "BASE_ERR" ()
+  0x02 COPY  len(2) src(4)   Ӿɾƫ src  len ֽ
+  0x03 DATA  len(2) data     
+  ¾ RAM ҳؽ,  Flash ͬҳд. ҳдֻһҳ,
+  COPY Դֽλ ҳ-1 ֮ҳ  δдҳ, ظ "DELTA_ERR".
+  ֡У¾ CRC32 ( zlib.crc32 ͬ), ظ "IMG_CRC_ERR" ģʽ
+
+ͷ֡ (ѡ,  tools/iap_pack.py --version):
+  address = APP_ADDRESS, payload = length(4) crc32(4) version(4), 뵥Ͳȴظ "RESUME n":
+  ־ͬһδɼ¼ʱ n Ϊύֽ (ҳ),  n = 0 (µ).
+  ƫ n 𰴵ַ˳ԭʼ֡ѹ֡ (֡ 0 ¿ʼ). дʱд߶ Flash
+   CRC32, ÿдһҳ־ύ (ƫ, CRC32); ֡Ƚϳ CRC32, ͨ¼.
+  ־ (IAP_JOURNAL_ADDRESS, ˫д):
+  +0 magic, version  +8 length, crc32  +16 ÿ 8 ֽһύ¼ (offset, crc32), offset = length Ϊ
+  BootLoader תǰ IAP_ImageValid(): ־¼δɵʱת, ģʽ
 
 
 ϵ/λ
@@ -32,34 +59,110 @@
    
     ڵȴ 3sǷյ "IAP" ?
    
-    NO  ת APP (0x08004000)
+    NO  IAP_ImageValid() ? ת APP (0x08005000) : ģʽ
    
     YES
         
         
    "Update Mode" ظ
         
-    APP Flash
+   DMA ѭ (CPU д Flash ڼһ֡)
         
-   ѭ֡
+   ֡ ( IAP_WINDOW ֡ȴӦ)
         
     У CRC ȷ
-          NO  ظ "CRCERR"
-          YES  д Flash  ظ "OK"
+          NO  ʣ, ߾Ĭ (IAP_SilenceMs) ظ "CRCERR n"
+                 (n Ϊۼд֡, ӵ n ֡ط)
+          YES  ״дҳȲ  д Flash
+        
+     (IAP_WINDOW ֡)  ظ "OK n" (ۼд֡), һӦ
         
     Ƿյ֡
           NO  ȴһ
-          YES  ظ "DONE"
+          YES  񳤶/CRC32 У (ͷ֡)  ظ "DONE"
         
         
    ת APP
+
+   RS485 ˫: վֻһ֡յ֡Ĭ, ڼ϶жν
+   (USB-RS485 תڳʮ ms ϶); ÿ IAP_WINDOW ֡, һԽ֡β
+   (֡Ȳʣ֡ "OK n" ٻظ "DONE"), ͷ֡ͲӦ
 */
 
 /*  APP Ĳҳ */
 #define APP_OFFSET          (APP_ADDRESS - FLASH_BASE_ADDR)
-#define APP_AREA_SIZE       (FLASH_TOTAL_SIZE - APP_OFFSET)
+#define APP_AREA_SIZE       (APP_END_ADDRESS - APP_ADDRESS)
 #define APP_NBPAGES         ( (APP_AREA_SIZE + FLASH_PAGE_SIZE - 1) / FLASH_PAGE_SIZE )
 
+#define IAP_IS_HEADER2(b)   ((b) == IAP_HEADER2 || (b) == IAP_HEADER2_LZ || (b) == IAP_HEADER2_DELTA || (b) == IAP_HEADER2_IMAGE)
+
+/* ֡ ( IapResultText Ӧ) */
+#define IAP_RESULT_OK       0U
+#define IAP_RESULT_DONE     1U
+#define IAP_RESULT_LEN      2U
+#define IAP_RESULT_CRC      3U
+#define IAP_RESULT_ADDR     4U
+#define IAP_RESULT_FLASH    5U
+#define IAP_RESULT_LZ       6U
+#define IAP_RESULT_BASE     7U
+#define IAP_RESULT_DELTA    8U
+#define IAP_RESULT_IMAGE    9U
+#define IAP_RESULT_RESUME   10U
+
+static const char *const IapResultText[] = { "OK", "DONE", "LEN_ERR", "CRCERR", "ADDR_ERR", "FLASH_WR_ERR", "LZ_ERR",
+                                             "BASE_ERR", "DELTA_ERR", "IMG_CRC_ERR", "RESUME" };
+
+/* ˮ߽: USART1 RX -> DMA1_Channel3 ѭдջ,  IAP_WINDOW ֡ */
+#define IAP_FRAME_MAX       (10U + IAP_MAX_PAYLOAD)
+#define IAP_RX_RING_SIZE    8192U
+#define IAP_RX_MASK         (IAP_RX_RING_SIZE - 1U)
+
+STATIC_ASSERT(IAP_RX_RING_SIZE >= (IAP_WINDOW + 1U) * IAP_FRAME_MAX, iap_ring);
+
+static uint8_t  IapRxRing[IAP_RX_RING_SIZE];
+static uint8_t  IapFrame[IAP_FRAME_MAX];                /* ǰ֡ (ӽջȡ, Դ) */
+static uint32_t IapErased[(APP_NBPAGES + 31U) / 32U];   /* Ѳҳλͼ (Բ) */
+
+/* ѹ֡ѹ: ڼ Flash д뻺, δдݴﵽ IAP_LZ_FLUSH д */
+#define IAP_LZ_WINDOW       4096U           /*  (ƥ), 2  */
+#define IAP_LZ_MIN_MATCH    3U
+#define IAP_LZ_FLUSH        1024U           /* 8 ı,  + ƥ䳤 <  */
+
+static uint8_t  IapLzWin[IAP_LZ_WINDOW];
+static uint32_t IapLzBase;                  /* ʼַ */
+static uint32_t IapLzOut;                   /* ѽѹֽ */
+static uint32_t IapLzFlushed;               /* д Flash ֽ */
+static uint8_t  IapLzActive;                /*  */
+
+/* : ¾ҳ RAM ؽ, ҳ Flash Ƚ, дб仯ҳ */
+#define IAP_DELTA_OP_BASE   0x01U
+#define IAP_DELTA_OP_COPY   0x02U
+#define IAP_DELTA_OP_DATA   0x03U
+
+static uint8_t  IapDeltaPage[FLASH_PAGE_SIZE];  /* ؽҳ */
+static uint8_t  IapDeltaPrev[FLASH_PAGE_SIZE];  /* һдҳľ */
+static uint32_t IapDeltaPrevPage;               /* IapDeltaPrev Ӧҳ (0xFFFFFFFF = ) */
+static uint32_t IapDeltaDirty[(APP_NBPAGES + 31U) / 32U];   /* Ѹдҳλͼ (Ѷʧ) */
+static uint32_t IapDeltaOut;                    /* ֽ */
+static uint32_t IapDeltaNewLen;                 /* ¾񳤶 */
+static uint32_t IapDeltaNewCrc;                 /* ¾ CRC32 */
+static uint8_t  IapDeltaActive;                 /*  */
+
+/* ־ */
+#define IAP_JOURNAL_MAGIC   0x4A504149U     /* "IAPJ" */
+#define IAP_JOURNAL_ENTRY   (IAP_JOURNAL_ADDRESS + 16U)     /* һύ¼ */
+STATIC_ASSERT(16U + (APP_NBPAGES + 1U) * 8U <= FLASH_PAGE_SIZE, iap_journal);
+
+static uint32_t IapSessLen;                     /* 񳤶 */
+static uint32_t IapSessCrc;                     /*  CRC32 */
+static uint32_t IapSessVer;                     /* 汾 */
+static uint32_t IapSessOut;                     /* дֽ */
+static uint32_t IapSessHash;                    /* дݵ CRC32 ( Flash ) */
+static uint32_t IapSessCommitted;               /* ־һύ¼ƫ */
+static uint32_t IapSessJournal;                 /* һύ¼ַ */
+static uint8_t  IapSessActive;                  /* ͷ֡ʼ */
+static uint8_t  IapJournalCleared;              /* ޾ͷ־ */
+
 //****************************************************************************************
 //* ƣIAP_CRC16_Calc()
 //* ܣ CRC16-Modbus Уֵ
@@ -84,16 +187,42 @@ uint16_t IAP_CRC16_Calc(uint8_t *data, uint32_t len)
     return crc;
 }
 
+//****************************************************************************************
+//* ƣIAP_CRC32_Update()
+//* ܣ CRC32 (IEEE 802.3,  zlib.crc32 ͬ), ֽڲ, ɷֶۼ
+//* crc -> һεĽ (׶Ϊ 0)data -> ָ룻len -> ݳ
+//* ۼӺ CRC32
+//* дڣ2026-10-18
+//****************************************************************************************/
+uint32_t IAP_CRC32_Update(uint32_t crc, const uint8_t *data, uint32_t len)
+{
+    static const uint32_t table[16] = {
+        0x00000000U, 0x1DB71064U, 0x3B6E20C8U, 0x26D930ACU, 0x76DC4190U, 0x6B6B51F4U, 0x4DB26158U, 0x5005713CU,
+        0xEDB88320U, 0xF00F9344U, 0xD6D6A3E8U, 0xCB61B38CU, 0x9B64C2B0U, 0x86D3D2D4U, 0xA00AE278U, 0xBDBDF21CU
+    };
+
+    crc = ~crc;
+    while (len--)
+    {
+        crc ^= *data++;
+        crc = (crc >> 4) ^ table[crc & 0x0FU];
+        crc = (crc >> 4) ^ table[crc & 0x0FU];
+    }
+    return ~crc;
+}
+
 //****************************************************************************************
 //* ƣIAP_Flash_Write()
 //* ܣ Flash ַָдݣ˫Ϊλ
 //* address -> дַdata -> ָ룻length -> ݳȣֽ
-//* 
+//* HAL_OK = ɹ
 //* дڣ2025-9-02
 //****************************************************************************************/
-void IAP_Flash_Write(uint32_t address, uint8_t *data, uint32_t length)
+HAL_StatusTypeDef IAP_Flash_Write(uint32_t address, uint8_t *data, uint32_t length)
 {
-    if (length == 0) return;
+    HAL_StatusTypeDef status = HAL_OK;
+
+    if (length == 0) return HAL_OK;
     /* ַ飨ѡ */
     /* ע⣺д벻ܿԽܱ򣬽ڵö˼ַϷ */
 
@@ -104,15 +233,51 @@ void IAP_Flash_Write(uint32_t address, uint8_t *data, uint32_t length)
         uint64_t data64 = 0xFFFFFFFFFFFFFFFFULL;
         uint32_t copy_len = (length - i >= 8) ? 8U : (length - i);
         memcpy(&data64, &data[i], copy_len);
-        if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, address + i, data64) != HAL_OK)
+        status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, address + i, data64);
+        if (status != HAL_OK)
         {
-            /* дʧܴɷشӡϢ */
-            Usart1_Print("FLASH_WR_ERR\r\n");
+            /* дʧɵö˻ظ */
             break;
         }
     }
 
     HAL_FLASH_Lock();
+    return status;
+}
+
+//****************************************************************************************
+//* ƣIAP_Flash_EraseLazy()
+//* ܣԲ: дǰַΧڱδҳ
+//* address -> ʼַlength -> ȣֽ,  APP Ҵ 0
+//* HAL_OK = ɹ
+//* дڣ2026-10-18
+//****************************************************************************************/
+static HAL_StatusTypeDef IAP_Flash_EraseLazy(uint32_t address, uint32_t length)
+{
+    FLASH_EraseInitTypeDef eraseInit;
+    uint32_t pageError = 0;
+    uint32_t page = (address - APP_ADDRESS) / FLASH_PAGE_SIZE;
+    uint32_t last = (address + length - 1U - APP_ADDRESS) / FLASH_PAGE_SIZE;
+
+    for (; page <= last; page++)
+    {
+        if (IapErased[page >> 5] & (1UL << (page & 31U))) continue;
+
+        eraseInit.TypeErase = FLASH_TYPEERASE_PAGES;
+        eraseInit.Banks = FLASH_BANK_1;
+        eraseInit.Page = APP_OFFSET / FLASH_PAGE_SIZE + page;
+        eraseInit.NbPages = 1;
+
+        HAL_FLASH_Unlock();
+        if (HAL_FLASHEx_Erase(&eraseInit, &pageError) != HAL_OK)
+        {
+            HAL_FLASH_Lock();
+            return HAL_ERROR;
+        }
+        HAL_FLASH_Lock();
+        IapErased[page >> 5] |= 1UL << (page & 31U);
+    }
+    return HAL_OK;
 }
 
 //****************************************************************************************
@@ -130,6 +295,7 @@ void IAP_Flash_EraseApp(void)
     HAL_FLASH_Unlock();
 
     eraseInit.TypeErase = FLASH_TYPEERASE_PAGES;
+    eraseInit.Banks = FLASH_BANK_1;
     eraseInit.Page = APP_OFFSET / FLASH_PAGE_SIZE;
     eraseInit.NbPages = (uint32_t)APP_NBPAGES;
 
@@ -138,8 +304,229 @@ void IAP_Flash_EraseApp(void)
         /* ʧܿɼ¼ pageError */
         Usart1_Print("FLASH_ERASE_ERR\r\n");
     }
+    else
+    {
+        /* ٶԲ */
+        memset(IapErased, 0xFF, sizeof(IapErased));
+    }
+
+    HAL_FLASH_Lock();
+}
+
+//****************************************************************************************
+//* ƣIAP_JournalErase()
+//* ܣ־ҳ
+//* 
+//* HAL_OK = ɹ
+//* дڣ2026-10-18
+//****************************************************************************************/
+static HAL_StatusTypeDef IAP_JournalErase(void)
+{
+    FLASH_EraseInitTypeDef eraseInit;
+    uint32_t pageError = 0;
+    HAL_StatusTypeDef status;
+
+    eraseInit.TypeErase = FLASH_TYPEERASE_PAGES;
+    eraseInit.Banks = FLASH_BANK_1;
+    eraseInit.Page = (IAP_JOURNAL_ADDRESS - FLASH_BASE_ADDR) / FLASH_PAGE_SIZE;
+    eraseInit.NbPages = 1;
 
+    HAL_FLASH_Unlock();
+    status = HAL_FLASHEx_Erase(&eraseInit, &pageError);
     HAL_FLASH_Lock();
+    return status;
+}
+
+//****************************************************************************************
+//* ƣIAP_JournalAppend()
+//* ܣ־׷һύ¼
+//* offset -> дֽcrc -> дݵ CRC32
+//* HAL_OK = ɹ
+//* дڣ2026-10-18
+//****************************************************************************************/
+static HAL_StatusTypeDef IAP_JournalAppend(uint32_t offset, uint32_t crc)
+{
+    uint32_t entry[2];
+
+    if (IapSessJournal >= IAP_JOURNAL_ADDRESS + FLASH_PAGE_SIZE) return HAL_ERROR;
+    entry[0] = offset;
+    entry[1] = crc;
+    if (IAP_Flash_Write(IapSessJournal, (uint8_t *)entry, 8U) != HAL_OK) return HAL_ERROR;
+    IapSessJournal += 8U;
+    IapSessCommitted = offset;
+    return HAL_OK;
+}
+
+//****************************************************************************************
+//* ƣIAP_JournalBegin()
+//* ܣʼµ¼: ־д뾵ͷ (˺ IAP_ImageValid  0 ֱ¼)
+//* length -> 񳤶ȣcrc ->  CRC32version -> 汾
+//* HAL_OK = ɹ
+//* дڣ2026-10-18
+//****************************************************************************************/
+static HAL_StatusTypeDef IAP_JournalBegin(uint32_t length, uint32_t crc, uint32_t version)
+{
+    uint32_t head[4];
+
+    head[0] = IAP_JOURNAL_MAGIC;
+    head[1] = version;
+    head[2] = length;
+    head[3] = crc;
+    if (IAP_JournalErase() != HAL_OK) return HAL_ERROR;
+    if (IAP_Flash_Write(IAP_JOURNAL_ADDRESS, (uint8_t *)head, sizeof(head)) != HAL_OK) return HAL_ERROR;
+    IapSessJournal = IAP_JOURNAL_ENTRY;
+    IapSessCommitted = 0;
+    return HAL_OK;
+}
+
+//****************************************************************************************
+//* ƣIAP_JournalScan()
+//* ܣȡ־һЧύ¼
+//* offset -> ƫƣcrc ->  CRC32 (޼¼ʱΪ 0)
+//* һ¼ַ, 0 = ޾ͷ¼
+//* дڣ2026-10-18
+//****************************************************************************************/
+static uint32_t IAP_JournalScan(uint32_t *offset, uint32_t *crc)
+{
+    const uint32_t *head = (const uint32_t *)IAP_JOURNAL_ADDRESS;
+    uint32_t addr;
+
+    *offset = 0;
+    *crc = 0;
+    if (head[0] != IAP_JOURNAL_MAGIC || head[2] == 0U || head[2] > APP_AREA_SIZE) return 0;
+
+    for (addr = IAP_JOURNAL_ENTRY; addr < IAP_JOURNAL_ADDRESS + FLASH_PAGE_SIZE; addr += 8U)
+    {
+        const uint32_t *entry = (const uint32_t *)addr;
+
+        if (entry[0] == 0xFFFFFFFFU && entry[1] == 0xFFFFFFFFU) break;
+        /* ύ¼Ҳ񳤶 (джϵļ¼Ϊ) */
+        if (entry[0] <= *offset || entry[0] > head[2]) return 0;
+        *offset = entry[0];
+        *crc = entry[1];
+    }
+    return addr;
+}
+
+//****************************************************************************************
+//* ƣIAP_ImageValid()
+//* ܣУ: APP Ƿ (BootLoader ת APP ǰ)
+//* 
+//* 1 =   ־δʹ (޾ͷľɷʽ), 0 = δɻ־
+//* дڣ2026-10-18
+//****************************************************************************************/
+uint8_t IAP_ImageValid(void)
+{
+    const uint32_t *head = (const uint32_t *)IAP_JOURNAL_ADDRESS;
+    uint32_t offset, crc;
+
+    if (head[0] == 0xFFFFFFFFU) return 1U;
+    if (IAP_JournalScan(&offset, &crc) == 0U) return 0U;
+    return (offset == head[2] && crc == head[3]) ? 1U : 0U;
+}
+
+//****************************************************************************************
+//* ƣIAP_SessionOpen()
+//* ܣͷ֡: ־ͬһļ¼ʱύ, ʼµ
+//* length -> 񳤶ȣcrc ->  CRC32version -> 汾
+//* IAP_RESULT_RESUME (ƫΪ IapSessOut) 
+//* дڣ2026-10-18
+//****************************************************************************************/
+static uint8_t IAP_SessionOpen(uint32_t length, uint32_t crc, uint32_t version)
+{
+    const uint32_t *head = (const uint32_t *)IAP_JOURNAL_ADDRESS;
+
+    IapSessActive = 0;
+    IapDeltaActive = 0;
+    if (length == 0U || length > APP_AREA_SIZE) return IAP_RESULT_LEN;
+
+    IapSessJournal = 0;
+    if (head[0] == IAP_JOURNAL_MAGIC && head[1] == version && head[2] == length && head[3] == crc)
+    {
+        IapSessJournal = IAP_JournalScan(&IapSessOut, &IapSessHash);
+        IapSessCommitted = IapSessOut;
+    }
+    if (IapSessJournal == 0U)
+    {
+        if (IAP_JournalBegin(length, crc, version) != HAL_OK) return IAP_RESULT_FLASH;
+        IapSessOut = 0;
+        IapSessHash = 0;
+    }
+
+    /* ύ֮ҳжǰд, дǰ² */
+    memset(IapErased, 0, sizeof(IapErased));
+    IapSessLen = length;
+    IapSessCrc = crc;
+    IapSessVer = version;
+    IapSessActive = 1;
+    return IAP_RESULT_RESUME;
+}
+
+//****************************************************************************************
+//* ƣIAP_SessionEnd()
+//* ܣ֡: Ƚд볤 CRC32, ͨ־м¼
+//* 
+//* IAP_RESULT_xxx (Уʧʱдͷ, ´δͷ)
+//* дڣ2026-10-18
+//****************************************************************************************/
+static uint8_t IAP_SessionEnd(void)
+{
+    if (!IapSessActive) return IAP_RESULT_OK;
+    IapSessActive = 0;
+
+    if (IapSessOut != IapSessLen || IapSessHash != IapSessCrc)
+    {
+        IAP_JournalBegin(IapSessLen, IapSessCrc, IapSessVer);
+        return IAP_RESULT_IMAGE;
+    }
+    if (IapSessCommitted != IapSessLen && IAP_JournalAppend(IapSessLen, IapSessHash) != HAL_OK) return IAP_RESULT_FLASH;
+    return IAP_RESULT_OK;
+}
+
+//****************************************************************************************
+//* ƣIAP_Program()
+//* ܣд APP  (Բ + д Flash), ͷ֡ʼ밴ַ˳д,
+//*           дؼ CRC32, ÿдһҳ־ύһ
+//* address -> дַdata -> ָ룻length -> ݳ ( 0)
+//* IAP_RESULT_xxx
+//* дڣ2026-10-18
+//****************************************************************************************/
+static uint8_t IAP_Program(uint32_t address, uint8_t *data, uint32_t length)
+{
+    uint32_t done = 0, step, pos;
+
+    if (address < APP_ADDRESS || address + length > APP_END_ADDRESS) return IAP_RESULT_ADDR;
+
+    if (IapSessActive)
+    {
+        if (address != APP_ADDRESS + IapSessOut || length > IapSessLen - IapSessOut) return IAP_RESULT_ADDR;
+    }
+    else if (!IapJournalCleared)
+    {
+        /* ޾ͷ: ־оɵɼ¼ٶӦ APP  */
+        if (IAP_JournalErase() != HAL_OK) return IAP_RESULT_FLASH;
+        IapJournalCleared = 1;
+    }
+
+    if (IAP_Flash_EraseLazy(address, length) != HAL_OK) return IAP_RESULT_FLASH;
+    if (IAP_Flash_Write(address, data, length) != HAL_OK) return IAP_RESULT_FLASH;
+    if (!IapSessActive) return IAP_RESULT_OK;
+
+    while (done < length)
+    {
+        pos = IapSessOut + done;
+        step = FLASH_PAGE_SIZE - (pos % FLASH_PAGE_SIZE);
+        if (step > length - done) step = length - done;
+        IapSessHash = IAP_CRC32_Update(IapSessHash, (const uint8_t *)(address + done), step);
+        done += step;
+        pos += step;
+        if ((pos % FLASH_PAGE_SIZE) == 0U && pos < IapSessLen)
+        {
+            if (IAP_JournalAppend(pos, IapSessHash) != HAL_OK) return IAP_RESULT_FLASH;
+        }
+    }
+    IapSessOut += length;
+    return IAP_RESULT_OK;
 }
 
 //****************************************************************************************
@@ -222,83 +609,519 @@ uint8_t Check_IAP_Flag(void)
 }
 
 //****************************************************************************************
-//* ƣIAP_ParseFrame()
-//* ܣһ֡ IAP ݣ USART1 IDLE жϴ
-//* buf -> ݻlen -> ݳ
-//* 
-//* дڣ2025-9-02
+//* ƣIAP_LzFlush()
+//* ܣѽѹδдд Flash (д 8 ֽڶ, ʱд 8 ֽڵβ)
+//* upto -> д upto ѹֽ
+//* IAP_RESULT_xxx
+//* дڣ2026-10-18
 //****************************************************************************************/
-void IAP_ParseFrame(uint8_t *buf, uint16_t len)
+static uint8_t IAP_LzFlush(uint32_t upto)
 {
-    /* С֡ header(2) + len(2) + addr(4) + crc(2) -> 10 ֽ */
-    if (len < 10) return;
+    uint8_t result;
 
-    if (buf[0] != IAP_HEADER1 || buf[1] != IAP_HEADER2) return;
+    while (IapLzFlushed < upto)
+    {
+        uint32_t off = IapLzFlushed & (IAP_LZ_WINDOW - 1U);
+        uint32_t n = upto - IapLzFlushed;
+        uint32_t addr = IapLzBase + IapLzFlushed;
 
-    uint16_t payload_len = (uint16_t)(buf[2] | (buf[3] << 8));
-    uint32_t address = (uint32_t)(buf[4] | (buf[5] << 8) | (buf[6] << 16) | (buf[7] << 24));
+        /* ڻƴֶ (ڴСΪ 8 ı, ֶε㱣ֶ) */
+        if (n > IAP_LZ_WINDOW - off) n = IAP_LZ_WINDOW - off;
+        result = IAP_Program(addr, &IapLzWin[off], n);
+        if (result != IAP_RESULT_OK) return result;
+        IapLzFlushed += n;
+    }
+    return IAP_RESULT_OK;
+}
 
-    /* 鳤ȱ߽ */
-    if (payload_len > IAP_MAX_PAYLOAD) 
+//****************************************************************************************
+//* ƣIAP_LzEnd()
+//* ܣѹ, дʣ (֡/ԭʼ֡ʱ)
+//* 
+//* IAP_RESULT_xxx
+//* дڣ2026-10-18
+//****************************************************************************************/
+static uint8_t IAP_LzEnd(void)
+{
+    if (!IapLzActive) return IAP_RESULT_OK;
+    IapLzActive = 0;
+    return IAP_LzFlush(IapLzOut);
+}
+
+//****************************************************************************************
+//* ƣIAP_LzFrame()
+//* ܣѹһ֡ LZSS ݲд Flash (֡ʱд˫)
+//* address -> ֡ѹʼַsrc -> ѹݣlen -> ѹݳ
+//* IAP_RESULT_xxx
+//* дڣ2026-10-18
+//****************************************************************************************/
+static uint8_t IAP_LzFrame(uint32_t address, const uint8_t *src, uint16_t len)
+{
+    uint16_t i = 0;
+    uint8_t  flags = 0, bit = 8;
+    uint8_t  result;
+
+    /* ַ: һ, ʼµ () */
+    if (!IapLzActive || address != IapLzBase + IapLzOut)
     {
-        Usart1_Print("LEN_ERR\r\n");
-        return;
+        result = IAP_LzEnd();
+        if (result != IAP_RESULT_OK) return result;
+        if (address < APP_ADDRESS || address >= APP_END_ADDRESS || (address & 7U)) return IAP_RESULT_ADDR;
+        IapLzBase = address;
+        IapLzOut = IapLzFlushed = 0;
+        IapLzActive = 1;
     }
 
-    /* У֡ȣheader+len+addr+payload+crc */
-    if ((uint32_t)len < (uint32_t)(10 + payload_len)) return;
+    while (i < len)
+    {
+        if (bit == 8U)
+        {
+            flags = src[i++];
+            bit = 0;
+            continue;
+        }
 
-    uint16_t crc_recv = (uint16_t)(buf[8 + payload_len] | (buf[9 + payload_len] << 8));
-    /* CRC 㣺 Length(2)+Address(4)+Payload(N)  CRC */
-    uint16_t crc_calc = IAP_CRC16_Calc(&buf[2], (uint32_t)(6 + payload_len));
+        if (flags & (1U << bit))
+        {
+            /* ֽ */
+            IapLzWin[IapLzOut & (IAP_LZ_WINDOW - 1U)] = src[i++];
+            IapLzOut++;
+        }
+        else
+        {
+            /* ƥ: Ӵڸ (Сڳ, ֽڸʵظ) */
+            if (i + 2U > len) break;
+            uint32_t dist = ((uint32_t)src[i] | ((uint32_t)(src[i + 1] & 0xF0U) << 4)) + 1U;
+            uint32_t n = (uint32_t)(src[i + 1] & 0x0FU) + IAP_LZ_MIN_MATCH;
+            i += 2U;
+            if (dist > IapLzOut) break;
+            while (n--)
+            {
+                IapLzWin[IapLzOut & (IAP_LZ_WINDOW - 1U)] = IapLzWin[(IapLzOut - dist) & (IAP_LZ_WINDOW - 1U)];
+                IapLzOut++;
+            }
+        }
+        bit++;
 
-    if (crc_recv != crc_calc)
+        /* δдݲñڸ */
+        if (IapLzOut - IapLzFlushed >= IAP_LZ_FLUSH)
+        {
+            result = IAP_LzFlush(IapLzFlushed + IAP_LZ_FLUSH);
+            if (result != IAP_RESULT_OK) return result;
+        }
+    }
+
+    /* ǺŲƥԽ: , ͷ */
+    if (i < len)
     {
-        Usart1_Print("CRCERR\r\n");
-        return;
+        IapLzActive = 0;
+        return IAP_RESULT_LZ;
     }
+    return IAP_LzFlush(IapLzOut & ~7UL);
+}
 
-    /* ļ־ */
-    if (payload_len == 0U && address == 0xFFFFFFFFU)
+//****************************************************************************************
+//* ƣIAP_DeltaOld()
+//* ܣȡɾһֽ (Ѹдҳ IapDeltaPrev ȡ)
+//* offset -> ɾƫ (ö˱֤ APP )
+//* ֵֽ, -1 = ҳѸдҾδ
+//* дڣ2026-10-18
+//****************************************************************************************/
+static int16_t IAP_DeltaOld(uint32_t offset)
+{
+    uint32_t page = offset / FLASH_PAGE_SIZE;
+
+    if (page == IapDeltaPrevPage) return IapDeltaPrev[offset % FLASH_PAGE_SIZE];
+    if (IapDeltaDirty[page >> 5] & (1UL << (page & 31U))) return -1;
+    return *(const uint8_t *)(APP_ADDRESS + offset);
+}
+
+//****************************************************************************************
+//* ƣIAP_DeltaCommit()
+//* ܣǰҳؽ (¾): ҳβδǲֱԭ,  Flash ͬʱдҳ
+//*  (IapDeltaOut λҳĩ¾ĩβ)
+//* IAP_RESULT_xxx
+//* дڣ2026-10-18
+//****************************************************************************************/
+static uint8_t IAP_DeltaCommit(void)
+{
+    uint32_t page = (IapDeltaOut - 1U) / FLASH_PAGE_SIZE;
+    uint32_t fill = IapDeltaOut - page * FLASH_PAGE_SIZE;
+    uint32_t addr = APP_ADDRESS + page * FLASH_PAGE_SIZE;
+
+    if (fill < FLASH_PAGE_SIZE) memcpy(&IapDeltaPage[fill], (const uint8_t *)(addr + fill), FLASH_PAGE_SIZE - fill);
+    if (memcmp(IapDeltaPage, (const uint8_t *)addr, FLASH_PAGE_SIZE) == 0) return IAP_RESULT_OK;
+
+    /* ݹһҳ (/ɾʹƽ) */
+    memcpy(IapDeltaPrev, (const uint8_t *)addr, FLASH_PAGE_SIZE);
+    IapDeltaPrevPage = page;
+    IapDeltaDirty[page >> 5] |= 1UL << (page & 31U);
+
+    IapErased[page >> 5] &= ~(1UL << (page & 31U));
+    if (IAP_Flash_EraseLazy(addr, FLASH_PAGE_SIZE) != HAL_OK) return IAP_RESULT_FLASH;
+    if (IAP_Flash_Write(addr, IapDeltaPage, FLASH_PAGE_SIZE) != HAL_OK) return IAP_RESULT_FLASH;
+    return IAP_RESULT_OK;
+}
+
+//****************************************************************************************
+//* ƣIAP_DeltaPut()
+//* ܣ¾һֽ, ҳʱύ
+//* data -> ֵֽ
+//* IAP_RESULT_xxx
+//* дڣ2026-10-18
+//****************************************************************************************/
+static uint8_t IAP_DeltaPut(uint8_t data)
+{
+    if (IapDeltaOut >= IapDeltaNewLen) return IAP_RESULT_DELTA;
+
+    IapDeltaPage[IapDeltaOut % FLASH_PAGE_SIZE] = data;
+    IapDeltaOut++;
+    if ((IapDeltaOut % FLASH_PAGE_SIZE) == 0U) return IAP_DeltaCommit();
+    return IAP_RESULT_OK;
+}
+
+//****************************************************************************************
+//* ƣIAP_DeltaEnd()
+//* ܣ: ύһҳУ¾ CRC32
+//* 
+//* IAP_RESULT_xxx
+//* дڣ2026-10-18
+//****************************************************************************************/
+static uint8_t IAP_DeltaEnd(void)
+{
+    uint8_t result;
+
+    if (!IapDeltaActive) return IAP_RESULT_OK;
+    IapDeltaActive = 0;
+
+    if (IapDeltaOut != IapDeltaNewLen) return IAP_RESULT_DELTA;
+    if (IapDeltaOut % FLASH_PAGE_SIZE)
+    {
+        result = IAP_DeltaCommit();
+        if (result != IAP_RESULT_OK) return result;
+    }
+    if (IAP_CRC32_Update(0, (const uint8_t *)APP_ADDRESS, IapDeltaNewLen) != IapDeltaNewCrc) return IAP_RESULT_IMAGE;
+    if (IAP_JournalAppend(IapDeltaNewLen, IapDeltaNewCrc) != HAL_OK) return IAP_RESULT_FLASH;
+    return IAP_RESULT_OK;
+}
+
+//****************************************************************************************
+//* ƣIAP_DeltaFrame()
+//* ܣִһָ֡
+//* address -> ֡ʼַsrc -> ָݣlen -> ָݳ
+//* IAP_RESULT_xxx (ֹ,  BASE ¿ʼ)
+//* дڣ2026-10-18
+//****************************************************************************************/
+static uint8_t IAP_DeltaFrame(uint32_t address, const uint8_t *src, uint16_t len)
+{
+    uint16_t i = 0;
+    uint8_t  result = IAP_RESULT_OK;
+
+    while (i < len && result == IAP_RESULT_OK)
+    {
+        uint8_t  op = src[i];
+        uint32_t n, from;
+
+        if (op == IAP_DELTA_OP_BASE)
+        {
+            uint32_t old_len, old_crc;
+
+            if (i + 17U > len) { result = IAP_RESULT_DELTA; break; }
+            old_len = (uint32_t)src[i + 1] | ((uint32_t)src[i + 2] << 8) | ((uint32_t)src[i + 3] << 16) | ((uint32_t)src[i + 4] << 24);
+            old_crc = (uint32_t)src[i + 5] | ((uint32_t)src[i + 6] << 8) | ((uint32_t)src[i + 7] << 16) | ((uint32_t)src[i + 8] << 24);
+            IapDeltaNewLen = (uint32_t)src[i + 9] | ((uint32_t)src[i + 10] << 8) | ((uint32_t)src[i + 11] << 16) | ((uint32_t)src[i + 12] << 24);
+            IapDeltaNewCrc = (uint32_t)src[i + 13] | ((uint32_t)src[i + 14] << 8) | ((uint32_t)src[i + 15] << 16) | ((uint32_t)src[i + 16] << 24);
+            i += 17U;
+
+            if (i != 17U || address != APP_ADDRESS) { result = IAP_RESULT_ADDR; break; }
+            if (old_len > APP_AREA_SIZE || IapDeltaNewLen == 0U || IapDeltaNewLen > APP_AREA_SIZE) { result = IAP_RESULT_LEN; break; }
+            if (IAP_CRC32_Update(0, (const uint8_t *)APP_ADDRESS, old_len) != old_crc) { result = IAP_RESULT_BASE; break; }
+
+            /* ǰ: ־¼¾ͷ, ɺύ */
+            IapSessActive = 0;
+            if (IAP_JournalBegin(IapDeltaNewLen, IapDeltaNewCrc, 0) != HAL_OK) { result = IAP_RESULT_FLASH; break; }
+            memset(IapDeltaDirty, 0, sizeof(IapDeltaDirty));
+            IapDeltaPrevPage = 0xFFFFFFFFU;
+            IapDeltaOut = 0;
+            IapDeltaActive = 1;
+            continue;
+        }
+
+        /* ָѿʼĲ */
+        if (!IapDeltaActive || (i == 0U && address != APP_ADDRESS + IapDeltaOut)) { result = IAP_RESULT_DELTA; break; }
+        if (i + 3U > len) { result = IAP_RESULT_DELTA; break; }
+        n = (uint32_t)src[i + 1] | ((uint32_t)src[i + 2] << 8);
+
+        if (op == IAP_DELTA_OP_COPY)
+        {
+            if (i + 7U > len) { result = IAP_RESULT_DELTA; break; }
+            from = (uint32_t)src[i + 3] | ((uint32_t)src[i + 4] << 8) | ((uint32_t)src[i + 5] << 16) | ((uint32_t)src[i + 6] << 24);
+            i += 7U;
+            if (from > APP_AREA_SIZE || n > APP_AREA_SIZE - from) { result = IAP_RESULT_DELTA; break; }
+            while (n-- && result == IAP_RESULT_OK)
+            {
+                int16_t data = IAP_DeltaOld(from++);
+                result = (data < 0) ? IAP_RESULT_DELTA : IAP_DeltaPut((uint8_t)data);
+            }
+        }
+        else if (op == IAP_DELTA_OP_DATA)
+        {
+            i += 3U;
+            if (n > (uint32_t)(len - i)) { result = IAP_RESULT_DELTA; break; }
+            while (n-- && result == IAP_RESULT_OK) result = IAP_DeltaPut(src[i++]);
+        }
+        else
+        {
+            result = IAP_RESULT_DELTA;
+        }
+    }
+
+    if (result != IAP_RESULT_OK) IapDeltaActive = 0;
+    return result;
+}
+
+//****************************************************************************************
+//* ƣIAP_ProcessFrame()
+//* ܣУ鲢ִһ֡ IAP  (Բ + д Flash, ѹ֡Ƚѹ, ֡ҳؽ)
+//* buf -> ֡ (header+len+addr+payload+crc, ɵöȷ)
+//* IAP_RESULT_xxx
+//* дڣ2026-10-18
+//****************************************************************************************/
+static uint8_t IAP_ProcessFrame(uint8_t *buf)
+{
+    uint16_t payload_len = (uint16_t)(buf[2] | (buf[3] << 8));
+    uint32_t address = (uint32_t)(buf[4] | (buf[5] << 8) | (buf[6] << 16) | (buf[7] << 24));
+
+    /* 鳤ȱ߽ */
+    if (payload_len > IAP_MAX_PAYLOAD) return IAP_RESULT_LEN;
+
+    uint8_t raw = (buf[1] == IAP_HEADER2);
+    uint8_t result;
+    uint16_t crc_recv = (uint16_t)(buf[8 + payload_len] | (buf[9 + payload_len] << 8));
+    /* CRC 㣺 Length(2)+Address(4)+Payload(N)  CRC, ֡ header2 (ֹ֡) */
+    uint16_t crc_calc = raw ? IAP_CRC16_Calc(&buf[2], (uint32_t)(6 + payload_len))
+                            : IAP_CRC16_Calc(&buf[1], (uint32_t)(7 + payload_len));
+
+    if (crc_recv != crc_calc) return IAP_RESULT_CRC;
+
+    if (buf[1] == IAP_HEADER2_LZ) return IAP_LzFrame(address, &buf[8], payload_len);
+
+    /* ֡: деѹ */
+    result = IAP_LzEnd();
+    if (result != IAP_RESULT_OK) return result;
+
+    if (buf[1] == IAP_HEADER2_DELTA) return IAP_DeltaFrame(address, &buf[8], payload_len);
+
+    /* ԭʼ֡/֡/ͷ֡: еĲ (У¾) */
+    result = IAP_DeltaEnd();
+    if (result != IAP_RESULT_OK) return result;
+
+    if (buf[1] == IAP_HEADER2_IMAGE)
     {
-        Usart1_Print("DONE\r\n");
-        /* תӦ */
-        IAP_JumpToApplication();
-        return;
+        if (payload_len != 12U || address != APP_ADDRESS) return IAP_RESULT_LEN;
+        return IAP_SessionOpen((uint32_t)buf[8] | ((uint32_t)buf[9] << 8) | ((uint32_t)buf[10] << 16) | ((uint32_t)buf[11] << 24),
+                               (uint32_t)buf[12] | ((uint32_t)buf[13] << 8) | ((uint32_t)buf[14] << 16) | ((uint32_t)buf[15] << 24),
+                               (uint32_t)buf[16] | ((uint32_t)buf[17] << 8) | ((uint32_t)buf[18] << 16) | ((uint32_t)buf[19] << 24));
     }
 
-    /* ַϷԼ飺 APP  */
-    if ((address < APP_ADDRESS) || (address + payload_len > FLASH_BASE_ADDR + FLASH_TOTAL_SIZE))
+    /* ļ־: У */
+    if (payload_len == 0U && address == 0xFFFFFFFFU)
     {
-        Usart1_Print("ADDR_ERR\r\n");
-        return;
+        result = IAP_SessionEnd();
+        return (result == IAP_RESULT_OK) ? IAP_RESULT_DONE : result;
     }
 
-    /* д Flash */
-    IAP_Flash_Write(address, &buf[8], payload_len);
-    Usart1_Print("OK\r\n");
+    if (payload_len == 0U) return IAP_RESULT_OK;
+
+    /* ַ + ״дҳȲ, д Flash */
+    return IAP_Program(address, &buf[8], payload_len);
+}
+
+//****************************************************************************************
+//* ƣIAP_ParseFrame()
+//* ܣһ֡ IAP ݣ USART1 IDLE жϴ, ֡Ӧʽ
+//* buf -> ݻlen -> ݳ
+//* 
+//* дڣ2025-9-02
+//****************************************************************************************/
+void IAP_ParseFrame(uint8_t *buf, uint16_t len)
+{
+    /* С֡ header(2) + len(2) + addr(4) + crc(2) -> 10 ֽ */
+    if (len < 10) return;
+
+    if (buf[0] != IAP_HEADER1 || !IAP_IS_HEADER2(buf[1])) return;
+
+    uint16_t payload_len = (uint16_t)(buf[2] | (buf[3] << 8));
+
+    /* У֡ȣheader+len+addr+payload+crc */
+    if (payload_len <= IAP_MAX_PAYLOAD && (uint32_t)len < (uint32_t)(10 + payload_len)) return;
+
+    uint8_t result = IAP_ProcessFrame(buf);
+    if (result == IAP_RESULT_RESUME)
+        Usart1_Print("%s %lu\r\n", IapResultText[result], (unsigned long)IapSessOut);
+    else
+        Usart1_Print("%s\r\n", IapResultText[result]);
+
+    /* תӦ */
+    if (result == IAP_RESULT_DONE) IAP_JumpToApplication();
+}
+
+//****************************************************************************************
+//* ƣIAP_RxStart()
+//* ܣUSART1 лΪ DMA1_Channel3 ѭ (ر RXNE/IDLE ж,  IAP_Run ѯ)
+//* 
+//* 
+//* дڣ2026-10-18
+//****************************************************************************************/
+static void IAP_RxStart(void)
+{
+    USART1->CR1 &= ~(USART_CR1_RXNEIE | USART_CR1_IDLEIE);
+
+    __HAL_RCC_DMAMUX1_CLK_ENABLE();
+    __HAL_RCC_DMA1_CLK_ENABLE();
+    DMAMUX1_Channel2->CCR = DMA_REQUEST_USART1_RX;
+
+    DMA1_Channel3->CCR = 0;
+    DMA1->IFCR = DMA_IFCR_CGIF3;
+    DMA1_Channel3->CPAR = (uint32_t)&USART1->RDR;
+    DMA1_Channel3->CMAR = (uint32_t)IapRxRing;
+    DMA1_Channel3->CNDTR = IAP_RX_RING_SIZE;
+    DMA1_Channel3->CCR = DMA_CCR_MINC | DMA_CCR_CIRC | DMA_CCR_PL_1;
+
+    USART1->ICR = USART_ICR_IDLECF | USART_ICR_ORECF | USART_ICR_FECF | USART_ICR_NECF;
+    USART1->CR3 |= USART_CR3_DMAR;
+    DMA1_Channel3->CCR |= DMA_CCR_EN;
+    USART1->CR1 |= USART_CR1_RE;
+}
+
+//****************************************************************************************
+//* ƣIAP_RingByte()
+//* ܣȡջеһֽ
+//* idx -> λ (Զ)
+//* 
+//* дڣ2026-10-18
+//****************************************************************************************/
+static uint8_t IAP_RingByte(uint32_t idx)
+{
+    return IapRxRing[idx & IAP_RX_MASK];
+}
+
+//****************************************************************************************
+//* ƣIAP_SilenceMs()
+//* ܣжͽ߾Ĭʱ: IAP_ERR_GAP_MS ӵǰ
+//*           һ֡Ĵʱ (Ͳʱתת, ڼ϶֮䳤)
+//* 
+//* Ĭʱ (ms)
+//* дڣ2026-10-18
+//****************************************************************************************/
+static uint32_t IAP_SilenceMs(void)
+{
+    uint32_t baud = huart1.Init.BaudRate ? huart1.Init.BaudRate : 9600U;
+
+    return IAP_ERR_GAP_MS + (IAP_FRAME_MAX * 10U * 1000U + baud - 1U) / baud;
 }
 
 //****************************************************************************************
 //* ƣIAP_Run()
 //* ܣ IAP ģʽ BootLoader main  Check_IAP_Flag 룩
+//*           DMA պ֡ͬʱд Flash, ۼ֡Ӧ ()
 //* 
 //* 
 //* дڣ2025-9-02
 //****************************************************************************************/
 void IAP_Run(void)
 {
+    uint32_t rd = 0, pos, last_pos = 0;
+    uint32_t avail, need;
+    uint32_t accepted = 0, acked = 0;       /* ۼд֡ / Ӧ֡ */
+    uint32_t rx_tick, silence_ms = IAP_SilenceMs();
+    uint8_t  err = IAP_RESULT_OK;           /*  OK: ʣ, Ĭ󱨸 */
+    uint8_t  result;
+
     /* ֪λģʽ */
     Usart1_Print("Update Mode\r\n");
 
-    /*  APP  */
-    IAP_Flash_EraseApp();
+    /* Ԥ: ҳ״дǰ */
+    memset(IapErased, 0, sizeof(IapErased));
+    IAP_RxStart();
+    rx_tick = HAL_GetTick();
 
-    /*  IAP ѭж Usart1.RxData 䣬IDLE жʱ IAP_ParseFrame */
     while (1)
     {
-        /* ждڴŹι͹ */
-        HAL_Delay(100);
+        /* DMA дλ (ѭģʽ CNDTR ݼ,  0 ʱԶװ) */
+        pos = (IAP_RX_RING_SIZE - DMA1_Channel3->CNDTR) & IAP_RX_MASK;
+        if (pos != last_pos)
+        {
+            last_pos = pos;
+            rx_tick = HAL_GetTick();
+        }
+        avail = (pos - rd) & IAP_RX_MASK;
+
+        /* : ߾Ĭ, ظۼд֡, Ӹ֡ط */
+        if (err != IAP_RESULT_OK)
+        {
+            rd = pos;
+            if ((HAL_GetTick() - rx_tick) >= silence_ms)
+            {
+                Usart1_Print("%s %lu\r\n", IapResultText[err], (unsigned long)accepted);
+                acked = accepted;
+                err = IAP_RESULT_OK;
+            }
+            continue;
+        }
+
+        if (avail >= 4U)
+        {
+            /* ֡ͷͬ */
+            if (IAP_RingByte(rd) != IAP_HEADER1 || !IAP_IS_HEADER2(IAP_RingByte(rd + 1U)))
+            {
+                rd = (rd + 1U) & IAP_RX_MASK;
+                continue;
+            }
+            need = 10U + (uint32_t)(IAP_RingByte(rd + 2U) | (IAP_RingByte(rd + 3U) << 8));
+            if (need > IAP_FRAME_MAX)
+            {
+                err = IAP_RESULT_LEN;
+                continue;
+            }
+            if (avail >= need)
+            {
+                /* ȡ֡ͷŽջռ, дڼ DMA պ֡ */
+                for (uint32_t i = 0; i < need; i++) IapFrame[i] = IAP_RingByte(rd + i);
+                rd = (rd + need) & IAP_RX_MASK;
+
+                result = IAP_ProcessFrame(IapFrame);
+                if (result == IAP_RESULT_OK)
+                {
+                    accepted++;
+                }
+                else if (result == IAP_RESULT_RESUME)
+                {
+                    /* ͷ֡: ظƫ, ֡ 0 ¿ʼ */
+                    Usart1_Print("%s %lu\r\n", IapResultText[result], (unsigned long)IapSessOut);
+                    accepted = acked = 0;
+                }
+                else if (result == IAP_RESULT_DONE)
+                {
+                    if (accepted != acked) Usart1_Print("OK %lu\r\n", (unsigned long)accepted);
+                    Usart1_Print("DONE\r\n");
+                    /* תӦ */
+                    IAP_JumpToApplication();
+                }
+                else
+                {
+                    err = result;
+                }
+                continue;
+            }
+        }
+
+        /* Ӧ: ڴʱ (ʱֹͣ͵ȴӦ), һɽ֡ */
+        if ((accepted - acked) >= IAP_WINDOW)
+        {
+            Usart1_Print("OK %lu\r\n", (unsigned long)accepted);
+            acked = accepted;
+        }
     }
 }
 
@@ -0,0 +1,193 @@
+/****************************************************************************************
+  * @file      key_function.c
+  * @brief     事件驱动按键引擎 (EXTI 边沿 + TIM7 单次定时消抖/长按/连发)
+  * ****************************************************************************************/
+#include "key_function.h"
+#include "DigitalTube_Control.h"
+#include "sched_function.h"
+#include "nvic_config.h"
+
+#define KEY_ALL_PINS        (PIN_MODE | PIN_UP | PIN_DOWN | PIN_SHIFT)
+#define KEY_TIM_HZ          10000           // TIM7 计数频率 (0.1ms 分辨率)
+
+/* 事件队列 (中断写入, 主循环读出) */
+static strKeyEvent       KeyQueue[KEY_QUEUE_SIZE];
+static volatile uint8_t  KeyHead = 0;
+static volatile uint8_t  KeyTail = 0;
+
+/* 引擎状态 (仅在 EXTI/TIM7 中断中访问, 两者同优先级不会互相抢占) */
+static uint8_t  KeyCur = 0;                 // 当前稳定按键 (KEY_ID_xxx, 0 = 无)
+static uint8_t  KeyDebounce = 0;            // 消抖进行中
+static uint8_t  KeyStage = 0;               // 调度阶段: 0 = 无, 1 = 等待长按, 2 = 连发
+static uint16_t KeySpeed = ACCEL_START_MS;  // 当前连发间隔
+static uint32_t KeyDue = 0;                 // 下一次调度时刻 (ms)
+
+/****************************************************************************************
+* 函数名称：Key_Arm
+* 函数功能：启动 TIM7 单次定时 (重新启动会覆盖尚未到期的定时)
+* 输入参量：ms - 定时时间
+* 输出参量：无
+****************************************************************************************/
+static void Key_Arm(uint32_t ms)
+{
+    TIM7->CR1 &= ~TIM_CR1_CEN;
+    TIM7->CNT = 0;
+    TIM7->ARR = ms * (KEY_TIM_HZ / 1000) - 1;
+    TIM7->SR = 0;
+    TIM7->CR1 |= TIM_CR1_CEN;
+}
+
+/****************************************************************************************
+* 函数名称：Key_Schedule
+* 函数功能：调度下一次长按/连发事件, 并记录到期时刻 (消抖打断后据此恢复)
+* 输入参量：ms - 距现在的时间
+* 输出参量：无
+****************************************************************************************/
+static void Key_Schedule(uint32_t ms)
+{
+    KeyDue = HAL_GetTick() + ms;
+    Key_Arm(ms);
+}
+
+/****************************************************************************************
+* 函数名称：Key_Sample
+* 函数功能：读取当前按键 (组合键优先, 单键按 KEY1 > KEY2 > KEY3 > KEY4 取一个)
+* 输入参量：无
+* 输出参量：KEY_ID_xxx, 0 = 无按键
+****************************************************************************************/
+static uint8_t Key_Sample(void)
+{
+    uint32_t idr = DTC_KEY_PORT->IDR;
+    uint8_t up = !(idr & PIN_UP);
+    uint8_t down = !(idr & PIN_DOWN);
+
+    if (up && down) return KEY_ID_RESET;
+    if (!(idr & PIN_MODE)) return KEY_ID_MODE;
+    if (up) return KEY_ID_UP;
+    if (down) return KEY_ID_DOWN;
+    if (!(idr & PIN_SHIFT)) return KEY_ID_SHIFT;
+    return 0;
+}
+
+/****************************************************************************************
+* 函数名称：Key_Push
+* 函数功能：写入一个按键事件 (队列满时丢弃)
+* 输入参量：key - 按键, type - 事件类型
+* 输出参量：无
+****************************************************************************************/
+static void Key_Push(uint8_t key, uint8_t type)
+{
+    uint8_t next = (KeyHead + 1) & (KEY_QUEUE_SIZE - 1);
+
+    if (next == KeyTail) return;
+    KeyQueue[KeyHead].Key = key;
+    KeyQueue[KeyHead].Type = type;
+    KeyHead = next;
+    Sched_Post(SCHED_TASK_KEY);
+}
+
+/****************************************************************************************
+* 函数名称：Key_Init
+* 函数功能：初始化 TIM7 为单次定时器 (按键 EXTI 由 MX_GPIO_Init 配置为双边沿)
+* 输入参量：无
+* 输出参量：无
+****************************************************************************************/
+void Key_Init(void)
+{
+    uint32_t clk = Tim_GetClock(TIM7);
+
+    __HAL_RCC_TIM7_CLK_ENABLE();
+    TIM7->CR1 = TIM_CR1_OPM | TIM_CR1_URS;
+    TIM7->PSC = clk / KEY_TIM_HZ - 1;
+    TIM7->EGR = TIM_EGR_UG;                 // 装载预分频 (URS = 1, 不产生中断)
+    TIM7->SR = 0;
+    TIM7->DIER = TIM_DIER_UIE;
+
+    HAL_NVIC_EnableIRQ(TIM7_IRQn);
+}
+
+/****************************************************************************************
+* 函数名称：HAL_GPIO_EXTI_Callback
+* 函数功能：按键边沿中断: (重新) 启动消抖定时
+* 输入参量：GPIO_Pin - 触发引脚
+* 输出参量：无
+****************************************************************************************/
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+    if (GPIO_Pin & KEY_ALL_PINS) {
+        KeyDebounce = 1;
+        Key_Arm(KEY_DEBOUNCE_MS);
+    }
+}
+
+/****************************************************************************************
+* 函数名称：Key_TimerHandler
+* 函数功能：TIM7 单次定时到期处理 (在 TIM7 中断中调用)
+*           消抖到期: 比较按键状态, 产生释放/按下事件并调度长按
+*           调度到期: 产生长按事件, 加/减键继续按 ACCEL_* 加速连发
+* 输入参量：无
+* 输出参量：无
+****************************************************************************************/
+void Key_TimerHandler(void)
+{
+    uint8_t key = Key_Sample();
+
+    if (KeyDebounce) {
+        KeyDebounce = 0;
+        if (key != KeyCur) {
+            if (KeyCur != 0) Key_Push(KeyCur, KEY_EVT_RELEASE);
+            KeyCur = key;
+            KeyStage = 0;
+            if (key != 0) {
+                Key_Push(key, KEY_EVT_PRESS);
+                if (key != KEY_ID_MODE) {
+                    KeyStage = 1;
+                    KeySpeed = ACCEL_START_MS;
+                    Key_Schedule((key == KEY_ID_RESET) ? KEY_COMBO_MS : KEY_LONG_MS);
+                }
+            }
+        } else if (KeyStage != 0) {
+            // 按住期间的抖动: 恢复被消抖打断的调度
+            int32_t remain = (int32_t)(KeyDue - HAL_GetTick());
+            Key_Arm((remain > 0) ? (uint32_t)remain : 1);
+        }
+        return;
+    }
+
+    // 到期时按键已变化但未捕获到边沿: 按消抖流程处理
+    if (key != KeyCur) {
+        KeyDebounce = 1;
+        Key_Arm(KEY_DEBOUNCE_MS);
+        return;
+    }
+
+    if (KeyStage == 1) {
+        Key_Push(KeyCur, KEY_EVT_LONG);
+        if (KeyCur == KEY_ID_UP || KeyCur == KEY_ID_DOWN) {
+            KeyStage = 2;
+            Key_Schedule(KeySpeed);
+        } else {
+            KeyStage = 0;
+        }
+    } else if (KeyStage == 2) {
+        Key_Push(KeyCur, KEY_EVT_REPEAT);
+        // 平滑加速
+        if (KeySpeed > ACCEL_MIN_MS) KeySpeed -= ACCEL_STEP;
+        Key_Schedule(KeySpeed);
+    }
+}
+
+/****************************************************************************************
+* 函数名称：Key_GetEvent
+* 函数功能：取出一个按键事件 (在主循环中调用)
+* 输入参量：evt - 输出事件
+* 输出参量：1 = 取到事件, 0 = 队列空
+****************************************************************************************/
+uint8_t Key_GetEvent(strKeyEvent *evt)
+{
+    if (KeyTail == KeyHead) return 0;
+
+    *evt = KeyQueue[KeyTail];
+    KeyTail = (KeyTail + 1) & (KEY_QUEUE_SIZE - 1);
+    return 1;
+}
@@ -0,0 +1,131 @@
+/****************************************************************************************
+  * @file      modbus_cache.c
+  * @brief     Modbus 从站读应答缓存 (按寄存器区写入代数失效, 增量重建)
+  * ****************************************************************************************/
+#include "modbus_cache.h"
+#include "uart_config.h"
+#include "nvic_config.h"
+
+/* 缓存项 */
+typedef struct {
+    uint8_t  Func;                              // 功能码 (0 = 空项)
+    uint16_t Addr;                              // 起始地址
+    uint16_t Count;                             // 寄存器数量
+    uint32_t Gen;                               // 构建时的寄存器区代数
+    uint32_t LastUse;                           // 最近使用序号 (LRU 替换)
+    uint8_t  Frame[MODBUS_CACHE_FRAME_SIZE];    // 完整应答帧 (DMA 发送源)
+} strModBusCacheEntry;
+
+static strModBusCacheEntry ModBusCache[MODBUS_CACHE_ENTRIES];
+static uint32_t ModBusCacheUse = 0;
+
+/* 寄存器区代数及每个寄存器最近一次变化时的代数 */
+static volatile uint32_t RegionGen[MODBUS_REGION_COUNT];
+static volatile uint32_t RegGen[MODBUS_REGION_COUNT][MODBUS_REGISTER_COUNT];
+
+/****************************************************************************************
+* 函数名称：ModBus_RegionRegs
+* 函数功能：寄存器区对应的寄存器数组
+* 输入参量：region - 寄存器区
+* 输出参量：寄存器数组指针
+****************************************************************************************/
+static volatile uint16_t *ModBus_RegionRegs(uint8_t region)
+{
+    return (region == MODBUS_REGION_HOLDING) ? ModBus.Slave.DisplayRegisters : ModBus.Master.DisplayRegisters;
+}
+
+/****************************************************************************************
+* 函数名称：ModBus_RegWrite
+* 函数功能：写寄存器并在值变化时标记代数 (主循环与中断均可调用)
+*           值未变化时不标记, 缓存保持有效
+* 输入参量：region - 寄存器区, idx - 寄存器下标, value - 新值
+* 输出参量：无
+****************************************************************************************/
+void ModBus_RegWrite(uint8_t region, uint16_t idx, uint16_t value)
+{
+    volatile uint16_t *regs = ModBus_RegionRegs(region);
+    uint32_t lock;
+
+    if (idx >= MODBUS_REGISTER_COUNT || regs[idx] == value) return;
+
+    // 当前写入方均为调度任务; 锁到通信级, 保留从 USART1 中断调用的余地, 编码器/继电器中断不受影响
+    lock = Irq_Lock(IRQ_PRIO_COMM);
+    regs[idx] = value;
+    RegGen[region][idx] = RegionGen[region] + 1;
+    RegionGen[region] = RegGen[region][idx];
+    Irq_Unlock(lock);
+}
+
+/****************************************************************************************
+* 函数名称：ModBus_CacheFill
+* 函数功能：构建/增量更新缓存项 (full = 1 时全部重建)
+* 输入参量：e - 缓存项, region - 寄存器区, full - 是否全部重建
+* 输出参量：无
+****************************************************************************************/
+static void ModBus_CacheFill(strModBusCacheEntry *e, uint8_t region, uint8_t full)
+{
+    volatile uint16_t *regs = ModBus_RegionRegs(region);
+    uint8_t len = 3 + e->Count * 2;
+    uint16_t i;
+
+    if (full) {
+        e->Frame[0] = ModBus.Slave.ADDR;
+        e->Frame[1] = e->Func;
+        e->Frame[2] = (uint8_t)(e->Count * 2);
+    }
+    for (i = 0; i < e->Count; i++) {
+        if (full || RegGen[region][e->Addr + i] > e->Gen) {
+            uint16_t regValue = regs[e->Addr + i];
+            e->Frame[3 + i * 2] = (uint8_t)(regValue >> 8);
+            e->Frame[4 + i * 2] = (uint8_t)(regValue & 0xFF);
+        }
+    }
+
+    uint16_t crc = Modbus_CRC16(e->Frame, len);
+    e->Frame[len] = (uint8_t)(crc & 0xFF);
+    e->Frame[len + 1] = (uint8_t)(crc >> 8);
+}
+
+/****************************************************************************************
+* 函数名称：ModBus_CacheReply
+* 函数功能：发送 03/04 读应答: 命中且未过期直接 DMA 发送, 过期则增量更新, 未命中按 LRU 替换
+*           调用前已校验 addr + count <= MODBUS_REGISTER_COUNT
+* 输入参量：func - 功能码, addr - 起始地址, count - 寄存器数量
+* 输出参量：无
+****************************************************************************************/
+void ModBus_CacheReply(uint8_t func, uint16_t addr, uint16_t count)
+{
+    uint8_t region = (func == MODBUS_FUNC_READ_HOLDING_REGISTERS) ? MODBUS_REGION_HOLDING : MODBUS_REGION_INPUT;
+    strModBusCacheEntry *e = NULL;
+    uint8_t i;
+
+    for (i = 0; i < MODBUS_CACHE_ENTRIES; i++) {
+        if (ModBusCache[i].Func == func && ModBusCache[i].Addr == addr && ModBusCache[i].Count == count) {
+            e = &ModBusCache[i];
+            break;
+        }
+    }
+
+    if (e != NULL) {
+        uint32_t gen = RegionGen[region];
+        if (e->Gen != gen) {
+            ModBus_CacheFill(e, region, 0);
+            e->Gen = gen;
+        }
+    } else {
+        e = &ModBusCache[0];
+        for (i = 1; i < MODBUS_CACHE_ENTRIES; i++) {
+            if (ModBusCache[i].LastUse < e->LastUse) e = &ModBusCache[i];
+        }
+        e->Func = func;
+        e->Addr = addr;
+        e->Count = count;
+        e->Gen = RegionGen[region];
+        ModBus_CacheFill(e, region, 1);
+    }
+    e->LastUse = ++ModBusCacheUse;
+
+    Usart1.Tx.Data = e->Frame;
+    Usart1.Tx.DataSize = 5 + count * 2;
+    Usart1TransmitterDMA(&Usart1.Tx);
+}
@@ -3,17 +3,29 @@
   * @brief     Modbus 通信协议实现
   * ****************************************************************************************/
 #include "modbus_function.h"
+#include "modbus_cache.h"
+#include "param_table.h"
 #include "uart_config.h"
 #include "relay_control.h"
+#include "relay_sequence.h"
 #include "usart.h"
 #include <string.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include "iap_function.h"
 #include "delay_function.h"
+#include "sched_function.h"
+#include "perf_function.h"
+#include "trace_function.h"
 
 volatile strModBus ModBus = {0};
 
+/* 继电器请求被拒绝时的异常码: 互锁冲突 03 (非法数据值), 先断后合死区时间内 06 (从站忙) */
+#define MODBUS_RELAY_EXCEPTION(err)     (((err) == RELAY_ERR_BUSY) ? 0x06 : 0x03)
+
+/* 10H 最大帧 (地址 + 功能码 + 起始 2 + 数量 2 + 字节数 + 数据 + CRC 2) 须能完整收入 USART1 接收缓冲区 */
+STATIC_ASSERT(9 + MODBUS_WRITE_MAX_REGS * 2 <= Usart1RxSize, rx10_frame);
+
 /****************************************************************************************
 * 函数名称：Modbus_CRC16
 * 函数功能：计算 Modbus RTU 帧的 CRC16 校验码
@@ -84,8 +96,9 @@ void ModBus_SlaveRx03DataCollation(void)
     if(ModBus.Slave.Rx.DataSize >= 29){
         return;
     }
-    ModBus.Slave.Rx.CRCLow = (uint8_t)((Modbus_CRC16((uint8_t *)Usart1.RxData, 6)) & 0xFF);
-    ModBus.Slave.Rx.CRCHigh = (uint8_t)((Modbus_CRC16((uint8_t *)Usart1.RxData, 6)) >> 8) & 0xFF;    
+    uint16_t crc_calc = Modbus_CRC16((uint8_t *)Usart1.RxData, 6);
+    ModBus.Slave.Rx.CRCLow = (uint8_t)(crc_calc & 0xFF);
+    ModBus.Slave.Rx.CRCHigh = (uint8_t)(crc_calc >> 8);    
 }
 
 /****************************************************************************************
@@ -99,26 +112,41 @@ void ModBus_SlaveRx03DataCollation(void)
 ****************************************************************************************/
 void ModBus_SlaveReturnTx03(uint16_t ReturnDataStart, uint16_t ReturnDataLen)
 {
-    uint16_t i;
-    uint8_t data_bytes = ReturnDataLen * 2;
-    uint8_t frame_len_no_crc = 3 + data_bytes;
+    // 应答由缓存构建, 寄存器未变化时直接发送上次的帧
+    ModBus_CacheReply(MODBUS_FUNC_READ_HOLDING_REGISTERS, ReturnDataStart, ReturnDataLen);
+}
 
+/****************************************************************************************
+* 函数名称：ModBus_SlaveReturnParam03
+* 函数功能：Modbus 03H/04H 读扩展窗口: PA 参数 (PARAM_MODBUS_BASE 起, 每个参数两个寄存器),
+*           继电器时序引擎 (RSEQ_MODBUS_BASE 起) 或代码段耗时统计 (PERF_MODBUS_BASE 起)
+* 输入参量：
+* - ReturnDataStart：起始寄存器地址
+* - ReturnDataLen：返回的寄存器数量
+* 输出参量：无
+* 编写日期：2026-10-18
+****************************************************************************************/
+void ModBus_SlaveReturnParam03(uint16_t ReturnDataStart, uint16_t ReturnDataLen)
+{
+    uint8_t frame_len_no_crc = 3 + ReturnDataLen * 2;
+    uint8_t err = (ReturnDataStart >= PERF_MODBUS_BASE) ?
+                  Perf_ModbusRead(ReturnDataStart, ReturnDataLen, &Usart1.TxData[3]) :
+                  (ReturnDataStart >= RSEQ_MODBUS_BASE) ?
+                  RelaySeq_ModbusRead(ReturnDataStart, ReturnDataLen, &Usart1.TxData[3]) :
+                  Param_ModbusRead(ReturnDataStart, ReturnDataLen, &Usart1.TxData[3]);
+
+    if (err) {
+        ModBus_Slave_SendErrorResponse(err);
+        return;
+    }
     Usart1.TxData[0] = ModBus.Slave.ADDR;
     Usart1.TxData[1] = ModBus.Slave.CMD;
-    Usart1.TxData[2] = data_bytes;
+    Usart1.TxData[2] = ReturnDataLen * 2;
 
-    for (i = 0; i < ReturnDataLen; i++) {
-        if ((ReturnDataStart + i) < MODBUS_REGISTER_COUNT) {
-            uint16_t regValue = ModBus.Slave.DisplayRegisters[ReturnDataStart + i];
-            Usart1.TxData[3 + i * 2] = (uint8_t)(regValue >> 8);
-            Usart1.TxData[4 + i * 2] = (uint8_t)(regValue & 0xFF);
-        }
-    }
-    
     uint16_t crc = Modbus_CRC16((uint8_t *)Usart1.TxData, frame_len_no_crc);
     Usart1.TxData[frame_len_no_crc] = (uint8_t)(crc & 0xFF);
     Usart1.TxData[frame_len_no_crc + 1] = (uint8_t)(crc >> 8);
-    
+
     Usart1.Tx.Data = (uint8_t *)Usart1.TxData;
     Usart1.Tx.DataSize = frame_len_no_crc + 2;
     Usart1TransmitterDMA(&Usart1.Tx);
@@ -136,9 +164,12 @@ void ModBus_SlaveRx03(void)
     if(Usart1.DataCnt == 8){
         ModBus_SlaveRx03DataCollation();
         if(Usart1.RxData[6] != ModBus.Slave.Rx.CRCLow || Usart1.RxData[7] != ModBus.Slave.Rx.CRCHigh){
+            ModBus.Slave.CrcErrorCount++;
             ModBus_Slave_SendErrorResponse(0x01); // CRC 校验错误
         }else{
-            if ((ModBus.Slave.Rx.DataAddr + ModBus.Slave.Rx.DataSize) <= MODBUS_REGISTER_COUNT) {
+            if (ModBus.Slave.Rx.DataAddr >= PARAM_MODBUS_BASE) {
+                 ModBus_SlaveReturnParam03(ModBus.Slave.Rx.DataAddr, ModBus.Slave.Rx.DataSize);
+            } else if ((ModBus.Slave.Rx.DataAddr + ModBus.Slave.Rx.DataSize) <= MODBUS_REGISTER_COUNT) {
                  ModBus_SlaveReturnTx03(ModBus.Slave.Rx.DataAddr, ModBus.Slave.Rx.DataSize);
             } else {
                  ModBus_Slave_SendErrorResponse(0x02); // 非法数据地址
@@ -177,30 +208,8 @@ void ModBus_SlaveRx04DataCollation(void)
 ****************************************************************************************/
 void ModBus_SlaveReturnTx04(uint16_t SourceDataStart, uint16_t ReturnDataLen)
 {
-    uint16_t i;
-    uint8_t data_bytes = ReturnDataLen * 2;
-    uint8_t frame_len_no_crc = 3 + data_bytes;
-
-    Usart1.TxData[0] = ModBus.Slave.ADDR;
-    Usart1.TxData[1] = 0x04; // 功能码是 04
-    Usart1.TxData[2] = data_bytes;
-
-    for (i = 0; i < ReturnDataLen; i++) {
-        if ((SourceDataStart + i) < MODBUS_REGISTER_COUNT) {
-            // 注意：数据源是主机读取 ADC 模块返回的数据
-            uint16_t regValue = ModBus.Master.DisplayRegisters[SourceDataStart + i];
-            Usart1.TxData[3 + i * 2] = (uint8_t)(regValue >> 8);
-            Usart1.TxData[4 + i * 2] = (uint8_t)(regValue & 0xFF);
-        }
-    }
-    
-    uint16_t crc = Modbus_CRC16((uint8_t *)Usart1.TxData, frame_len_no_crc);
-    Usart1.TxData[frame_len_no_crc] = (uint8_t)(crc & 0xFF);
-    Usart1.TxData[frame_len_no_crc + 1] = (uint8_t)(crc >> 8);
-    
-    Usart1.Tx.Data = (uint8_t *)Usart1.TxData;
-    Usart1.Tx.DataSize = frame_len_no_crc + 2;
-    Usart1TransmitterDMA(&Usart1.Tx);
+    // 数据源是主站读取外部仪表返回的数据 (0-7 为继电器状态), 应答由缓存构建
+    ModBus_CacheReply(MODBUS_FUNC_READ_INPUT_REGISTERS, SourceDataStart, ReturnDataLen);
 }
 
 /****************************************************************************************
@@ -214,12 +223,18 @@ void ModBus_SlaveRx04(void)
     if (Usart1.DataCnt == 8) {
         ModBus_SlaveRx04DataCollation();
         if (Usart1.RxData[6] != ModBus.Slave.Rx.CRCLow || Usart1.RxData[7] != ModBus.Slave.Rx.CRCHigh) {
+            ModBus.Slave.CrcErrorCount++;
             ModBus_Slave_SendErrorResponse(0x01); // CRC 校验错误
         } else {
-            if ((ModBus.Slave.Rx.DataAddr + ModBus.Slave.Rx.DataSize) <= MODBUS_REGISTER_COUNT) {                            
+            if (ModBus.Slave.Rx.DataAddr >= PERF_MODBUS_BASE) {
+                // 代码段耗时统计 (只读)
+                ModBus_SlaveReturnParam03(ModBus.Slave.Rx.DataAddr, ModBus.Slave.Rx.DataSize);
+            } else if ((ModBus.Slave.Rx.DataAddr + ModBus.Slave.Rx.DataSize) <= MODBUS_REGISTER_COUNT) {                            
+                // 0-7 为继电器状态 (一次读取, 同一时刻的快照), 其余为主站轮询的外部仪表数据 (见 modbus_master.h)
+                uint8_t relays = Relay_GetMask();
                 for (i = 0; i < ModBus.Slave.Rx.DataSize; i++) {
-                    if ((ModBus.Slave.Rx.DataSize + i) < MODBUS_REGISTER_COUNT) {
-                        ModBus.Master.DisplayRegisters[ModBus.Slave.Rx.DataAddr + i] = Relay_GetStatus(ModBus.Slave.Rx.DataAddr + i + 1);
+                    if ((ModBus.Slave.Rx.DataAddr + i) < RELAY_COUNT) {
+                        ModBus_RegWrite(MODBUS_REGION_INPUT, ModBus.Slave.Rx.DataAddr + i, (relays >> (ModBus.Slave.Rx.DataAddr + i)) & 1U);
                     }
                 }                            
                 ModBus_SlaveReturnTx04(ModBus.Slave.Rx.DataAddr, ModBus.Slave.Rx.DataSize);
@@ -247,8 +262,9 @@ void ModBus_SlaveRx06DataCollation(void)
     ModBus.Slave.Rx.DataHigh[0] = Usart1.RxData[4];
     ModBus.Slave.Rx.DataLow[0] = Usart1.RxData[5];
     ModBus.Slave.Rx.Data[0] = ((ModBus.Slave.Rx.DataHigh[0] << 8) | ModBus.Slave.Rx.DataLow[0]) & 0xFFFF;
-    ModBus.Slave.Rx.CRCLow = (uint8_t)((Modbus_CRC16((uint8_t *)Usart1.RxData, 6)) & 0xFF);
-    ModBus.Slave.Rx.CRCHigh = (uint8_t)((Modbus_CRC16((uint8_t *)Usart1.RxData, 6)) >> 8) & 0xFF; 
+    uint16_t crc_calc = Modbus_CRC16((uint8_t *)Usart1.RxData, 6);
+    ModBus.Slave.Rx.CRCLow = (uint8_t)(crc_calc & 0xFF);
+    ModBus.Slave.Rx.CRCHigh = (uint8_t)(crc_calc >> 8); 
 }
 
 /****************************************************************************************
@@ -278,13 +294,16 @@ void ModBus_SlaveRx06(void)
     if(Usart1.DataCnt == 8){
         ModBus_SlaveRx06DataCollation();
         if(Usart1.RxData[6] != ModBus.Slave.Rx.CRCLow || Usart1.RxData[7] != ModBus.Slave.Rx.CRCHigh){
+            ModBus.Slave.CrcErrorCount++;
             ModBus_Slave_SendErrorResponse(0x01); // CRC 校验错误
         }else{
+            uint8_t relay_err;
             // 先判断特殊命令地址
             switch(ModBus.Slave.Rx.DataAddr){
-                case 0x0000:  // 全部关闭
-                    Relay_AllOff();
-                    ModBus_SlaveReturnTx06();
+                case 0x0000:  // 全部关闭 (时序引擎播放中返回异常)
+                    relay_err = Relay_SetMask(0);
+                    if (relay_err) ModBus_Slave_SendErrorResponse(MODBUS_RELAY_EXCEPTION(relay_err));
+                    else ModBus_SlaveReturnTx06();
                     break;
                 case 0x0001:  // 继电器1-8
                 case 0x0002:
@@ -295,24 +314,31 @@ void ModBus_SlaveRx06(void)
                 case 0x0007:
                 case 0x0008:
                     if(ModBus.Slave.Rx.Data[0])
-                        Relay_On(ModBus.Slave.Rx.DataAddr);
+                        relay_err = Relay_Apply(1U << (ModBus.Slave.Rx.DataAddr - 1), 0);
                     else
-                        Relay_Off(ModBus.Slave.Rx.DataAddr);
-                    ModBus_SlaveReturnTx06();
+                        relay_err = Relay_Apply(0, 1U << (ModBus.Slave.Rx.DataAddr - 1));
+                    if (relay_err) ModBus_Slave_SendErrorResponse(MODBUS_RELAY_EXCEPTION(relay_err));
+                    else ModBus_SlaveReturnTx06();
                     break;
 								case 0x0009:
 									PWR_CTRL_Enable();
 									ModBus_SlaveReturnTx06();
 								break;
-                case 0x00FF:  // 全部打开
-                    Relay_AllOn();
-                    ModBus_SlaveReturnTx06();                       
+                case 0x00FF:  // 全部打开 (存在互锁组时返回异常)
+                    relay_err = Relay_SetMask(RELAY_MASK_ALL);
+                    if (relay_err) ModBus_Slave_SendErrorResponse(MODBUS_RELAY_EXCEPTION(relay_err));
+                    else ModBus_SlaveReturnTx06();
                     break;
                 default:
                     // 普通寄存器写入，需要检查范围
                     if ((ModBus.Slave.Rx.DataAddr + 1) <= MODBUS_REGISTER_COUNT) {
-                        ModBus.Slave.DisplayRegisters[ModBus.Slave.Rx.DataAddr] = ModBus.Slave.Rx.Data[0];
+                        ModBus_RegWrite(MODBUS_REGION_HOLDING, ModBus.Slave.Rx.DataAddr, ModBus.Slave.Rx.Data[0]);
                         ModBus_SlaveReturnTx06();
+                    } else if (ModBus.Slave.Rx.DataAddr >= RSEQ_MODBUS_BASE) {
+                        // 继电器时序引擎: 启动/停止/条目数
+                        uint8_t err = RelaySeq_ModbusWrite(ModBus.Slave.Rx.DataAddr, 1, ModBus.Slave.Rx.Data);
+                        if (err) ModBus_Slave_SendErrorResponse(err);
+                        else ModBus_SlaveReturnTx06();
                     } else {
                         ModBus_Slave_SendErrorResponse(0x02); // 非法数据地址
                     }
@@ -346,7 +372,7 @@ void ModBus_SlaveRx10DataCollation(void)
     ModBus.Slave.Rx.DataSize = Usart1.RxData[6];
 
     // 检查数据个数是否超过最大支持范围
-    if (dataCount >= 29) {
+    if (dataCount > MODBUS_WRITE_MAX_REGS) {
         return;
     }
 
@@ -400,14 +426,28 @@ void ModBus_SlaveRx10(void)
         uint16_t crc_calc = Modbus_CRC16((uint8_t *)Usart1.RxData, expected_len - 2);
 
         if (crc_calc != crc_received) {
+            ModBus.Slave.CrcErrorCount++;
             ModBus_Slave_SendErrorResponse(0x01); // CRC 校验错误
         } else {
             ModBus_SlaveRx10DataCollation();
             uint16_t reg_count = ((uint16_t)ModBus.Slave.Rx.DataCountHigh << 8) | ModBus.Slave.Rx.DataCountLow;
             
-            if ((ModBus.Slave.Rx.DataAddr + reg_count) <= MODBUS_REGISTER_COUNT) {
+            if (reg_count == 0 || reg_count > MODBUS_WRITE_MAX_REGS || byte_count != reg_count * 2) {
+                // 数量超出整理范围时 Rx.Data 未更新, 不能交给写入函数
+                ModBus_Slave_SendErrorResponse(0x03);
+            } else if (ModBus.Slave.Rx.DataAddr >= RSEQ_MODBUS_BASE) {
+                // 继电器时序引擎: 时序表上传, 最后写 CTRL 可在同一帧中启动
+                uint8_t err = RelaySeq_ModbusWrite(ModBus.Slave.Rx.DataAddr, reg_count, ModBus.Slave.Rx.Data);
+                if (err) ModBus_Slave_SendErrorResponse(err);
+                else ModBus_SlaveReturnTx10();
+            } else if (ModBus.Slave.Rx.DataAddr >= PARAM_MODBUS_BASE) {
+                // PA 参数窗口: 按属性表检查范围
+                uint8_t err = Param_ModbusWrite(ModBus.Slave.Rx.DataAddr, reg_count, ModBus.Slave.Rx.Data);
+                if (err) ModBus_Slave_SendErrorResponse(err);
+                else ModBus_SlaveReturnTx10();
+            } else if ((ModBus.Slave.Rx.DataAddr + reg_count) <= MODBUS_REGISTER_COUNT) {
                 for (uint16_t i = 0; i < reg_count; i++) {
-                    ModBus.Slave.DisplayRegisters[ModBus.Slave.Rx.DataAddr + i] = ModBus.Slave.Rx.Data[i];
+                    ModBus_RegWrite(MODBUS_REGION_HOLDING, ModBus.Slave.Rx.DataAddr + i, ModBus.Slave.Rx.Data[i]);
                 }
                 ModBus_SlaveReturnTx10();
             } else {
@@ -419,6 +459,116 @@ void ModBus_SlaveRx10(void)
     }
 }
 
+/****************************************************************************************
+* 函数名称：ModBus_SlaveRx0F
+* 函数功能：处理 Modbus 0FH 命令 (写多个线圈): 线圈 0-7 对应继电器 K1-K8,
+*           所选线圈合成一次 BSRR 写入, 同时切换 (应答格式与 10H 相同)
+* 输入参量：无
+* 输出参量：无
+* 编写日期：2026-10-18
+****************************************************************************************/
+void ModBus_SlaveRx0F(void)
+{
+    uint8_t byte_count = Usart1.RxData[6];
+    uint16_t expected_len = 9 + byte_count;
+
+    if (Usart1.DataCnt == expected_len) {
+        uint16_t crc_received = ((uint16_t)Usart1.RxData[expected_len - 1] << 8) | Usart1.RxData[expected_len - 2];
+        uint16_t crc_calc = Modbus_CRC16((uint8_t *)Usart1.RxData, expected_len - 2);
+
+        if (crc_calc != crc_received) {
+            ModBus.Slave.CrcErrorCount++;
+            ModBus_Slave_SendErrorResponse(0x01); // CRC 校验错误
+        } else {
+            ModBus.Slave.Rx.DataAddrHigh = Usart1.RxData[2];
+            ModBus.Slave.Rx.DataAddrLow = Usart1.RxData[3];
+            ModBus.Slave.Rx.DataAddr = ((ModBus.Slave.Rx.DataAddrHigh << 8) | ModBus.Slave.Rx.DataAddrLow) & 0xFFFF;
+            ModBus.Slave.Rx.DataCountHigh = Usart1.RxData[4];
+            ModBus.Slave.Rx.DataCountLow = Usart1.RxData[5];
+            uint16_t coil_count = ((uint16_t)ModBus.Slave.Rx.DataCountHigh << 8) | ModBus.Slave.Rx.DataCountLow;
+
+            if (coil_count == 0 || byte_count != (coil_count + 7) / 8) {
+                ModBus_Slave_SendErrorResponse(0x03); // 非法数据值
+            } else if (ModBus.Slave.Rx.DataAddr + coil_count > RELAY_COUNT) {
+                ModBus_Slave_SendErrorResponse(0x02); // 非法地址
+            } else {
+                uint8_t sel = (uint8_t)(((1U << coil_count) - 1U) << ModBus.Slave.Rx.DataAddr);
+                uint8_t on = (uint8_t)(Usart1.RxData[7] << ModBus.Slave.Rx.DataAddr) & sel;
+                uint8_t relay_err = Relay_Apply(on, sel & ~on);
+                if (relay_err) ModBus_Slave_SendErrorResponse(MODBUS_RELAY_EXCEPTION(relay_err));
+                else ModBus_SlaveReturnTx10();
+            }
+        }
+    } else {
+        ModBus_Slave_SendErrorResponse(0x03); // 长度错误
+    }
+}
+
+/****************************************************************************************
+* 函数名称：ModBus_SlaveRx14
+* 函数功能：处理 Modbus 14H 命令 (读文件记录): 读出事件追踪缓冲区 (文件号见 trace_function.h),
+*           每个子请求 7 字节 (参考类型 6, 文件号, 记录号, 寄存器数), 应答数据总长不超过 245 字节
+* 输入参量：无
+* 输出参量：无
+* 编写日期：2026-10-18
+****************************************************************************************/
+void ModBus_SlaveRx14(void)
+{
+    uint8_t byte_count = Usart1.RxData[2];
+    uint16_t expected_len = 5 + byte_count;
+
+    if (Usart1.DataCnt == expected_len && byte_count >= 7 && byte_count <= 0xF5 && (byte_count % 7) == 0) {
+        uint16_t crc_received = ((uint16_t)Usart1.RxData[expected_len - 1] << 8) | Usart1.RxData[expected_len - 2];
+        uint16_t crc_calc = Modbus_CRC16((uint8_t *)Usart1.RxData, expected_len - 2);
+
+        if (crc_calc != crc_received) {
+            ModBus.Slave.CrcErrorCount++;
+            ModBus_Slave_SendErrorResponse(0x01); // CRC 校验错误
+            return;
+        }
+
+        uint16_t pos = 3;       // 应答子响应写入位置
+        uint8_t i;
+
+        for (i = 0; i < byte_count; i += 7) {
+            volatile uint8_t *req = &Usart1.RxData[3 + i];
+            uint16_t file = ((uint16_t)req[1] << 8) | req[2];
+            uint16_t reg = ((uint16_t)req[3] << 8) | req[4];
+            uint16_t count = ((uint16_t)req[5] << 8) | req[6];
+            uint8_t err;
+
+            if (req[0] != 6) {
+                ModBus_Slave_SendErrorResponse(0x02); // 参考类型错误
+                return;
+            }
+            if ((pos - 3) + 2 + (uint32_t)count * 2 > 0xF5) {
+                ModBus_Slave_SendErrorResponse(0x03); // 应答超长
+                return;
+            }
+            err = Trace_ModbusReadFile(file, reg, count, &Usart1.TxData[pos + 2]);
+            if (err) {
+                ModBus_Slave_SendErrorResponse(err);
+                return;
+            }
+            Usart1.TxData[pos] = (uint8_t)(1 + count * 2);
+            Usart1.TxData[pos + 1] = 6;
+            pos += 2 + count * 2;
+        }
+
+        Usart1.TxData[0] = ModBus.Slave.ADDR;
+        Usart1.TxData[1] = ModBus.Slave.CMD;
+        Usart1.TxData[2] = (uint8_t)(pos - 3);
+        uint16_t crc = Modbus_CRC16((uint8_t *)Usart1.TxData, (uint8_t)pos);
+        Usart1.TxData[pos] = (uint8_t)(crc & 0xFF);
+        Usart1.TxData[pos + 1] = (uint8_t)(crc >> 8);
+        Usart1.Tx.Data = (uint8_t *)Usart1.TxData;
+        Usart1.Tx.DataSize = pos + 2;
+        Usart1TransmitterDMA(&Usart1.Tx);
+    } else {
+        ModBus_Slave_SendErrorResponse(0x03); // 长度错误
+    }
+}
+
 /****************************************************************************************
 * 函数名称：ModBus_SlaveRx
 * 函数功能：根据接收到的 Modbus 帧解析命令并调用对应的处理函数
@@ -433,6 +583,7 @@ void ModBus_SlaveRx(void)
     ModBus.Slave.CMD = Usart1.RxData[1];
     
     if(ModBus.Slave.ADDR == 3 ){ // 站地址检查
+        ModBus.Slave.FrameCount++;
         switch(ModBus.Slave.CMD){
             case 0x03:
                 ModBus_SlaveRx03();
@@ -443,14 +594,22 @@ void ModBus_SlaveRx(void)
             case 0x06:
                 ModBus_SlaveRx06();
             break;
+            case 0x0F:
+                ModBus_SlaveRx0F();
+            break;
             case 0x10:
                 ModBus_SlaveRx10();
             break;
+            case 0x14:
+                ModBus_SlaveRx14();
+            break;
             default:
                 ModBus_Slave_SendErrorResponse(0x05); // 功能码不支持
             break;
         }       
+        Usart1.DataCnt = 0;     // 接收保持关闭, 应答发送完成后重新打开
     }else{
+        Usart1.DataCnt = 0;
         EnableUARTReceive(&huart1);
     }
 }
@@ -469,46 +628,5 @@ void Usart1_ReceiveStringHandler(void)
     Usart1.RxData[Usart1.DataCnt - 2] = '\0';  // 替换 '\r' 为字符串结束符
     Usart1.RxData[Usart1.DataCnt - 1] = '\0';  // 替换 '\n' 为字符串结束符
     Usart1.StringFlag = 1;
+    Sched_Post(SCHED_TASK_CMD);
 }
-
-/****************************************************************************************
-* 函数名称：Usart1_SendStringHandler
-* 函数功能：根据接收到的字符串命令进行逻辑处理与响应
-* 输入参量：无
-* 输出参量：无
-* 编写日期：2025-8-27
-****************************************************************************************/
-void Usart1_SendStringHandler(void)
-{
-    if(strcmp((char *)Usart1.RxData, "Board Status") == 0){
-        Usart1_Print("Relay: K1:%s K2:%s K3:%s K4:%s K5:%s K6:%s K7:%s K8:%s\n",
-                     Relay_GetStatus(1) ? "ON" : "OFF",
-                     Relay_GetStatus(2) ? "ON" : "OFF",
-                     Relay_GetStatus(3) ? "ON" : "OFF",
-                     Relay_GetStatus(4) ? "ON" : "OFF",
-                     Relay_GetStatus(5) ? "ON" : "OFF",
-                     Relay_GetStatus(6) ? "ON" : "OFF",
-                     Relay_GetStatus(7) ? "ON" : "OFF",
-                     Relay_GetStatus(8) ? "ON" : "OFF");
-    }else if(strcmp((char *)Usart1.RxData, "Board Info") == 0){
-        Usart1_Print("MCU: STM32G491CCU6\n");
-        Usart1_Print("FW: V2.0\n");
-        Usart1_Print("HW: Encoder FCT Board V1.0\n");
-        Usart1_Print("K1-K8 -> PA0-PA7\n");
-    }else if(strcmp((char *)Usart1.RxData, "Firmware Update") == 0){
-        IAP_RequestUpdate();
-    }else if(strcmp((char *)Usart1.RxData, "Firmware version") == 0){
-        Usart1_Print("V2.0\r\n");
-    }else if(strcmp((char *)Usart1.RxData, "Relay AllOn") == 0){
-        Relay_AllOn();
-        Usart1_Print("OK\r\n");
-    }else if(strcmp((char *)Usart1.RxData, "Relay AllOff") == 0){
-        Relay_AllOff();
-        Usart1_Print("OK\r\n");
-    }else{
-        EnableUARTReceive(&huart1);
-    }
-    
-    memset((char *)Usart1.RxData, 0, sizeof(Usart1.RxData)); 
-}
-
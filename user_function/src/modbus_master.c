@@ -0,0 +1,206 @@
+/****************************************************************************************
+  * @file      modbus_master.c
+  * @brief     Modbus RTU 主站 (LPUART1, 轮询外部仪表: 功率计/扭矩传感器等)
+  * ****************************************************************************************/
+#include "modbus_master.h"
+#include "modbus_cache.h"
+#include "uart_config.h"
+#include <string.h>
+
+/* 轮询表 (按测试治具实际仪表配置), DestIdx + Count 不得超过 MODBUS_REGISTER_COUNT */
+static const strModBusMasterReq MasterPollTable[] = {
+    // 站号, 功能码,                              起始地址, 数量, 目标下标
+    { 1, MODBUS_FUNC_READ_HOLDING_REGISTERS, 0x0000, 16, MODBUS_MASTER_REG_BASE + 0  },  // 功率计: 电压/电流/功率
+    { 2, MODBUS_FUNC_READ_INPUT_REGISTERS,   0x0000,  4, MODBUS_MASTER_REG_BASE + 16 },  // 扭矩传感器: 扭矩/转速
+};
+#define MASTER_POLL_COUNT   (sizeof(MasterPollTable) / sizeof(MasterPollTable[0]))
+
+/* 双发送缓冲: 当前帧在总线上收发时, 预先组装好下一帧, 应答结束后立即发出 */
+static uint8_t MasterTxFrame[2][8];
+static uint8_t MasterTxActive = 0;          // 当前在途帧所在缓冲
+static uint8_t MasterNextIdx = 0;           // 已预组装帧对应的轮询表索引
+
+/****************************************************************************************
+* 函数名称：ModBus_MasterBuildFrame
+* 函数功能：按轮询表项组装 03/04 读请求帧 (含 CRC)
+* 输入参量：
+* - frame：8 字节帧缓冲
+* - req：轮询表项
+* 输出参量：无
+****************************************************************************************/
+static void ModBus_MasterBuildFrame(uint8_t *frame, const strModBusMasterReq *req)
+{
+    frame[0] = req->SlaveADDR;
+    frame[1] = req->Func;
+    frame[2] = (uint8_t)(req->StartAddr >> 8);
+    frame[3] = (uint8_t)(req->StartAddr & 0xFF);
+    frame[4] = 0;
+    frame[5] = req->Count;
+    uint16_t crc = Modbus_CRC16(frame, 6);
+    frame[6] = (uint8_t)(crc & 0xFF);
+    frame[7] = (uint8_t)(crc >> 8);
+}
+
+/****************************************************************************************
+* 函数名称：ModBus_MasterSend
+* 函数功能：发出当前请求帧, 并在总线发送/等待期间预组装下一帧
+* 输入参量：无
+* 输出参量：无
+****************************************************************************************/
+static void ModBus_MasterSend(void)
+{
+    const strModBusMasterReq *req = &MasterPollTable[ModBus.Master.ReqIdx];
+
+    ModBus.Master.LastReq.SlaveADDR = req->SlaveADDR;
+    ModBus.Master.LastReq.StartAddr = req->StartAddr;
+    ModBus.Master.LastReq.Func = req->Func;
+    ModBus.Master.LastReq.Count = req->Count;
+    ModBus.Master.LastReq.DestIdx = req->DestIdx;
+
+    Lpuart1.FrameFlag = 0;
+    Lpuart1.Tx.Data = MasterTxFrame[MasterTxActive];
+    Lpuart1.Tx.DataSize = 8;
+    Lpuart1TransmitterDMA(&Lpuart1.Tx);
+
+    ModBus.Master.TxTick = HAL_GetTick();
+    ModBus.Master.State = MB_MASTER_WAIT_RESP;
+
+    // 预组装下一帧 (重发时不需要, 但组装代价很小, 统一处理)
+    MasterNextIdx = ModBus.Master.ReqIdx + 1;
+    if (MasterNextIdx >= MASTER_POLL_COUNT) MasterNextIdx = 0;
+    ModBus_MasterBuildFrame(MasterTxFrame[MasterTxActive ^ 1], &MasterPollTable[MasterNextIdx]);
+}
+
+/****************************************************************************************
+* 函数名称：ModBus_MasterAdvance
+* 函数功能：切换到已预组装的下一请求
+* 输入参量：无
+* 输出参量：无
+****************************************************************************************/
+static void ModBus_MasterAdvance(void)
+{
+    ModBus.Master.Retry = 0;
+    ModBus.Master.ReqIdx = MasterNextIdx;
+    MasterTxActive ^= 1;
+    ModBus.Master.State = MB_MASTER_IDLE;
+}
+
+/****************************************************************************************
+* 函数名称：ModBus_MasterRetryOrAdvance
+* 函数功能：超时/校验错误后重发当前请求, 超过重发次数则跳到下一请求
+* 输入参量：无
+* 输出参量：无
+****************************************************************************************/
+static void ModBus_MasterRetryOrAdvance(void)
+{
+    if (ModBus.Master.Retry < MODBUS_MASTER_RETRY) {
+        ModBus.Master.Retry++;
+        ModBus.Master.State = MB_MASTER_IDLE;   // 帧间隔后重发同一缓冲
+    } else {
+        ModBus_MasterAdvance();
+    }
+}
+
+/****************************************************************************************
+* 函数名称：ModBus_MasterCheckResp
+* 函数功能：校验应答帧并将寄存器数据写入 Master.DisplayRegisters
+* 输入参量：无
+* 输出参量：0 = 成功, 1 = CRC/格式错误, 2 = 异常应答
+****************************************************************************************/
+static uint8_t ModBus_MasterCheckResp(void)
+{
+    volatile uint8_t *rx = Lpuart1.RxData;
+    uint16_t len = Lpuart1.DataCnt;
+    uint8_t i;
+
+    if (len < 5 || rx[0] != ModBus.Master.LastReq.SlaveADDR) return 1;
+
+    uint16_t crc_received = ((uint16_t)rx[len - 1] << 8) | rx[len - 2];
+    if (Modbus_CRC16(rx, (uint8_t)(len - 2)) != crc_received) return 1;
+
+    if (rx[1] == (ModBus.Master.LastReq.Func | 0x80)) {
+        ModBus.Master.Exception = rx[2];
+        return 2;
+    }
+
+    uint8_t count = ModBus.Master.LastReq.Count;
+    if (rx[1] != ModBus.Master.LastReq.Func || rx[2] != count * 2 || len != 5 + count * 2) return 1;
+
+    for (i = 0; i < count; i++) {
+        // 仅在数值变化时标记代数, 从站读应答缓存保持有效
+        ModBus_RegWrite(MODBUS_REGION_INPUT, ModBus.Master.LastReq.DestIdx + i, ((uint16_t)rx[3 + i * 2] << 8) | rx[4 + i * 2]);
+    }
+    return 0;
+}
+
+/****************************************************************************************
+* 函数名称：ModBus_MasterInit
+* 函数功能：初始化 LPUART1 总线与主站轮询状态
+* 输入参量：无
+* 输出参量：无
+****************************************************************************************/
+void ModBus_MasterInit(void)
+{
+    lpuart1_config(MODBUS_MASTER_BAUDRATE);
+
+    ModBus.Master.State = MB_MASTER_IDLE;
+    ModBus.Master.ReqIdx = 0;
+    ModBus.Master.Retry = 0;
+    ModBus.Master.RxTick = HAL_GetTick();
+
+    MasterTxActive = 0;
+    ModBus_MasterBuildFrame(MasterTxFrame[0], &MasterPollTable[0]);
+}
+
+/****************************************************************************************
+* 函数名称：ModBus_MasterPoll
+* 函数功能：主站非阻塞状态机 (在主循环中调用)
+* 输入参量：无
+* 输出参量：无
+****************************************************************************************/
+void ModBus_MasterPoll(void)
+{
+    uint32_t now = HAL_GetTick();
+
+    switch (ModBus.Master.State) {
+        case MB_MASTER_IDLE:
+            // 满足帧间静默后立即发出已组装好的帧, 保持总线满载
+            if ((now - ModBus.Master.RxTick) >= MODBUS_MASTER_GAP_MS) {
+                ModBus_MasterSend();
+            }
+            break;
+
+        case MB_MASTER_WAIT_RESP:
+            if (Lpuart1.FrameFlag) {
+                Lpuart1.FrameFlag = 0;
+                ModBus.Master.RxTick = now;
+                switch (ModBus_MasterCheckResp()) {
+                    case 0:
+                        ModBus.Master.OkCount++;
+                        ModBus_MasterAdvance();
+                        break;
+                    case 2:
+                        // 异常应答为确定性结果, 不重发
+                        ModBus.Master.ErrorCount++;
+                        ModBus_MasterAdvance();
+                        break;
+                    default:
+                        ModBus.Master.ErrorCount++;
+                        ModBus_MasterRetryOrAdvance();
+                        break;
+                }
+            }
+            else if ((now - ModBus.Master.TxTick) >= MODBUS_MASTER_TIMEOUT_MS) {
+                // 超时: 终止接收, 重发或跳过
+                Lpuart1ReceiverStop();
+                ModBus.Master.TimeoutCount++;
+                ModBus.Master.RxTick = now;
+                ModBus_MasterRetryOrAdvance();
+            }
+            break;
+
+        default:
+            ModBus.Master.State = MB_MASTER_IDLE;
+            break;
+    }
+}
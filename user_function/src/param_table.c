@@ -0,0 +1,248 @@
+/****************************************************************************************
+  * @file      param_table.c
+  * @brief     PA/dP 参数属性表 (由 PARAM_LIST 编译期生成, 常量表位于 Flash)
+  * ****************************************************************************************/
+#include "param_table.h"
+#include "modbus_master.h"
+#include "Flash_Storage.h"
+#include "relay_control.h"
+#include "sched_function.h"
+#include "perf_function.h"
+
+/* 属性表项编号: 0 为默认属性 */
+#define PARAM_CFG_ENUM(name, grp, idx, sign, fmt, width, min, max, get)  PARAM_CFG_##name,
+enum {
+    PARAM_CFG_DEFAULT = 0,
+    PARAM_LIST(PARAM_CFG_ENUM)
+    PARAM_CFG_COUNT
+};
+
+/* 参数槽位查重: 同一 (组, 编号) 重复声明时枚举名冲突, 编译报错 */
+#define PARAM_SLOT_NAME_(grp, idx)  PARAM_SLOT_##grp##_##idx
+#define PARAM_SLOT_NAME(grp, idx)   PARAM_SLOT_NAME_(grp, idx)
+#define PARAM_SLOT_ENUM(name, grp, idx, sign, fmt, width, min, max, get)  PARAM_SLOT_NAME(grp, idx),
+enum {
+    PARAM_LIST(PARAM_SLOT_ENUM)
+    PARAM_SLOT_COUNT
+};
+
+/* 范围/位宽检查: 16 位数据须能在 4 位数码管上完整显示 */
+#define PARAM_ASSERT(name, grp, idx, sign, fmt, width, min, max, get) \
+    STATIC_ASSERT((idx) < PARAM_SIZE_##grp, name##_index); \
+    STATIC_ASSERT((min) <= (max), name##_range); \
+    STATIC_ASSERT((sign) == SIGNED || (min) >= 0, name##_sign); \
+    STATIC_ASSERT((width) == BIT_32 || (fmt) != FMT_DEC || ((min) >= -9999 && (max) <= 9999), name##_dec16); \
+    STATIC_ASSERT((width) == BIT_32 || (fmt) != FMT_HEX || ((min) >= 0 && (max) <= 0xFFFF), name##_hex16); \
+    STATIC_ASSERT((fmt) != FMT_BIN || ((min) >= 0 && (max) <= 0xF), name##_bin);
+PARAM_LIST(PARAM_ASSERT)
+STATIC_ASSERT(PARAM_CFG_COUNT <= 0xFF, cfg_count);
+STATIC_ASSERT(DP_IDX_RELAY_OPS + RELAY_COUNT <= DP_SIZE, relay_ops);
+
+/****************************************************************************************
+* 函数名称：Param_GetTorque / Param_GetSpeed / ... (dP 诊断量读取函数)
+* 函数功能：按需读取实时数据, 由属性表 "读取函数" 列引用, 主循环与 Modbus 接收中断中调用 (只读 RAM 变量)
+*           扭矩/转速: 主站轮询的扭矩传感器数据, 各占两个连续大端寄存器
+* 输入参量：无
+* 输出参量：当前值
+****************************************************************************************/
+#define PARAM_MASTER_REG32(idx) \
+    (int32_t)(((uint32_t)ModBus.Master.DisplayRegisters[idx] << 16) | ModBus.Master.DisplayRegisters[(idx) + 1])
+
+static int32_t Param_GetTorque(void)      { return PARAM_MASTER_REG32(MODBUS_MASTER_REG_BASE + 16); }
+static int32_t Param_GetSpeed(void)       { return PARAM_MASTER_REG32(MODBUS_MASTER_REG_BASE + 18); }
+static int32_t Param_GetMasterOk(void)    { return (int32_t)ModBus.Master.OkCount; }
+static int32_t Param_GetMasterTmo(void)   { return (int32_t)ModBus.Master.TimeoutCount; }
+static int32_t Param_GetMasterErr(void)   { return (int32_t)ModBus.Master.ErrorCount; }
+static int32_t Param_GetUptime(void)      { return (int32_t)(HAL_GetTick() / 1000); }
+static int32_t Param_GetSlaveFrames(void) { return (int32_t)ModBus.Slave.FrameCount; }
+static int32_t Param_GetSlaveCrcErr(void) { return (int32_t)ModBus.Slave.CrcErrorCount; }
+static int32_t Param_GetFlashErase(void)  { return (int32_t)Flash_GetEraseCount(); }
+static int32_t Param_GetLogErase(void)    { return (int32_t)Flash_GetLogEraseCount(); }
+static int32_t Param_GetScanCyc(void)
+{
+    strPerfStat st;
+
+    if (!Perf_Get(PERF_TIM6, &st) || st.Count == 0) return 0;
+    return (int32_t)(st.TotalCycles / st.Count);
+}
+
+static int32_t Param_GetScanCycMax(void)
+{
+    strPerfStat st;
+
+    return Perf_Get(PERF_TIM6, &st) ? (int32_t)st.MaxCycles : 0;
+}
+static int32_t Param_GetCpuLoad(void)     { return (int32_t)Sched_GetCpuLoad(); }
+static int32_t Param_GetCpuLoad10(void)   { return (int32_t)Sched_GetCpuLoadLong(); }
+static int32_t Param_GetStackUsed(void)   { return (int32_t)Sched_GetStackUsed(); }
+static int32_t Param_GetStackSize(void)   { return (int32_t)Sched_GetStackSize(); }
+
+#define PARAM_RELAY_OPS_GET(n) \
+    static int32_t Param_GetRelayOps##n(void) { return (int32_t)Relay_GetOps(n); }
+PARAM_RELAY_OPS_GET(1)
+PARAM_RELAY_OPS_GET(2)
+PARAM_RELAY_OPS_GET(3)
+PARAM_RELAY_OPS_GET(4)
+PARAM_RELAY_OPS_GET(5)
+PARAM_RELAY_OPS_GET(6)
+PARAM_RELAY_OPS_GET(7)
+PARAM_RELAY_OPS_GET(8)
+
+/* 属性表 */
+#define PARAM_CFG_ENTRY(name, grp, idx, sign, fmt, width, min, max, get)  { (min), (max), (sign), (fmt), (width), (get) },
+static const DTC_ParamConfig_t ParamCfgTable[PARAM_CFG_COUNT] = {
+    { -9999, 9999, SIGNED, FMT_DEC, BIT_16, 0 },    // 默认: 16位有符号十进制
+    PARAM_LIST(PARAM_CFG_ENTRY)
+};
+
+/* 参数 -> 属性表项索引 (PA 在前, dP 在后), 未声明的参数为 0 */
+#define PARAM_KEY(group, index)     ((group) * PA_SIZE + (index))
+#define PARAM_MAP_ENTRY(name, grp, idx, sign, fmt, width, min, max, get)  [PARAM_KEY(PARAM_GROUP_##grp, idx)] = PARAM_CFG_##name,
+static const uint8_t ParamCfgMap[PA_SIZE + DP_SIZE] = {
+    PARAM_LIST(PARAM_MAP_ENTRY)
+};
+
+/****************************************************************************************
+* 函数名称：Param_GetConfig
+* 函数功能：查询参数属性 (常数时间, 返回常量表引用, 可在中断中调用)
+* 输入参量：group - 参数组 (0:PA, 1:dP), index - 参数编号
+* 输出参量：属性表项指针 (越界返回默认属性)
+****************************************************************************************/
+const DTC_ParamConfig_t *Param_GetConfig(uint8_t group, uint16_t index)
+{
+    if (index >= ((group == PARAM_GROUP_PA) ? PA_SIZE : DP_SIZE)) return &ParamCfgTable[PARAM_CFG_DEFAULT];
+    return &ParamCfgTable[ParamCfgMap[PARAM_KEY(group, index)]];
+}
+
+/****************************************************************************************
+* 函数名称：Param_GetValue
+* 函数功能：读取参数当前值: 属性表声明了读取函数时实时读取, 否则读参数数组
+* 输入参量：group - 参数组 (0:PA, 1:dP), index - 参数编号
+* 输出参量：参数值 (越界返回 0)
+****************************************************************************************/
+int32_t Param_GetValue(uint8_t group, uint16_t index)
+{
+    const DTC_ParamConfig_t *cfg;
+
+    if (index >= ((group == PARAM_GROUP_PA) ? PA_SIZE : DP_SIZE)) return 0;
+    cfg = Param_GetConfig(group, index);
+    if (cfg->Get != 0) return cfg->Get();
+    return (group == PARAM_GROUP_PA) ? PA_Buffer[index] : DP_Buffer[index];
+}
+
+/****************************************************************************************
+* 函数名称：Param_Check
+* 函数功能：检查参数值是否在属性表范围内
+* 输入参量：group - 参数组, index - 参数编号, value - 参数值
+* 输出参量：0 = 合法, 1 = 越界
+****************************************************************************************/
+uint8_t Param_Check(uint8_t group, uint16_t index, int32_t value)
+{
+    const DTC_ParamConfig_t *cfg = Param_GetConfig(group, index);
+    return (value < cfg->Min || value > cfg->Max);
+}
+
+/****************************************************************************************
+* 函数名称：Param_Sanitize
+* 函数功能：按属性表范围修正参数 (属性表变更后加载旧参数时调用), 越界值钳位到边界
+* 输入参量：buffer - 参数数组, group - 参数组, count - 参数个数
+* 输出参量：被修正的参数个数
+****************************************************************************************/
+uint8_t Param_Sanitize(int32_t *buffer, uint8_t group, uint16_t count)
+{
+    uint8_t fixed = 0;
+    uint16_t i;
+
+    for (i = 0; i < count; i++) {
+        const DTC_ParamConfig_t *cfg = Param_GetConfig(group, i);
+        if (buffer[i] < cfg->Min) { buffer[i] = cfg->Min; fixed++; }
+        else if (buffer[i] > cfg->Max) { buffer[i] = cfg->Max; fixed++; }
+    }
+    return fixed;
+}
+
+#define PARAM_FNV(x)  do { h ^= (uint32_t)(x); h *= 16777619U; } while (0)
+
+/****************************************************************************************
+* 函数名称：Param_SchemaId
+* 函数功能：参数结构版本号: 对参数容量与属性表做 FNV-1a 散列, 随参数保存到 Flash
+* 输入参量：无
+* 输出参量：32 位版本号
+****************************************************************************************/
+uint32_t Param_SchemaId(void)
+{
+    static uint32_t schema = 0;
+    uint32_t h = 2166136261U;
+    uint16_t i;
+
+    if (schema != 0) return schema;
+
+    PARAM_FNV(PA_SIZE);
+    PARAM_FNV(DP_SIZE);
+    for (i = 0; i < PA_SIZE + DP_SIZE; i++) {
+        const DTC_ParamConfig_t *cfg = &ParamCfgTable[ParamCfgMap[i]];
+        PARAM_FNV(cfg->Min);
+        PARAM_FNV(cfg->Max);
+        PARAM_FNV(cfg->Sign | (cfg->Format << 8) | (cfg->Width << 16));
+    }
+
+    schema = (h != 0) ? h : 1;
+    return schema;
+}
+
+/****************************************************************************************
+* 函数名称：Param_ModbusRead
+* 函数功能：Modbus 03 读 PA 参数窗口或 dP 诊断量窗口, 按大端写入应答数据区
+* 输入参量：addr - 起始寄存器地址, count - 寄存器数量, dst - 应答数据区
+* 输出参量：0 = 成功, 其余为 Modbus 异常码
+****************************************************************************************/
+uint8_t Param_ModbusRead(uint16_t addr, uint16_t count, volatile uint8_t *dst)
+{
+    uint16_t i, base;
+    uint8_t group;
+
+    if (addr >= PARAM_MODBUS_BASE && addr + count <= PARAM_MODBUS_END) {
+        base = PARAM_MODBUS_BASE;
+        group = PARAM_GROUP_PA;
+    } else if (addr >= PARAM_MODBUS_DP_BASE && addr + count <= PARAM_MODBUS_DP_END) {
+        base = PARAM_MODBUS_DP_BASE;
+        group = PARAM_GROUP_DP;
+    } else {
+        return 0x02;
+    }
+
+    for (i = 0; i < count; i++) {
+        uint16_t reg = addr - base + i;
+        uint32_t val = (uint32_t)Param_GetValue(group, reg >> 1);
+        uint16_t word = (reg & 1) ? (uint16_t)(val & 0xFFFF) : (uint16_t)(val >> 16);
+        dst[i * 2] = (uint8_t)(word >> 8);
+        dst[i * 2 + 1] = (uint8_t)(word & 0xFF);
+    }
+    return 0;
+}
+
+/****************************************************************************************
+* 函数名称：Param_ModbusWrite
+* 函数功能：Modbus 10 写 PA 参数窗口 (仅写 RAM, 需 "Save" 保存)
+*           须按 高/低 成对整参数写入, 全部通过属性表范围检查后才生效
+* 输入参量：addr - 起始寄存器地址, count - 寄存器数量, src - 寄存器数据
+* 输出参量：0 = 成功, 其余为 Modbus 异常码
+****************************************************************************************/
+uint8_t Param_ModbusWrite(uint16_t addr, uint16_t count, const volatile uint16_t *src)
+{
+    uint16_t first, n, i;
+
+    if (addr < PARAM_MODBUS_BASE || addr + count > PARAM_MODBUS_END) return 0x02;
+    if (((addr - PARAM_MODBUS_BASE) & 1) || (count & 1)) return 0x02;
+
+    first = (addr - PARAM_MODBUS_BASE) >> 1;
+    n = count >> 1;
+    for (i = 0; i < n; i++) {
+        int32_t val = (int32_t)(((uint32_t)src[i * 2] << 16) | src[i * 2 + 1]);
+        if (Param_Check(PARAM_GROUP_PA, first + i, val)) return 0x03;
+    }
+    for (i = 0; i < n; i++) {
+        PA_Buffer[first + i] = (int32_t)(((uint32_t)src[i * 2] << 16) | src[i * 2 + 1]);
+    }
+    return 0;
+}
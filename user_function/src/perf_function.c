@@ -0,0 +1,165 @@
+/****************************************************************************************
+  * @file      perf_function.c
+  * @brief     代码段耗时统计 (DWT 周期计数), 文本命令与 Modbus 读出
+  * ****************************************************************************************/
+#include "perf_function.h"
+#include "nvic_config.h"
+
+static const char *const PerfNames[PERF_COUNT] = {
+#define PERF_NAME(id, name)     name,
+    PERF_SECTION_LIST(PERF_NAME)
+#undef PERF_NAME
+};
+
+#if PERF_ENABLE
+static strPerfStat PerfStat[PERF_COUNT];
+static uint32_t PerfOverhead = 0;           // 空代码段测得的周期数
+#endif
+
+/****************************************************************************************
+* 函数名称：Perf_Init
+* 函数功能：测量 PERF_BEGIN/PERF_END 本身的开销 (上电调用一次, DWT 周期计数由 Time_Init 开启)
+* 输入参量：无
+* 输出参量：无
+****************************************************************************************/
+void Perf_Init(void)
+{
+#if PERF_ENABLE
+    uint32_t t0, t1;
+
+    t0 = DWT->CYCCNT;
+    t1 = DWT->CYCCNT;
+    PerfOverhead = t1 - t0;
+#endif
+}
+
+/****************************************************************************************
+* 函数名称：Perf_Record
+* 函数功能：记录一次代码段耗时 (由 PERF_END 调用)
+* 输入参量：id - 代码段编号, cycles - 测得的周期数 (含测量开销)
+* 输出参量：无
+****************************************************************************************/
+void Perf_Record(PerfId id, uint32_t cycles)
+{
+#if PERF_ENABLE
+    strPerfStat *st = &PerfStat[id];
+
+    cycles = (cycles > PerfOverhead) ? cycles - PerfOverhead : 0;
+    if (st->Count == 0 || cycles < st->MinCycles) st->MinCycles = cycles;
+    if (cycles > st->MaxCycles) st->MaxCycles = cycles;
+    st->TotalCycles += cycles;
+    st->Count++;
+#else
+    (void)id;
+    (void)cycles;
+#endif
+}
+
+/****************************************************************************************
+* 函数名称：Perf_Reset
+* 函数功能：清零全部统计 (逐段短暂屏蔽中断, 避免与记录交错)
+* 输入参量：无
+* 输出参量：无
+****************************************************************************************/
+void Perf_Reset(void)
+{
+#if PERF_ENABLE
+    uint32_t lock;
+    uint8_t i;
+
+    for (i = 0; i < PERF_COUNT; i++) {
+        lock = Irq_Lock(IRQ_PRIO_ENCODER);
+        PerfStat[i].Count = 0;
+        PerfStat[i].MinCycles = 0;
+        PerfStat[i].MaxCycles = 0;
+        PerfStat[i].TotalCycles = 0;
+        Irq_Unlock(lock);
+    }
+#endif
+}
+
+/****************************************************************************************
+* 函数名称：Perf_Get / Perf_GetName
+* 函数功能：读取一个代码段的统计快照 / 代码段名称
+* 输入参量：id - 代码段编号, stat - 快照输出
+* 输出参量：Perf_Get: 1 = 成功, 0 = 编号越界或统计已在编译时去除; Perf_GetName: 越界返回 0
+****************************************************************************************/
+uint8_t Perf_Get(PerfId id, strPerfStat *stat)
+{
+#if PERF_ENABLE
+    uint32_t lock;
+
+    if (id >= PERF_COUNT) return 0;
+    lock = Irq_Lock(IRQ_PRIO_ENCODER);
+    *stat = PerfStat[id];
+    Irq_Unlock(lock);
+    return 1;
+#else
+    (void)id;
+    (void)stat;
+    return 0;
+#endif
+}
+
+const char *Perf_GetName(PerfId id)
+{
+    return (id < PERF_COUNT) ? PerfNames[id] : 0;
+}
+
+/****************************************************************************************
+* 函数名称：Perf_ModbusRead
+* 函数功能：Modbus 读统计寄存器, 按大端写入应答数据区
+* 输入参量：addr - 起始寄存器地址, count - 寄存器数量, dst - 应答数据区
+* 输出参量：0 = 成功, 其余为 Modbus 异常码
+****************************************************************************************/
+uint8_t Perf_ModbusRead(uint16_t addr, uint16_t count, volatile uint8_t *dst)
+{
+#if PERF_ENABLE
+    strPerfStat st;
+    int16_t last = -1;          // 已取快照的代码段, 同一段的各寄存器来自同一快照
+    uint16_t i, word;
+
+    if (addr < PERF_MODBUS_BASE || addr + count > PERF_MODBUS_END) return 0x02;
+    if (count == 0 || count > 120) return 0x03;     // 应答须在 USART1 发送缓冲区内
+
+    for (i = 0; i < count; i++) {
+        uint16_t reg = addr - PERF_MODBUS_BASE + i;
+
+        switch (reg) {
+            case PERF_REG_COUNT:    word = PERF_COUNT; break;
+            case PERF_REG_CLOCK:    word = (uint16_t)(SystemCoreClock / 1000000); break;
+            case PERF_REG_OVERHEAD: word = (uint16_t)PerfOverhead; break;
+            default:
+                if (reg >= PERF_REG_TABLE) {
+                    uint16_t id = (reg - PERF_REG_TABLE) / PERF_REG_STRIDE;
+                    uint16_t off = (reg - PERF_REG_TABLE) % PERF_REG_STRIDE;
+
+                    if (id != last) {
+                        Perf_Get((PerfId)id, &st);
+                        last = id;
+                    }
+                    switch (off) {
+                        case 0:  word = (uint16_t)(st.Count >> 16); break;
+                        case 1:  word = (uint16_t)st.Count; break;
+                        case 2:  word = (uint16_t)(st.MinCycles >> 16); break;
+                        case 3:  word = (uint16_t)st.MinCycles; break;
+                        case 4:  word = (uint16_t)(st.MaxCycles >> 16); break;
+                        case 5:  word = (uint16_t)st.MaxCycles; break;
+                        default: word = (uint16_t)(st.TotalCycles >> ((9 - off) * 16)); break;
+                    }
+                } else {
+                    word = 0;
+                }
+                break;
+        }
+        dst[i * 2] = (uint8_t)(word >> 8);
+        dst[i * 2 + 1] = (uint8_t)(word & 0xFF);
+    }
+    return 0;
+#else
+    (void)addr;
+    (void)count;
+    (void)dst;
+    return 0x02;
+#endif
+}
@@ -3,26 +3,75 @@
   * @brief     继电器控制模块 (PA0-PA7, 高电平导通)
   ****************************************************************************************/
 #include "relay_control.h"
+#include "relay_sequence.h"
+#include "Flash_Storage.h"
+#include "param_table.h"
+#include "nvic_config.h"
+#include "trace_function.h"
 
-/* 继电器引脚和端口数组，便于索引访问 */
-static const uint16_t RelayPins[RELAY_COUNT] = {
-    MCU_RLY_K1_Pin, MCU_RLY_K2_Pin, MCU_RLY_K3_Pin, MCU_RLY_K4_Pin,
-    MCU_RLY_K5_Pin, MCU_RLY_K6_Pin, MCU_RLY_K7_Pin, MCU_RLY_K8_Pin
-};
+#define RELAY_TIM_HZ        10000           // TIM17 计数频率 (0.1ms 分辨率)
 
-static GPIO_TypeDef* const RelayPorts[RELAY_COUNT] = {
-    MCU_RLY_K1_GPIO_Port, MCU_RLY_K2_GPIO_Port, MCU_RLY_K3_GPIO_Port, MCU_RLY_K4_GPIO_Port,
-    MCU_RLY_K5_GPIO_Port, MCU_RLY_K6_GPIO_Port, MCU_RLY_K7_GPIO_Port, MCU_RLY_K8_GPIO_Port
+/*
+  互锁组 (每项为 K1-K8 位掩码, 组内同一时刻最多一个导通)
+  按 Get_Relay_Status_By_StationID 的工位划分: 每个工位 3 个继电器 (3 号工位第 3 个在 PB0, 不经本模块)
+*/
+static const uint8_t RelayInterlock[] = {
+    0x07,                                   // 工位 1: K1-K3
+    0x38,                                   // 工位 2: K4-K6
+    0xC0,                                   // 工位 3: K7-K8
 };
+#define RELAY_INTERLOCK_COUNT   (sizeof(RelayInterlock) / sizeof(RelayInterlock[0]))
+
+/* 组操作要求 K1-K8 依次对应 RELAY_PORT 的 bit0-bit7 */
+STATIC_ASSERT(MCU_RLY_K1_Pin == GPIO_PIN_0 && MCU_RLY_K2_Pin == GPIO_PIN_1 &&
+              MCU_RLY_K3_Pin == GPIO_PIN_2 && MCU_RLY_K4_Pin == GPIO_PIN_3 &&
+              MCU_RLY_K5_Pin == GPIO_PIN_4 && MCU_RLY_K6_Pin == GPIO_PIN_5 &&
+              MCU_RLY_K7_Pin == GPIO_PIN_6 && MCU_RLY_K8_Pin == GPIO_PIN_7, relay_pins);
+
+/* 动作计数 (K1-K8) */
+static uint32_t RelayOps[RELAY_COUNT];
+static uint8_t  RelayOpsLast = 0;               // 上次计数时的继电器状态 (上电全部断开)
+static uint32_t RelayOpsUnsaved = 0;            // 未保存的动作次数
+static uint32_t RelayOpsSaveTick = 0;           // 上次保存时刻 (ms)
+
+/* 先断后合: 死区时间结束后待闭合的继电器 (主循环与中断访问, 均在关中断时修改) */
+static volatile uint8_t RelayPending = 0;
+
+/**************************************************************************************
+* 函数名称：Relay_Write
+* 函数功能：写 BSRR 并按实际翻转计数 (关中断保证主循环与中断中的写入计数不丢失)
+* 输入参量：bsrr - BSRR 字 (见 RELAY_BSRR)
+* 输出参量：无
+***************************************************************************************/
+static void Relay_Write(uint32_t bsrr)
+{
+    uint32_t lock = Irq_Lock(IRQ_PRIO_RELAY);
+
+    RELAY_PORT->BSRR = bsrr;
+    Relay_CountOps(Relay_GetMask());
+    TRACE(RELAY_WRITE, Relay_GetMask());
+    Irq_Unlock(lock);
+}
 
 /**************************************************************************************
 * 函数名称：Relay_Init
-* 函数功能：初始化继电器GPIO（默认全部关闭）
+* 函数功能：初始化继电器GPIO（默认全部关闭）, 配置 TIM17 为先断后合死区单次定时器
 * 输入参量：无
 * 输出参量：无
 ***************************************************************************************/
 void Relay_Init(void)
 {
+    uint32_t clk = Tim_GetClock(TIM17);
+
+    __HAL_RCC_TIM17_CLK_ENABLE();
+    TIM17->CR1 = TIM_CR1_OPM | TIM_CR1_URS;
+    TIM17->PSC = clk / RELAY_TIM_HZ - 1;
+    TIM17->EGR = TIM_EGR_UG;                // 装载预分频 (URS = 1, 不产生中断)
+    TIM17->SR = 0;
+    TIM17->DIER = TIM_DIER_UIE;
+
+    HAL_NVIC_EnableIRQ(TIM1_TRG_COM_TIM17_IRQn);
+
     /* GPIO 时钟已由 CubeMX 初始化 */
     /* 初始状态全部关闭 */
     Relay_AllOff();
@@ -32,14 +81,15 @@ void Relay_Init(void)
 * 函数名称：Relay_On
 * 函数功能：打开单个继电器
 * 输入参量：relayNum - 继电器编号 (1-8)
-* 输出参量：无
+* 输出参量：RELAY_OK / RELAY_ERR_xxx (见 Relay_Apply)
 ***************************************************************************************/
-void Relay_On(uint8_t relayNum)
+uint8_t Relay_On(uint8_t relayNum)
 {
     if(relayNum >= 1 && relayNum <= RELAY_COUNT)
     {
-        HAL_GPIO_WritePin(RelayPorts[relayNum - 1], RelayPins[relayNum - 1], GPIO_PIN_SET);
+        return Relay_Apply((uint8_t)(1U << (relayNum - 1)), 0);
     }
+    return RELAY_OK;
 }
 
 /**************************************************************************************
@@ -52,7 +102,7 @@ void Relay_Off(uint8_t relayNum)
 {
     if(relayNum >= 1 && relayNum <= RELAY_COUNT)
     {
-        HAL_GPIO_WritePin(RelayPorts[relayNum - 1], RelayPins[relayNum - 1], GPIO_PIN_RESET);
+        Relay_Apply(0, (uint8_t)(1U << (relayNum - 1)));
     }
 }
 
@@ -60,28 +110,27 @@ void Relay_Off(uint8_t relayNum)
 * 函数名称：Relay_Toggle
 * 函数功能：切换单个继电器状态
 * 输入参量：relayNum - 继电器编号 (1-8)
-* 输出参量：无
+* 输出参量：RELAY_OK / RELAY_ERR_xxx (见 Relay_Apply)
 ***************************************************************************************/
-void Relay_Toggle(uint8_t relayNum)
+uint8_t Relay_Toggle(uint8_t relayNum)
 {
     if(relayNum >= 1 && relayNum <= RELAY_COUNT)
     {
-        HAL_GPIO_TogglePin(RelayPorts[relayNum - 1], RelayPins[relayNum - 1]);
+        uint8_t bit = (uint8_t)(1U << (relayNum - 1));
+        return (Relay_GetMask() & bit) ? Relay_Apply(0, bit) : Relay_Apply(bit, 0);
     }
+    return RELAY_OK;
 }
 
 /**************************************************************************************
 * 函数名称：Relay_AllOn
-* 函数功能：打开全部继电器
+* 函数功能：打开全部继电器 (存在互锁组时被拒绝)
 * 输入参量：无
-* 输出参量：无
+* 输出参量：RELAY_OK / RELAY_ERR_xxx (见 Relay_Apply)
 ***************************************************************************************/
-void Relay_AllOn(void)
+uint8_t Relay_AllOn(void)
 {
-    for(uint8_t i = 1; i <= RELAY_COUNT; i++)
-    {
-        Relay_On(i);
-    }
+    return Relay_Apply(RELAY_MASK_ALL, 0);
 }
 
 /**************************************************************************************
@@ -92,10 +141,7 @@ void Relay_AllOn(void)
 ***************************************************************************************/
 void Relay_AllOff(void)
 {
-    for(uint8_t i = 1; i <= RELAY_COUNT; i++)
-    {
-        Relay_Off(i);
-    }
+    Relay_Apply(0, RELAY_MASK_ALL);
 }
 
 /**************************************************************************************
@@ -108,7 +154,7 @@ uint8_t Relay_GetStatus(uint8_t relayNum)
 {
     if(relayNum >= 1 && relayNum <= RELAY_COUNT)
     {
-        return (HAL_GPIO_ReadPin(RelayPorts[relayNum - 1], RelayPins[relayNum - 1]) == GPIO_PIN_SET) ? 1 : 0;
+        return (Relay_GetMask() >> (relayNum - 1)) & 1U;
     }
     return 0;
 }
@@ -118,18 +164,226 @@ uint8_t Relay_GetStatus(uint8_t relayNum)
 * 函数功能：根据位掩码设置多个继电器
 * 输入参量：mask - 位掩码 (bit0=K1, bit7=K8)
 *           state - 1 = 导通, 0 = 断开
+* 输出参量：RELAY_OK / RELAY_ERR_xxx (见 Relay_Apply)
+***************************************************************************************/
+uint8_t Relay_SetMultiple(uint8_t mask, uint8_t state)
+{
+    if(state)
+        return Relay_Apply(mask, 0);
+    else
+        return Relay_Apply(0, mask);
+}
+
+/**************************************************************************************
+* 函数名称：Relay_Apply
+* 函数功能：一次写 BSRR 同时置位/清零多个继电器 (未选中的继电器保持不变)
+*           按互锁组检查: 组内已有其他成员导通时本次只断开, 死区时间后由 TIM17 中断闭合
+*           时序引擎播放期间 DMA 直接写 BSRR, 互锁校验基于启动时状态, 此时拒绝一切请求
+*           请求被拒绝时不改变任何继电器
+* 输入参量：set - 导通掩码 (bit0=K1, bit7=K8)
+*           clr - 断开掩码 (与 set 重叠的位按导通处理)
+* 输出参量：RELAY_OK / RELAY_ERR_INTERLOCK / RELAY_ERR_BUSY
+***************************************************************************************/
+uint8_t Relay_Apply(uint8_t set, uint8_t clr)
+{
+    uint32_t lock;
+    uint8_t cur, pending, brk = 0, make = 0;
+    uint8_t i;
+
+    clr &= (uint8_t)~set;
+
+    lock = Irq_Lock(IRQ_PRIO_RELAY);
+    if (RelaySeq_IsRunning()) {
+        Irq_Unlock(lock);
+        return RELAY_ERR_BUSY;
+    }
+    cur = Relay_GetMask();
+    pending = RelayPending & (uint8_t)~clr;     // 断开请求取消尚未闭合的继电器
+    for (i = 0; i < RELAY_INTERLOCK_COUNT; i++) {
+        uint8_t grp = RelayInterlock[i];
+        uint8_t on = set & grp;
+        uint8_t other;
+
+        if (on == 0) continue;
+        if (on & (on - 1)) {
+            Irq_Unlock(lock);
+            return RELAY_ERR_INTERLOCK;
+        }
+        if (pending & grp) {
+            Irq_Unlock(lock);
+            return RELAY_ERR_BUSY;
+        }
+        other = cur & grp & (uint8_t)~on;
+        if (other) {
+            brk |= other;
+            make |= on;
+        }
+    }
+
+    RelayPending = pending | make;
+    Relay_Write(RELAY_BSRR(set & (uint8_t)~make, clr | brk));
+    if (make) {
+        uint32_t ms = (uint32_t)PA_Buffer[PA_IDX_RELAY_DEADTIME];
+        if (ms == 0 || ms > RELAY_DEADTIME_MAX_MS) ms = RELAY_DEADTIME_DEFAULT_MS;
+        TIM17->CR1 &= ~TIM_CR1_CEN;
+        TIM17->CNT = 0;
+        TIM17->ARR = ms * (RELAY_TIM_HZ / 1000) - 1;
+        TIM17->SR = 0;
+        TIM17->CR1 |= TIM_CR1_CEN;
+    }
+    Irq_Unlock(lock);
+    return RELAY_OK;
+}
+
+/**************************************************************************************
+* 函数名称：Relay_SetMask
+* 函数功能：一次写 BSRR 设置全部继电器状态
+* 输入参量：mask - 继电器状态 (bit0=K1, bit7=K8, 1 = 导通)
+* 输出参量：RELAY_OK / RELAY_ERR_xxx (见 Relay_Apply)
+***************************************************************************************/
+uint8_t Relay_SetMask(uint8_t mask)
+{
+    return Relay_Apply(mask, (uint8_t)~mask);
+}
+
+/**************************************************************************************
+* 函数名称：Relay_GetMask
+* 函数功能：读取全部继电器状态 (一次读 ODR)
+* 输入参量：无
+* 输出参量：继电器状态 (bit0=K1, bit7=K8, 1 = 导通)
+***************************************************************************************/
+uint8_t Relay_GetMask(void)
+{
+    return (uint8_t)(RELAY_PORT->ODR & RELAY_MASK_ALL);
+}
+
+/**************************************************************************************
+* 函数名称：Relay_CheckInterlock
+* 函数功能：检查继电器状态是否满足全部互锁组 (供绕过 Relay_Apply 的时序引擎预先校验)
+* 输入参量：mask - 继电器状态 (bit0=K1, bit7=K8)
+* 输出参量：RELAY_OK / RELAY_ERR_INTERLOCK
+***************************************************************************************/
+uint8_t Relay_CheckInterlock(uint8_t mask)
+{
+    uint8_t i;
+
+    for (i = 0; i < RELAY_INTERLOCK_COUNT; i++) {
+        uint8_t on = mask & RelayInterlock[i];
+        if (on & (on - 1)) return RELAY_ERR_INTERLOCK;
+    }
+    return RELAY_OK;
+}
+
+/**************************************************************************************
+* 函数名称：Relay_GetPending
+* 函数功能：读取死区时间结束后待闭合的继电器
+* 输入参量：无
+* 输出参量：继电器掩码 (0 = 无先断后合进行中)
+***************************************************************************************/
+uint8_t Relay_GetPending(void)
+{
+    return RelayPending;
+}
+
+/**************************************************************************************
+* 函数名称：Relay_DeadTimeHandler
+* 函数功能：死区时间到, 闭合待闭合的继电器 (在 TIM17 中断中调用)
+* 输入参量：无
+* 输出参量：无
+***************************************************************************************/
+void Relay_DeadTimeHandler(void)
+{
+    uint8_t make = RelayPending;
+
+    RelayPending = 0;
+    TRACE(RELAY_MAKE, make);
+    if (make) Relay_Write(RELAY_BSRR(make, 0));
+}
+
+/**************************************************************************************
+* 函数名称：Relay_CountOps
+* 函数功能：与上次状态比较, 翻转的继电器各计 1 次 (在中断中或关中断时调用;
+*           DMA 直接写 BSRR 的时序引擎按步骤重放状态调用)
+* 输入参量：mask - 当前继电器状态 (bit0=K1, bit7=K8)
 * 输出参量：无
 ***************************************************************************************/
-void Relay_SetMultiple(uint8_t mask, uint8_t state)
+void Relay_CountOps(uint8_t mask)
+{
+    uint8_t diff = mask ^ RelayOpsLast;
+
+    RelayOpsLast = mask;
+    while (diff) {
+        RelayOps[__CLZ(__RBIT(diff))]++;
+        RelayOpsUnsaved++;
+        diff &= (uint8_t)(diff - 1);
+    }
+}
+
+/**************************************************************************************
+* 函数名称：Relay_GetOps
+* 函数功能：读取继电器累计动作次数
+* 输入参量：relayNum - 继电器编号 (1-8)
+* 输出参量：动作次数 (编号越界返回 0)
+***************************************************************************************/
+uint32_t Relay_GetOps(uint8_t relayNum)
 {
-    for(uint8_t i = 0; i < RELAY_COUNT; i++)
+    if(relayNum >= 1 && relayNum <= RELAY_COUNT)
     {
-        if(mask & (1 << i))
-        {
-            if(state)
-                Relay_On(i + 1);
-            else
-                Relay_Off(i + 1);
-        }
+        return RelayOps[relayNum - 1];
+    }
+    return 0;
+}
+
+/**************************************************************************************
+* 函数名称：Relay_ResetOps
+* 函数功能：更换继电器后清零其动作计数并立即保存 (写 Flash, 只在主循环中调用)
+* 输入参量：relayNum - 继电器编号 (1-8)
+* 输出参量：无
+***************************************************************************************/
+void Relay_ResetOps(uint8_t relayNum)
+{
+    if(relayNum >= 1 && relayNum <= RELAY_COUNT)
+    {
+        uint32_t lock = Irq_Lock(IRQ_PRIO_RELAY);
+
+        RelayOps[relayNum - 1] = 0;
+        RelayOpsUnsaved = RELAY_OPS_SAVE_COUNT;
+        Irq_Unlock(lock);
+        Relay_OpsPoll();
     }
 }
+
+/**************************************************************************************
+* 函数名称：Relay_OpsInit
+* 函数功能：从 Flash 记录流加载动作计数 (上电调用一次, 无记录时从 0 开始)
+* 输入参量：无
+* 输出参量：无
+***************************************************************************************/
+void Relay_OpsInit(void)
+{
+    Flash_LoadLog(RelayOps, RELAY_COUNT);
+    RelayOpsSaveTick = HAL_GetTick();
+}
+
+/**************************************************************************************
+* 函数名称：Relay_OpsPoll
+* 函数功能：主循环中调用, 有未保存计数且达到保存间隔或次数阈值时追加一条记录
+* 输入参量：无
+* 输出参量：无
+***************************************************************************************/
+void Relay_OpsPoll(void)
+{
+    uint32_t snapshot[RELAY_COUNT], lock;
+    uint8_t i;
+
+    if (RelayOpsUnsaved == 0) return;
+    if (RelayOpsUnsaved < RELAY_OPS_SAVE_COUNT && HAL_GetTick() - RelayOpsSaveTick < RELAY_OPS_SAVE_MS) return;
+
+    lock = Irq_Lock(IRQ_PRIO_RELAY);
+    for (i = 0; i < RELAY_COUNT; i++) snapshot[i] = RelayOps[i];
+    RelayOpsUnsaved = 0;
+    Irq_Unlock(lock);
+
+    Flash_AppendLog(snapshot, RELAY_COUNT);
+    RelayOpsSaveTick = HAL_GetTick();
+}
@@ -0,0 +1,374 @@
+/****************************************************************************************
+  * @file      relay_sequence.c
+  * @brief     继电器时序引擎 (TIM1 + DMA 写 GPIOA->BSRR, 播放期间无 CPU 参与)
+  * ****************************************************************************************/
+#include "relay_sequence.h"
+#include "relay_control.h"
+#include "nvic_config.h"
+#include "delay_function.h"
+#include "trace_function.h"
+
+#define RSEQ_TICK_HZ        1000000U        // TIM1 计数频率 (1us 分辨率)
+#define RSEQ_MAX_PERIOD     65536U          // TIM1 16 位计数器单周期最大计数
+
+/* DMA 通道: DMA1_Channel6 (TIM1_UP -> GPIOA->BSRR), DMA1_Channel7 (TIM1_CH1 -> TIM1->ARR) */
+#define RSEQ_DMA_BSRR       DMA1_Channel6
+#define RSEQ_DMA_ARR        DMA1_Channel7
+#define RSEQ_MUX_BSRR       DMAMUX1_Channel5
+#define RSEQ_MUX_ARR        DMAMUX1_Channel6
+
+/* 时序表 (Modbus 写入) */
+static strRelaySeqEntry RseqTable[RSEQ_MAX_ENTRIES];
+static uint8_t          RseqCount = 0;
+
+/* 编译结果: 第 k 步在第 k 个周期结束时写入 RseqBsrr[k], 第 k 个周期内装载下一周期 RseqArr[k] */
+static uint32_t RseqBsrr[RSEQ_MAX_STEPS];
+static uint32_t RseqArr[RSEQ_MAX_STEPS];
+static uint8_t  RseqDone[RSEQ_MAX_STEPS];   // 执行完第 k 步后已完成的条目数
+static uint32_t RseqFirstArr;               // 第 0 个周期的 ARR
+static uint8_t  RseqSteps = 0;
+
+/* 运行状态 (主循环/Modbus 接收中断/DMA 中断访问, 同优先级中断不互相抢占) */
+static volatile uint8_t  RseqState = RSEQ_STATE_IDLE;
+static volatile uint8_t  RseqError = RSEQ_ERR_NONE;
+static volatile uint32_t RseqElapsed = 0;   // us
+static uint32_t RseqStartTick = 0;          // ms
+static uint64_t RseqStartTime = 0;          // 64 位时基 (播放期间可能 WFI 休眠, 不能用 DWT 周期计数)
+static uint8_t  RseqStartMask = 0;          // 启动时继电器状态 (结束时按已执行步骤重放动作计数)
+
+/****************************************************************************************
+* 函数名称：RelaySeq_Init
+* 函数功能：配置 TIM1 为 1MHz 计数 (ARR 预装载, CC1 = 1) 及 DMAMUX 请求, 使能 DMA 完成中断
+*           (TIM1 由 MX_TIM1_Init 初始化后未使用, 此处接管)
+* 输入参量：无
+* 输出参量：无
+****************************************************************************************/
+void RelaySeq_Init(void)
+{
+    uint32_t clk = Tim_GetClock(TIM1);
+
+    __HAL_RCC_TIM1_CLK_ENABLE();
+    TIM1->CR1 = TIM_CR1_ARPE | TIM_CR1_URS;     // URS: UG 不产生 DMA 请求
+    TIM1->DIER = 0;
+    TIM1->PSC = clk / RSEQ_TICK_HZ - 1;
+    TIM1->CCMR1 = 0;                            // CC1 输出比较 (冻结), 仅用于产生 DMA 请求
+    TIM1->CCR1 = 1;
+    TIM1->EGR = TIM_EGR_UG;
+    TIM1->SR = 0;
+
+    __HAL_RCC_DMAMUX1_CLK_ENABLE();
+    __HAL_RCC_DMA1_CLK_ENABLE();
+    RSEQ_MUX_BSRR->CCR = DMA_REQUEST_TIM1_UP;
+    RSEQ_MUX_ARR->CCR = DMA_REQUEST_TIM1_CH1;
+
+    HAL_NVIC_EnableIRQ(DMA1_Channel6_IRQn);
+}
+
+/****************************************************************************************
+* 函数名称：RelaySeq_Emit
+* 函数功能：编译时追加一步
+* 输入参量：period - 本步距上一步的时间 (us, 2 ~ RSEQ_MAX_PERIOD), bsrr - BSRR 字, done - 本步后已完成条目数
+* 输出参量：RSEQ_ERR_xxx
+****************************************************************************************/
+static uint8_t RelaySeq_Emit(uint32_t period, uint32_t bsrr, uint8_t done)
+{
+    if (RseqSteps >= RSEQ_MAX_STEPS) return RSEQ_ERR_LONG;
+
+    // 第 k 步的周期由第 k-1 个周期内的 CC1 DMA 装载
+    if (RseqSteps == 0) RseqFirstArr = period - 1;
+    else RseqArr[RseqSteps - 1] = period - 1;
+
+    RseqBsrr[RseqSteps] = bsrr;
+    RseqDone[RseqSteps] = done;
+    RseqArr[RseqSteps] = RSEQ_MAX_PERIOD - 1;   // 最后一步之后的周期 (完成中断中停止)
+    RseqSteps++;
+    return RSEQ_ERR_NONE;
+}
+
+/****************************************************************************************
+* 函数名称：RelaySeq_Compile
+* 函数功能：时序表编译为 TIM1 周期表, 超过计数范围的间隔拆分为空操作步骤
+* 输入参量：无
+* 输出参量：RSEQ_ERR_xxx
+****************************************************************************************/
+static uint8_t RelaySeq_Compile(void)
+{
+    uint32_t prev = 0, gap, chunk;
+    uint8_t i, err;
+
+    RseqSteps = 0;
+    if (RseqCount == 0) return RSEQ_ERR_EMPTY;
+
+    for (i = 0; i < RseqCount; i++) {
+        const strRelaySeqEntry *e = &RseqTable[i];
+
+        if (e->Bsrr & ~RELAY_BSRR(RELAY_MASK_ALL, RELAY_MASK_ALL)) return RSEQ_ERR_MASK;
+        if (i > 0 && (e->Offset <= prev || e->Offset - prev < RSEQ_MIN_GAP_US)) return RSEQ_ERR_ORDER;
+
+        gap = (i == 0) ? e->Offset + RSEQ_LEAD_US : e->Offset - prev;
+        while (gap > RSEQ_MAX_PERIOD) {
+            // 拆分后剩余部分仍须 >= RSEQ_MIN_GAP_US
+            chunk = (gap - RSEQ_MAX_PERIOD >= RSEQ_MIN_GAP_US) ? RSEQ_MAX_PERIOD : RSEQ_MAX_PERIOD / 2;
+            err = RelaySeq_Emit(chunk, 0, i);
+            if (err) return err;
+            gap -= chunk;
+        }
+        err = RelaySeq_Emit(gap, e->Bsrr, i + 1);
+        if (err) return err;
+        prev = e->Offset;
+    }
+    return RSEQ_ERR_NONE;
+}
+
+/****************************************************************************************
+* 函数名称：RelaySeq_CheckInterlock
+* 函数功能：从当前继电器状态起逐步推演, 检查每一步后是否满足互锁组 (DMA 写 BSRR 不经过 Relay_Apply)
+* 输入参量：无
+* 输出参量：RSEQ_ERR_xxx
+****************************************************************************************/
+static uint8_t RelaySeq_CheckInterlock(void)
+{
+    uint8_t k, mask = Relay_GetMask();
+
+    for (k = 0; k < RseqSteps; k++) {
+        mask = (uint8_t)((mask & ~(RseqBsrr[k] >> 16)) | RseqBsrr[k]);
+        if (Relay_CheckInterlock(mask) != RELAY_OK) return RSEQ_ERR_INTERLOCK;
+    }
+    return RSEQ_ERR_NONE;
+}
+
+/****************************************************************************************
+* 函数名称：RelaySeq_Halt
+* 函数功能：停止 TIM1 与 DMA, 记录耗时
+* 输入参量：state - 结束状态
+* 输出参量：无
+****************************************************************************************/
+static void RelaySeq_Halt(uint8_t state)
+{
+    uint8_t steps, k, mask = RseqStartMask;
+
+    TIM1->CR1 &= ~TIM_CR1_CEN;
+    TIM1->DIER = 0;
+    steps = RseqSteps - (uint8_t)RSEQ_DMA_BSRR->CNDTR;
+    RSEQ_DMA_BSRR->CCR = 0;
+    RSEQ_DMA_ARR->CCR = 0;
+    DMA1->IFCR = DMA_IFCR_CGIF6 | DMA_IFCR_CGIF7;
+
+    RseqElapsed = (uint32_t)((Time_Now() - RseqStartTime) / (SystemCoreClock / RSEQ_TICK_HZ));
+    RseqState = state;
+    TRACE(RSEQ_HALT, state);
+
+    // DMA 写 BSRR 不经过继电器接口, 按步骤重放状态补计动作次数 (中间翻转不丢失)
+    // 播放期间 Relay_Apply 被拒绝, 启动状态即上次计数状态; 最后按实际输出同步, 避免步数读取偏差重复或漏计
+    for (k = 0; k < steps; k++) {
+        mask = (uint8_t)((mask & ~(RseqBsrr[k] >> 16)) | RseqBsrr[k]);
+        Relay_CountOps(mask);
+    }
+    Relay_CountOps(Relay_GetMask());
+}
+
+/****************************************************************************************
+* 函数名称：RelaySeq_Start
+* 函数功能：编译时序表并启动播放
+* 输入参量：无
+* 输出参量：RSEQ_ERR_xxx (同时记录于 ERROR 寄存器)
+****************************************************************************************/
+uint8_t RelaySeq_Start(void)
+{
+    uint8_t err;
+
+    if (RseqState == RSEQ_STATE_RUNNING || Relay_GetPending()) return RSEQ_ERR_BUSY;
+
+    err = RelaySeq_Compile();
+    if (err == RSEQ_ERR_NONE) err = RelaySeq_CheckInterlock();
+    RseqError = err;
+    if (err) {
+        RseqState = RSEQ_STATE_ERROR;
+        return err;
+    }
+
+    TIM1->CR1 &= ~TIM_CR1_CEN;
+    TIM1->DIER = 0;
+    RSEQ_DMA_BSRR->CCR = 0;
+    RSEQ_DMA_ARR->CCR = 0;
+    DMA1->IFCR = DMA_IFCR_CGIF6 | DMA_IFCR_CGIF7;
+
+    // 更新事件 -> BSRR (32 位, 完成中断)
+    RSEQ_DMA_BSRR->CPAR = (uint32_t)&GPIOA->BSRR;
+    RSEQ_DMA_BSRR->CMAR = (uint32_t)RseqBsrr;
+    RSEQ_DMA_BSRR->CNDTR = RseqSteps;
+    RSEQ_DMA_BSRR->CCR = DMA_CCR_DIR | DMA_CCR_MINC | DMA_CCR_PSIZE_1 | DMA_CCR_MSIZE_1 |
+                         DMA_CCR_PL_1 | DMA_CCR_PL_0 | DMA_CCR_TCIE;
+    // CC1 事件 -> ARR 预装载
+    RSEQ_DMA_ARR->CPAR = (uint32_t)&TIM1->ARR;
+    RSEQ_DMA_ARR->CMAR = (uint32_t)RseqArr;
+    RSEQ_DMA_ARR->CNDTR = RseqSteps;
+    RSEQ_DMA_ARR->CCR = DMA_CCR_DIR | DMA_CCR_MINC | DMA_CCR_PSIZE_1 | DMA_CCR_MSIZE_1 | DMA_CCR_PL_1;
+
+    // 第 0 个周期: UG 装载 ARR 影子寄存器 (URS = 1 不产生 DMA 请求)
+    TIM1->ARR = RseqFirstArr;
+    TIM1->CNT = 0;
+    TIM1->EGR = TIM_EGR_UG;
+    TIM1->SR = 0;
+
+    RSEQ_DMA_BSRR->CCR |= DMA_CCR_EN;
+    RSEQ_DMA_ARR->CCR |= DMA_CCR_EN;
+    TIM1->DIER = TIM_DIER_UDE | TIM_DIER_CC1DE;
+
+    RseqElapsed = 0;
+    RseqStartMask = Relay_GetMask();
+    RseqState = RSEQ_STATE_RUNNING;
+    RseqStartTick = HAL_GetTick();
+    RseqStartTime = Time_Now();
+    TRACE(RSEQ_START, RseqSteps);
+    TIM1->CR1 |= TIM_CR1_CEN;
+    return RSEQ_ERR_NONE;
+}
+
+/****************************************************************************************
+* 函数名称：RelaySeq_Stop
+* 函数功能：中止播放 (继电器保持当前状态)
+* 输入参量：无
+* 输出参量：无
+****************************************************************************************/
+void RelaySeq_Stop(void)
+{
+    // 主循环中调用时须与完成中断互斥
+    uint32_t lock = Irq_Lock(IRQ_PRIO_RELAY);
+
+    if (RseqState == RSEQ_STATE_RUNNING) RelaySeq_Halt(RSEQ_STATE_ABORTED);
+    Irq_Unlock(lock);
+}
+
+/****************************************************************************************
+* 函数名称：RelaySeq_DmaHandler
+* 函数功能：最后一个 BSRR 字写入完成 (在 DMA1_Channel6 中断中调用)
+* 输入参量：无
+* 输出参量：无
+****************************************************************************************/
+void RelaySeq_DmaHandler(void)
+{
+    if (DMA1->ISR & DMA_ISR_TCIF6) {
+        RelaySeq_Halt(RSEQ_STATE_DONE);
+    }
+    DMA1->IFCR = DMA_IFCR_CGIF6;
+}
+
+/****************************************************************************************
+* 函数名称：RelaySeq_GetState / RelaySeq_IsRunning / RelaySeq_GetDone / RelaySeq_GetElapsed
+* 函数功能：读取运行状态 / 是否正在播放 / 已执行条目数 / 实际耗时 (us, 播放中为当前已用时间)
+* 输入参量：无
+* 输出参量：见函数功能
+****************************************************************************************/
+uint8_t RelaySeq_GetState(void)
+{
+    return RseqState;
+}
+
+uint8_t RelaySeq_IsRunning(void)
+{
+    return RseqState == RSEQ_STATE_RUNNING;
+}
+
+uint8_t RelaySeq_GetDone(void)
+{
+    uint8_t steps;
+
+    if (RseqState == RSEQ_STATE_IDLE || RseqState == RSEQ_STATE_ERROR) return 0;
+    steps = RseqSteps - (uint8_t)RSEQ_DMA_BSRR->CNDTR;
+    if (RseqState == RSEQ_STATE_DONE) steps = RseqSteps;
+    return (steps == 0) ? 0 : RseqDone[steps - 1];
+}
+
+uint32_t RelaySeq_GetElapsed(void)
+{
+    if (RseqState == RSEQ_STATE_RUNNING) return (uint32_t)((Time_Now() - RseqStartTime) / (SystemCoreClock / RSEQ_TICK_HZ));
+    return RseqElapsed;
+}
+
+/****************************************************************************************
+* 函数名称：RelaySeq_ModbusRead
+* 函数功能：Modbus 03 读时序引擎寄存器, 按大端写入应答数据区
+* 输入参量：addr - 起始寄存器地址, count - 寄存器数量, dst - 应答数据区
+* 输出参量：0 = 成功, 其余为 Modbus 异常码
+****************************************************************************************/
+uint8_t RelaySeq_ModbusRead(uint16_t addr, uint16_t count, volatile uint8_t *dst)
+{
+    uint16_t i, word;
+
+    if (addr < RSEQ_MODBUS_BASE || addr + count > RSEQ_MODBUS_END) return 0x02;
+    if (count == 0 || count > 120) return 0x03;     // 应答须在 USART1 发送缓冲区内
+
+    for (i = 0; i < count; i++) {
+        uint16_t reg = addr - RSEQ_MODBUS_BASE + i;
+
+        switch (reg) {
+            case RSEQ_REG_CTRL:         word = RseqState; break;
+            case RSEQ_REG_COUNT:        word = RseqCount; break;
+            case RSEQ_REG_DONE:         word = RelaySeq_GetDone(); break;
+            case RSEQ_REG_ERROR:        word = RseqError; break;
+            case RSEQ_REG_START:        word = (uint16_t)(RseqStartTick >> 16); break;
+            case RSEQ_REG_START + 1:    word = (uint16_t)RseqStartTick; break;
+            case RSEQ_REG_ELAPSED:      word = (uint16_t)(RelaySeq_GetElapsed() >> 16); break;
+            case RSEQ_REG_ELAPSED + 1:  word = (uint16_t)RelaySeq_GetElapsed(); break;
+            default:
+                if (reg >= RSEQ_REG_TABLE) {
+                    const strRelaySeqEntry *e = &RseqTable[(reg - RSEQ_REG_TABLE) >> 2];
+                    uint32_t val = ((reg - RSEQ_REG_TABLE) & 2) ? e->Bsrr : e->Offset;
+                    word = (reg & 1) ? (uint16_t)val : (uint16_t)(val >> 16);
+                } else {
+                    word = 0;
+                }
+                break;
+        }
+        dst[i * 2] = (uint8_t)(word >> 8);
+        dst[i * 2 + 1] = (uint8_t)(word & 0xFF);
+    }
+    return 0;
+}
+
+/****************************************************************************************
+* 函数名称：RelaySeq_ModbusWrite
+* 函数功能：Modbus 06/10 写时序引擎寄存器: 先写条目数与时序表, 最后执行 CTRL (可在同一帧中启动)
+*           播放期间只接受 CTRL = 0 (停止)
+* 输入参量：addr - 起始寄存器地址, count - 寄存器数量, src - 寄存器数据
+* 输出参量：0 = 成功, 其余为 Modbus 异常码
+****************************************************************************************/
+uint8_t RelaySeq_ModbusWrite(uint16_t addr, uint16_t count, const volatile uint16_t *src)
+{
+    uint16_t i, reg;
+    int32_t ctrl = -1;
+
+    if (addr < RSEQ_MODBUS_BASE || addr + count > RSEQ_MODBUS_END) return 0x02;
+
+    // 先整体检查, 不合法时不做任何修改
+    for (i = 0; i < count; i++) {
+        reg = addr - RSEQ_MODBUS_BASE + i;
+        if (reg == RSEQ_REG_CTRL) {
+            if (src[i] > 1) return 0x03;
+        } else if (reg == RSEQ_REG_COUNT) {
+            if (src[i] > RSEQ_MAX_ENTRIES) return 0x03;
+        } else if (reg < RSEQ_REG_TABLE) {
+            return 0x02;                                // 只读寄存器
+        }
+        if (RseqState == RSEQ_STATE_RUNNING && !(reg == RSEQ_REG_CTRL && src[i] == 0)) return 0x06;
+    }
+
+    for (i = 0; i < count; i++) {
+        reg = addr - RSEQ_MODBUS_BASE + i;
+        if (reg == RSEQ_REG_CTRL) {
+            ctrl = src[i];
+        } else if (reg == RSEQ_REG_COUNT) {
+            RseqCount = (uint8_t)src[i];
+        } else {
+            strRelaySeqEntry *e = &RseqTable[(reg - RSEQ_REG_TABLE) >> 2];
+            uint32_t *val = ((reg - RSEQ_REG_TABLE) & 2) ? &e->Bsrr : &e->Offset;
+            if (reg & 1) *val = (*val & 0xFFFF0000U) | src[i];
+            else *val = (*val & 0x0000FFFFU) | ((uint32_t)src[i] << 16);
+        }
+    }
+
+    if (ctrl == 0) RelaySeq_Stop();
+    else if (ctrl == 1 && RelaySeq_Start() != RSEQ_ERR_NONE) return 0x03;  // 时序表不合法, 见 ERROR 寄存器
+    return 0;
+}
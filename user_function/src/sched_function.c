@@ -0,0 +1,296 @@
+/****************************************************************************************
+  * @file      sched_function.c
+  * @brief     协作式运行至完成调度器 (中断投递, 主循环按优先级执行, 空闲 WFI)
+  * ****************************************************************************************/
+#include "sched_function.h"
+#include "uart_config.h"
+#include "modbus_function.h"
+#include "modbus_master.h"
+#include "command_function.h"
+#include "stream_function.h"
+#include "DigitalTube_Control.h"
+#include "relay_control.h"
+#include "perf_function.h"
+#include "trace_function.h"
+
+/* 任务表 */
+typedef struct {
+    const char *Name;
+    void (*Func)(void);
+    uint16_t Period;            // 周期投递间隔 (ms), 0 = 仅由中断投递
+} strSchedTask;
+
+static void Sched_TaskModbus(void);
+static void Sched_TaskCmd(void);
+static void Sched_TaskFlash(void);
+static void Sched_TaskStats(void);
+
+static const strSchedTask SchedTasks[SCHED_TASK_COUNT] = {
+    [SCHED_TASK_MODBUS]  = { "Modbus",  Sched_TaskModbus,   0                },
+    [SCHED_TASK_CMD]     = { "Cmd",     Sched_TaskCmd,      0                },
+    [SCHED_TASK_MASTER]  = { "Master",  ModBus_MasterPoll,  1                },   // 帧间静默/超时判断
+    [SCHED_TASK_KEY]     = { "Key",     DTC_KeyPoll,        0                },
+    [SCHED_TASK_STREAM]  = { "Stream",  Stream_Poll,        1                },
+    [SCHED_TASK_DISPLAY] = { "Display", DTC_DisplayPoll,    DTC_MONITOR_MS   },   // 另由 TIM6 动画/消息计时投递
+    [SCHED_TASK_BAUD]    = { "Baud",    Usart1_BaudPoll,    10               },
+    [SCHED_TASK_FLASH]   = { "Flash",   Sched_TaskFlash,    100              },   // 另由按键保存投递
+    [SCHED_TASK_STATS]   = { "Stats",   Sched_TaskStats,    SCHED_STATS_MS   },
+};
+
+/* 就绪位图: bit n = 任务 n 就绪 (LDREX/STREX 原子修改, 投递方包括编码器级中断, 不关中断) */
+static volatile uint32_t SchedReady = 0;
+static uint16_t SchedCountdown[SCHED_TASK_COUNT];   // 周期任务剩余时间 (ms, 仅 SysTick 访问)
+
+/* 统计 */
+static strSchedStat SchedStat[SCHED_TASK_COUNT];
+static uint32_t SchedWinTick = 0;                   // 当前窗口起始时刻 (ms)
+static uint16_t SchedLoad = 0;                      // 上一窗口全部任务 CPU 占用 (0.1%)
+
+/* CPU 占用 (含中断): 按空闲 (WFI 休眠) 时间计算 */
+static uint32_t SchedIdleCycles = 0;                // 当前窗口累计空闲 (CPU 周期, 仅主循环访问)
+static uint16_t SchedCpuHist[SCHED_CPU_LONG_WINS];  // 最近各窗口 CPU 占用 (0.1%)
+static uint8_t SchedCpuIdx = 0;
+static uint8_t SchedCpuWins = 0;                    // 已填充窗口数
+static uint16_t SchedCpuLoad = 0;                   // 上一窗口 (1s)
+static uint16_t SchedCpuLoadLong = 0;               // 最近 SCHED_CPU_LONG_WINS 个窗口平均 (10s)
+
+/* 栈区 (启动文件 STACK 段, 起止地址由链接器提供) */
+extern uint32_t STACK$$Base;
+extern uint32_t STACK$$Limit;
+#define SCHED_STACK_BASE    (&STACK$$Base)
+#define SCHED_STACK_LIMIT   (&STACK$$Limit)
+#define SCHED_STACK_PAINT   0xC5C5C5C5U         // 未使用栈的填充值
+static uint16_t SchedStackUsed = 0;                 // 栈使用高水位 (字节)
+
+// 就绪位图原子置位/清除 (被中断打断时 STREX 失败重试)
+static void Sched_SetReady(uint32_t bits)
+{
+    do {
+    } while (__STREXW(__LDREXW(&SchedReady) | bits, &SchedReady));
+}
+
+static void Sched_ClearReady(uint32_t bits)
+{
+    do {
+    } while (__STREXW(__LDREXW(&SchedReady) & ~bits, &SchedReady));
+}
+
+// 空闲计时: WFI 休眠期间 CYCCNT 停止, 按 SysTick (休眠中继续计数) 换算为 CPU 周期, 关中断时调用
+// SysTick 中断挂起 (计数已重装但 uwTick 未更新) 时补一个节拍
+static uint32_t Sched_IdleClock(void)
+{
+    uint32_t load = SysTick->LOAD + 1;
+    uint32_t pend = (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) ? 1 : 0;
+    uint32_t val = SysTick->VAL;
+
+    if (!pend && (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk)) {
+        pend = 1;
+        val = SysTick->VAL;             // 两次读取之间发生重装, 以重装后的计数为准
+    }
+    return (HAL_GetTick() + pend) * load + (load - 1 - val);
+}
+
+/****************************************************************************************
+* 函数名称：Sched_StackPaint
+* 函数功能：以填充值涂写栈区未使用部分 (main 入口处调用, 此时尚未开启中断)
+*           统计任务每个窗口从栈底向上查找第一个被改写的字, 得到使用高水位
+* 输入参量：无
+* 输出参量：无
+****************************************************************************************/
+void Sched_StackPaint(void)
+{
+    uint32_t *p = SCHED_STACK_BASE;
+    uint32_t *sp = (uint32_t *)__get_MSP() - 8;     // 保留当前栈顶以下 32 字节
+
+    while (p < sp) *p++ = SCHED_STACK_PAINT;
+}
+
+/****************************************************************************************
+* 函数名称：Sched_Post
+* 函数功能：投递任务 (中断或任务中调用, 重复投递在执行前合并为一次)
+* 输入参量：id - 任务编号
+* 输出参量：无
+****************************************************************************************/
+void Sched_Post(SchedTaskId id)
+{
+    Sched_SetReady(1UL << id);
+}
+
+/****************************************************************************************
+* 函数名称：Sched_Tick
+* 函数功能：按任务表周期投递周期任务 (在 SysTick 中断中每 1ms 调用)
+* 输入参量：无
+* 输出参量：无
+****************************************************************************************/
+void Sched_Tick(void)
+{
+    uint32_t post = 0;
+    uint8_t i;
+
+    for (i = 0; i < SCHED_TASK_COUNT; i++) {
+        if (SchedTasks[i].Period == 0) continue;
+        if (SchedCountdown[i] <= 1) {
+            SchedCountdown[i] = SchedTasks[i].Period;
+            post |= 1UL << i;
+        } else {
+            SchedCountdown[i]--;
+        }
+    }
+    if (post) Sched_SetReady(post);
+}
+
+/****************************************************************************************
+* 函数名称：Sched_Run
+* 函数功能：调度主循环 (不返回): 取最高优先级就绪任务执行至完成, 无就绪任务时 WFI 休眠
+*           关中断后检查就绪位图再 WFI, 检查与休眠之间到达的中断会立即唤醒 (挂起后 WFI 不进入休眠)
+*           休眠判断必须使用 PRIMASK (BASEPRI 屏蔽的中断不能唤醒 WFI), 关中断区间只有几条指令
+* 输入参量：无
+* 输出参量：无
+****************************************************************************************/
+void Sched_Run(void)
+{
+    uint32_t ready, id, t0, cyc;
+
+    SchedWinTick = HAL_GetTick();
+    for (;;) {
+        __disable_irq();
+        ready = SchedReady;
+        if (ready == 0) {
+            // 空闲钩子: 休眠至下一个中断, 开中断后先执行挂起的中断; 休眠时间计入空闲
+            t0 = Sched_IdleClock();
+            __DSB();
+            __WFI();
+            SchedIdleCycles += Sched_IdleClock() - t0;
+            __enable_irq();
+            continue;
+        }
+        __enable_irq();
+        id = __CLZ(__RBIT(ready));
+        Sched_ClearReady(1UL << id);
+
+        // 耗时包含任务执行期间的中断处理时间
+        TRACE(TASK_BEGIN, id);
+        t0 = DWT->CYCCNT;
+        SchedTasks[id].Func();
+        cyc = DWT->CYCCNT - t0;
+        TRACE(TASK_END, id);
+
+        SchedStat[id].Runs++;
+        SchedStat[id].WinCycles += cyc;
+        if (cyc > SchedStat[id].MaxCycles) SchedStat[id].MaxCycles = cyc;
+    }
+}
+
+/****************************************************************************************
+* 函数名称：Sched_GetName / Sched_GetStat / Sched_GetLoad
+* 函数功能：读取任务名 / 任务统计 / 上一窗口全部任务 CPU 占用 (0.1%)
+* 输入参量：id - 任务编号
+* 输出参量：见函数功能 (编号越界返回 0)
+****************************************************************************************/
+const char *Sched_GetName(SchedTaskId id)
+{
+    return (id < SCHED_TASK_COUNT) ? SchedTasks[id].Name : 0;
+}
+
+const strSchedStat *Sched_GetStat(SchedTaskId id)
+{
+    return (id < SCHED_TASK_COUNT) ? &SchedStat[id] : 0;
+}
+
+uint16_t Sched_GetLoad(void)
+{
+    return SchedLoad;
+}
+
+/****************************************************************************************
+* 函数名称：Sched_GetCpuLoad / Sched_GetCpuLoadLong / Sched_GetStackUsed / Sched_GetStackSize
+* 函数功能：读取 CPU 占用 (含中断, 0.1%, 上一窗口 / 最近 10 个窗口平均) / 栈使用高水位 / 栈区大小 (字节)
+* 输入参量：无
+* 输出参量：见函数功能
+****************************************************************************************/
+uint16_t Sched_GetCpuLoad(void)
+{
+    return SchedCpuLoad;
+}
+
+uint16_t Sched_GetCpuLoadLong(void)
+{
+    return SchedCpuLoadLong;
+}
+
+uint16_t Sched_GetStackUsed(void)
+{
+    return SchedStackUsed;
+}
+
+uint16_t Sched_GetStackSize(void)
+{
+    return (uint16_t)((uint32_t)SCHED_STACK_LIMIT - (uint32_t)SCHED_STACK_BASE);
+}
+
+// ================= 任务函数 =================
+
+// Modbus 从站: 空闲中断已关闭接收并保存帧长, 应答发送完成后重新打开接收
+static void Sched_TaskModbus(void)
+{
+    PERF_BEGIN(MODBUS_RX);
+
+    Usart1.DataCnt = Usart1.FrameLen;
+    ModBus_SlaveRx();
+    PERF_END(MODBUS_RX);
+}
+
+// 文本命令
+static void Sched_TaskCmd(void)
+{
+    if (Usart1.StringFlag) {
+        PERF_BEGIN(CMD);
+
+        Usart1.StringFlag = 0;
+        Usart1_SendStringHandler();
+        PERF_END(CMD);
+    }
+}
+
+// Flash 延迟写入: 按键挂起的参数保存先于继电器动作计数
+static void Sched_TaskFlash(void)
+{
+    DTC_SavePoll();
+    Relay_OpsPoll();
+}
+
+// 统计窗口滚动: WFI 期间 CYCCNT 停止计数, 窗口长度按 HAL_GetTick 换算为 CPU 周期
+static void Sched_TaskStats(void)
+{
+    uint32_t now = HAL_GetTick();
+    uint32_t win = (now - SchedWinTick) * (SystemCoreClock / 1000);
+    uint32_t total = 0, idle;
+    const uint32_t *p;
+    uint8_t i;
+
+    if (win == 0) return;
+    for (i = 0; i < SCHED_TASK_COUNT; i++) {
+        SchedStat[i].Load = (uint16_t)(((uint64_t)SchedStat[i].WinCycles * 1000) / win);
+        total += SchedStat[i].Load;
+        SchedStat[i].WinCycles = 0;
+    }
+    SchedLoad = (total > 1000) ? 1000 : (uint16_t)total;
+    SchedWinTick = now;
+
+    // CPU 占用 = 1 - 空闲比例 (任务 + 中断 + 调度开销)
+    idle = (uint32_t)(((uint64_t)SchedIdleCycles * 1000) / win);
+    SchedIdleCycles = 0;
+    SchedCpuLoad = (idle >= 1000) ? 0 : (uint16_t)(1000 - idle);
+    SchedCpuHist[SchedCpuIdx] = SchedCpuLoad;
+    SchedCpuIdx = (SchedCpuIdx + 1) % SCHED_CPU_LONG_WINS;
+    if (SchedCpuWins < SCHED_CPU_LONG_WINS) SchedCpuWins++;
+    for (i = 0, total = 0; i < SchedCpuWins; i++) total += SchedCpuHist[i];
+    SchedCpuLoadLong = (uint16_t)(total / SchedCpuWins);
+
+    // Modbus 读出追踪记录后的冻结超时恢复
+    Trace_Poll();
+
+    // 栈高水位: 从栈底向上第一个被改写的字
+    for (p = SCHED_STACK_BASE; p < SCHED_STACK_LIMIT && *p == SCHED_STACK_PAINT; p++);
+    SchedStackUsed = (uint16_t)((uint32_t)SCHED_STACK_LIMIT - (uint32_t)p);
+}
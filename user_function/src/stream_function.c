@@ -0,0 +1,240 @@
+/****************************************************************************************
+  * @file      stream_function.c
+  * @brief     USART1 二进制高速流模式 (与 Modbus/字符串命令共用总线)
+  * ****************************************************************************************/
+#include "stream_function.h"
+#include "uart_config.h"
+#include "modbus_master.h"
+#include "iap_function.h"
+#include "usart.h"
+#include <string.h>
+
+#define STREAM_FRAME_OVERHEAD   9           // header(2)+type(1)+seq(2)+len(2)+crc(2)
+#define STREAM_FRAME_MAX        (STREAM_FRAME_OVERHEAD + STREAM_BATCH_SAMPLES * sizeof(strStreamSample))
+#define STREAM_TX_BUSY()        (USART1_EN_GPIO_Port->ODR & USART1_EN_Pin)
+
+/* 采样环形缓冲 (TIM6 中断写入, 主循环读出) */
+static strStreamSample   StreamRing[STREAM_RING_SIZE];
+static volatile uint16_t StreamHead = 0;
+static volatile uint16_t StreamTail = 0;
+
+static volatile uint8_t  StreamActive = 0;
+static volatile uint8_t  StreamStopReq = 0;
+static volatile uint32_t StreamKeepTick = 0;
+static uint32_t StreamPrevBaud = 0;
+static uint32_t StreamFlushTick = 0;
+static uint16_t StreamSeq = 0;
+static uint16_t StreamSinceStats = 0;
+
+/* 统计 */
+static volatile uint32_t StreamSamples = 0;
+static volatile uint32_t StreamDropped = 0;
+static uint32_t StreamBatches = 0;
+
+static uint8_t StreamFrame[STREAM_FRAME_MAX];
+
+/****************************************************************************************
+* 函数名称：Stream_PutU32
+* 函数功能：按小端写入 32 位数据
+* 输入参量：buf - 目标地址, val - 数据
+* 输出参量：无
+****************************************************************************************/
+static void Stream_PutU32(uint8_t *buf, uint32_t val)
+{
+    buf[0] = (uint8_t)(val);
+    buf[1] = (uint8_t)(val >> 8);
+    buf[2] = (uint8_t)(val >> 16);
+    buf[3] = (uint8_t)(val >> 24);
+}
+
+/****************************************************************************************
+* 函数名称：Stream_SendFrame
+* 函数功能：为 StreamFrame 中已填好的负载补全帧头/序号/CRC, 并启动 DMA 发送
+* 输入参量：type - 帧类型, len - 负载长度
+* 输出参量：无
+****************************************************************************************/
+static void Stream_SendFrame(uint8_t type, uint16_t len)
+{
+    StreamFrame[0] = STREAM_HEADER1;
+    StreamFrame[1] = STREAM_HEADER2;
+    StreamFrame[2] = type;
+    StreamFrame[3] = (uint8_t)(StreamSeq & 0xFF);
+    StreamFrame[4] = (uint8_t)(StreamSeq >> 8);
+    StreamFrame[5] = (uint8_t)(len & 0xFF);
+    StreamFrame[6] = (uint8_t)(len >> 8);
+    StreamSeq++;
+
+    uint16_t crc = IAP_CRC16_Calc(&StreamFrame[2], 5U + len);
+    StreamFrame[7 + len] = (uint8_t)(crc & 0xFF);
+    StreamFrame[8 + len] = (uint8_t)(crc >> 8);
+
+    Usart1.Tx.Data = StreamFrame;
+    Usart1.Tx.DataSize = STREAM_FRAME_OVERHEAD + len;
+    Usart1TransmitterDMA(&Usart1.Tx);
+}
+
+/****************************************************************************************
+* 函数名称：Stream_SendStats
+* 函数功能：发送一帧统计信息
+* 输入参量：无
+* 输出参量：无
+****************************************************************************************/
+static void Stream_SendStats(void)
+{
+    uint8_t *p = &StreamFrame[7];
+
+    Stream_PutU32(p + 0,  HAL_GetTick());
+    Stream_PutU32(p + 4,  StreamSamples);
+    Stream_PutU32(p + 8,  StreamDropped);
+    Stream_PutU32(p + 12, StreamBatches);
+    Stream_PutU32(p + 16, ModBus.Master.OkCount);
+    Stream_PutU32(p + 20, ModBus.Master.TimeoutCount);
+    Stream_PutU32(p + 24, ModBus.Master.ErrorCount);
+    Stream_SendFrame(STREAM_TYPE_STATS, 28);
+}
+
+/****************************************************************************************
+* 函数名称：Stream_Start
+* 函数功能：进入流模式: 以当前波特率应答 "OK" 后切换到流模式波特率
+* 输入参量：无
+* 输出参量：无
+****************************************************************************************/
+void Stream_Start(void)
+{
+    if (StreamActive) {
+        EnableUARTReceive(&huart1);
+        return;
+    }
+
+    Usart1_Print("OK\r\n");
+
+    StreamPrevBaud = huart1.Init.BaudRate;
+    Usart1_SetBaudRate(STREAM_BAUDRATE);
+
+    StreamHead = StreamTail = 0;
+    StreamSeq = 0;
+    StreamSinceStats = 0;
+    StreamSamples = StreamDropped = StreamBatches = 0;
+    StreamKeepTick = StreamFlushTick = HAL_GetTick();
+    StreamStopReq = 0;
+    StreamActive = 1;
+}
+
+/****************************************************************************************
+* 函数名称：Stream_Stop
+* 函数功能：请求退出流模式 (由 Stream_Poll 发送结束帧后恢复原波特率)
+* 输入参量：无
+* 输出参量：无
+****************************************************************************************/
+void Stream_Stop(void)
+{
+    StreamStopReq = 1;
+}
+
+/****************************************************************************************
+* 函数名称：Stream_IsActive
+* 函数功能：查询是否处于流模式
+* 输入参量：无
+* 输出参量：1 = 流模式, 0 = 普通模式
+****************************************************************************************/
+uint8_t Stream_IsActive(void)
+{
+    return StreamActive;
+}
+
+/****************************************************************************************
+* 函数名称：Stream_KeepAlive
+* 函数功能：主机在流模式下发来任意数据时刷新超时计时
+* 输入参量：无
+* 输出参量：无
+****************************************************************************************/
+void Stream_KeepAlive(void)
+{
+    StreamKeepTick = HAL_GetTick();
+}
+
+/****************************************************************************************
+* 函数名称：Stream_PushSample
+* 函数功能：写入一个采样点 (单生产者, 可在中断中调用; 缓冲满时丢弃并计数)
+* 输入参量：value - STREAM_CHANNELS 个通道数据
+* 输出参量：无
+****************************************************************************************/
+void Stream_PushSample(const int32_t *value)
+{
+    if (!StreamActive) return;
+
+    uint16_t next = (StreamHead + 1) & (STREAM_RING_SIZE - 1);
+    if (next == StreamTail) {
+        StreamDropped++;
+        return;
+    }
+    StreamRing[StreamHead].Tick = HAL_GetTick();
+    memcpy(StreamRing[StreamHead].Value, value, sizeof(StreamRing[0].Value));
+    StreamHead = next;
+    StreamSamples++;
+}
+
+/****************************************************************************************
+* 函数名称：Stream_SampleTick
+* 函数功能：1ms 采样节拍 (在 TIM6 中断中调用)
+*           通道0: 继电器状态 K1-K8, 通道1-3: 主站轮询的前 3 个仪表寄存器
+* 输入参量：无
+* 输出参量：无
+****************************************************************************************/
+void Stream_SampleTick(void)
+{
+    int32_t value[STREAM_CHANNELS];
+
+    if (!StreamActive) return;
+
+    value[0] = (int32_t)(GPIOA->ODR & 0xFF);
+    value[1] = ModBus.Master.DisplayRegisters[MODBUS_MASTER_REG_BASE + 0];
+    value[2] = ModBus.Master.DisplayRegisters[MODBUS_MASTER_REG_BASE + 1];
+    value[3] = ModBus.Master.DisplayRegisters[MODBUS_MASTER_REG_BASE + 2];
+    Stream_PushSample(value);
+}
+
+/****************************************************************************************
+* 函数名称：Stream_Poll
+* 函数功能：流模式发送调度 (在主循环中调用)
+*           每帧发送完成后总线短暂切回接收, 主机可在帧间发送 "Stream Stop" 或保活数据
+* 输入参量：无
+* 输出参量：无
+****************************************************************************************/
+void Stream_Poll(void)
+{
+    uint32_t now;
+    uint16_t avail, n, i;
+
+    if (!StreamActive || STREAM_TX_BUSY()) return;
+
+    now = HAL_GetTick();
+
+    // 命令停止或主机静默超时: 发送结束帧后恢复原波特率
+    if (StreamStopReq || (now - StreamKeepTick) >= STREAM_KEEPALIVE_MS) {
+        StreamActive = 0;
+        Stream_SendFrame(STREAM_TYPE_END, 0);
+        Usart1_SetBaudRate(StreamPrevBaud);
+        StreamStopReq = 0;
+        return;
+    }
+
+    if (StreamSinceStats >= STREAM_STATS_EVERY) {
+        StreamSinceStats = 0;
+        Stream_SendStats();
+        return;
+    }
+
+    avail = (StreamHead - StreamTail) & (STREAM_RING_SIZE - 1);
+    if (avail >= STREAM_BATCH_SAMPLES || (avail > 0 && (now - StreamFlushTick) >= STREAM_FLUSH_MS)) {
+        n = (avail > STREAM_BATCH_SAMPLES) ? STREAM_BATCH_SAMPLES : avail;
+        for (i = 0; i < n; i++) {
+            memcpy(&StreamFrame[7 + i * sizeof(strStreamSample)], &StreamRing[StreamTail], sizeof(strStreamSample));
+            StreamTail = (StreamTail + 1) & (STREAM_RING_SIZE - 1);
+        }
+        StreamFlushTick = now;
+        StreamBatches++;
+        StreamSinceStats++;
+        Stream_SendFrame(STREAM_TYPE_SAMPLES, n * sizeof(strStreamSample));
+    }
+}
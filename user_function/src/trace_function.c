@@ -0,0 +1,151 @@
+/****************************************************************************************
+  * @file      trace_function.c
+  * @brief     热路径事件追踪: 环形缓冲区管理、冻结与 Modbus 读文件记录
+  * ****************************************************************************************/
+#include "trace_function.h"
+
+strTraceRec TraceRing[TRACE_RECORDS];
+volatile uint32_t TraceHead = 0;
+volatile uint32_t TraceMask = TRACE_MASK_DEFAULT;
+
+static uint32_t TraceMaskSaved = TRACE_MASK_DEFAULT;    // 冻结期间保存的事件组掩码
+static uint8_t TraceFrozen = 0;
+static uint32_t TraceHoldTick = 0;                      // Modbus 最后一次读取时刻 (ms)
+static uint8_t TraceHold = 0;                           // 冻结由 Modbus 读出引起 (超时自动恢复)
+
+/****************************************************************************************
+* 函数名称：Trace_Freeze / Trace_Resume
+* 函数功能：冻结 (屏蔽全部事件, 缓冲区保持不变) / 恢复记录
+* 输入参量：无
+* 输出参量：无
+****************************************************************************************/
+void Trace_Freeze(void)
+{
+    if (TraceFrozen) return;
+    TraceMaskSaved = TraceMask;
+    TraceMask = 0;
+    TraceFrozen = 1;
+}
+
+void Trace_Resume(void)
+{
+    if (!TraceFrozen) return;
+    TraceHold = 0;
+    TraceFrozen = 0;
+    TraceMask = TraceMaskSaved;
+}
+
+/****************************************************************************************
+* 函数名称：Trace_Clear
+* 函数功能：清空缓冲区并恢复记录
+* 输入参量：无
+* 输出参量：无
+****************************************************************************************/
+void Trace_Clear(void)
+{
+    Trace_Freeze();
+    TraceHead = 0;
+    Trace_Resume();
+}
+
+/****************************************************************************************
+* 函数名称：Trace_SetMask / Trace_GetMask
+* 函数功能：设置 / 读取事件组掩码 (冻结期间设置的掩码在恢复后生效)
+* 输入参量：mask - bit n = 记录组 n 的事件
+* 输出参量：Trace_GetMask: 当前掩码
+****************************************************************************************/
+void Trace_SetMask(uint32_t mask)
+{
+    if (TraceFrozen) TraceMaskSaved = mask;
+    else TraceMask = mask;
+}
+
+uint32_t Trace_GetMask(void)
+{
+    return TraceFrozen ? TraceMaskSaved : TraceMask;
+}
+
+/****************************************************************************************
+* 函数名称：Trace_Count / Trace_Get
+* 函数功能：有效记录数 / 按时间顺序读取第 n 条记录 (0 = 最旧, 读出前应先冻结)
+* 输入参量：n - 记录序号, rec - 输出
+* 输出参量：Trace_Count: 有效记录数
+****************************************************************************************/
+uint16_t Trace_Count(void)
+{
+    uint32_t head = TraceHead;
+
+    return (uint16_t)((head < TRACE_RECORDS) ? head : TRACE_RECORDS);
+}
+
+void Trace_Get(uint16_t n, strTraceRec *rec)
+{
+    uint32_t head = TraceHead;
+
+    *rec = TraceRing[(head - Trace_Count() + n) & (TRACE_RECORDS - 1)];
+}
+
+/****************************************************************************************
+* 函数名称：Trace_Poll
+* 函数功能：Modbus 读出引起的冻结在最后一次读取 TRACE_HOLD_MS 后自动恢复 (统计任务中周期调用)
+* 输入参量：无
+* 输出参量：无
+****************************************************************************************/
+void Trace_Poll(void)
+{
+    if (TraceHold && (HAL_GetTick() - TraceHoldTick) >= TRACE_HOLD_MS) Trace_Resume();
+}
+
+/****************************************************************************************
+* 函数名称：Trace_ModbusReadFile
+* 函数功能：Modbus 14H 读文件记录的一个子请求, 按大端写入应答数据区
+*           读文件 1 (头) 时冻结记录, 读文件 2 不改变冻结状态, 每次读取重新开始保持计时
+* 输入参量：file - 文件号, reg - 起始寄存器 (记录号), count - 寄存器数量, dst - 应答数据区
+* 输出参量：0 = 成功, 其余为 Modbus 异常码
+****************************************************************************************/
+uint8_t Trace_ModbusReadFile(uint16_t file, uint16_t reg, uint16_t count, volatile uint8_t *dst)
+{
+    strTraceRec rec;
+    uint16_t i, word;
+
+    if (count == 0) return 0x03;
+    if (file == TRACE_FILE_HEADER) {
+        if (reg + count > TRACE_HEADER_REGS) return 0x02;
+        if (!TraceFrozen) {
+            Trace_Freeze();
+            TraceHold = 1;
+        }
+    } else if (file == TRACE_FILE_RECORDS) {
+        if (reg + count > (uint32_t)Trace_Count() * 4) return 0x02;
+    } else {
+        return 0x02;
+    }
+    TraceHoldTick = HAL_GetTick();
+
+    for (i = 0; i < count; i++) {
+        uint16_t r = reg + i;
+
+        if (file == TRACE_FILE_HEADER) {
+            switch (r) {
+                case 0:  word = Trace_Count(); break;
+                case 1:  word = TRACE_RECORDS; break;
+                case 2:  word = (uint16_t)(SystemCoreClock / 1000000); break;
+                case 3:  word = (uint16_t)TraceMaskSaved; break;
+                case 4:  word = (uint16_t)(TraceHead >> 16); break;
+                case 5:  word = (uint16_t)TraceHead; break;
+                default: word = TRACE_TIME_SHIFT; break;
+            }
+        } else {
+            if (i == 0 || (r & 3) == 0) Trace_Get(r >> 2, &rec);
+            switch (r & 3) {
+                case 0:  word = (uint16_t)(rec.Time >> 16); break;
+                case 1:  word = (uint16_t)rec.Time; break;
+                case 2:  word = rec.Id; break;
+                default: word = rec.Arg; break;
+            }
+        }
+        dst[i * 2] = (uint8_t)(word >> 8);
+        dst[i * 2 + 1] = (uint8_t)(word & 0xFF);
+    }
+    return 0;
+}